@@ -0,0 +1,721 @@
+//Non-Volatile Memory Library Microbenchmarks
+//Measures ops/s and per-op latency percentiles of the library entry points across pool sizes and prints them as JSON,
+//so runs of different versions (and of the same version over time) can be compared.
+
+//Build one binary per version from this directory:
+//  gcc -O2 -DNVMLIB_VERSION=8 -I../Version8 nvmlib_bench.c -o nvmlib8_bench -lpthread
+//  gcc -O2 -DNVMLIB_VERSION=7 -I../Version7 nvmlib_bench.c -o nvmlib7_bench
+//  gcc -O2 -DNVMLIB_VERSION=5 -I../Version5 nvmlib_bench.c -o nvmlib5_bench
+//Run:
+//  ./nvmlib8_bench [-min size] [-max size] [-ops count] [-budget ms] [-emulate read_ns,write_ns,write_mb_s,persist_ns] [-counters] > nvmlib8.json
+//Pool sizes go up by 10x from -min (default 1000) to -max (default 1000000, up to 100000000).
+//Each (entry point, pool size) pair times up to -ops calls (default 10000), stopping early once it has taken -budget ms
+//(default 1000), so entry points that walk the pool still finish at large sizes. Whole-pool file operations are timed per call.
+//Entry points a version does not have are left out of its results.
+//-emulate (Version 8) runs everything with nvm_emulate's persistent memory costs, e.g. -emulate 300,100,2000,500.
+//Version 8 also times getoid at random offsets and a scan with pread_int on an out-of-core pool (pool_create_paged)
+//with about an eighth of its pages in memory ("_paged" entry points), and pfree_range and pmalloc_range on runs of
+//BENCH_RANGE objects at random offsets (each call is undone by the other one untimed, so the pool keeps its size).
+//phash_put times the last puts of new keys into a hash map filled up to the pool size (its largest latencies show
+//whether a resize pauses a put) and phash_get times lookups of random keys of the full map. pqueue_push and pqueue_pop
+//time one thread filling and then draining a PQUEUE_SPSC queue with room for the pool size.
+//-counters adds the cycles, instructions, LLC misses, dTLB misses and branch misses of each call (user space only)
+//from the hardware counters (perf_event_open). The counters are only running during the calls, but starting and stopping
+//them takes two system calls per call, so fewer calls fit in the budget. Counters the processor or kernel does not
+//give (e.g. in most virtual machines, or with kernel.perf_event_paranoid above 2) are null in the results.
+//The library's own messages are thrown away so stdout only holds the JSON.
+
+#ifndef NVMLIB_VERSION
+#define NVMLIB_VERSION 8
+#endif
+
+#if NVMLIB_VERSION == 5
+#include "nvmlib5.c"
+#elif NVMLIB_VERSION == 7
+#include "nvmlib7.c"
+#else
+#include "nvmlib8.c"
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define BENCH_FILE_BIN "nvmlib_bench.bin"
+#define BENCH_FILE_TXT "nvmlib_bench.txt"
+#define BENCH_FILE_PAGES "nvmlib_bench.pages" //file of the out-of-core pool (Version 8)
+#define BENCH_PAGED_CACHE 8 //bytes of page cache per object of the out-of-core pool, about an eighth of its pages
+#define BENCH_RANGE 1000 //# of objects each pfree_range and pmalloc_range call moves (Version 8)
+#define BENCH_CREATE_OIDS 10000000 //# of OIDs the pool_create benchmark may create at each size
+#define BENCH_COUNTERS 5 //# of hardware counters read with -counters
+
+//For the timings of one entry point at one pool size
+typedef struct bench
+{
+	const char* op; //entry point
+	int pool_size; //# of objects in the pool
+	uint64_t* ns; //latency of each call
+	int count; //# of calls timed
+	int cap; //# of calls that may be timed
+	uint64_t start; //time the first call started
+	uint64_t budget; //ns the calls may take in all
+	uint64_t bytes; //bytes moved by each call (file operations)
+} bench;
+
+//The hardware counters, opened as one group so they count over the same calls
+typedef struct bench_counters
+{
+	int fd[BENCH_COUNTERS]; //-1 for counters that could not be opened
+	int leader; //fd of the group, -1 when no counter could be opened
+	uint64_t id[BENCH_COUNTERS];
+} bench_counters;
+
+FILE* bench_out; //where the JSON goes
+int bench_first = 1; //1 until the first result is printed
+uint64_t bench_rand = 88172645463325252ULL; //state of the offset generator
+bench_counters bench_hw = {{-1, -1, -1, -1, -1}, -1, {0}}; //-counters
+const char* bench_counter_names[BENCH_COUNTERS] = {"cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+
+//Current time in ns
+uint64_t bench_now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+//Random # in [0, n) (xorshift64)
+int bench_offset(int n)
+{
+	bench_rand ^= bench_rand << 13;
+	bench_rand ^= bench_rand >> 7;
+	bench_rand ^= bench_rand << 17;
+	return n > 0 ? (int) (bench_rand % (uint64_t) n) : 0;
+}
+
+//Open the hardware counters, returns the # that could be opened
+int bench_counters_open(void)
+{
+	uint32_t types[BENCH_COUNTERS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+	uint64_t configs[BENCH_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), PERF_COUNT_HW_BRANCH_MISSES};
+	int opened = 0;
+	int i;
+	for (i = 0; i < BENCH_COUNTERS; i++)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = types[i];
+		attr.config = configs[i];
+		attr.disabled = bench_hw.leader < 0; //the group starts and stops with its leader
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		bench_hw.fd[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, bench_hw.leader, 0);
+		if (bench_hw.fd[i] < 0)
+		{
+			continue;
+		}
+		ioctl(bench_hw.fd[i], PERF_EVENT_IOC_ID, &bench_hw.id[i]);
+		if (bench_hw.leader < 0)
+		{
+			bench_hw.leader = bench_hw.fd[i];
+		}
+		opened++;
+	}
+	return opened;
+}
+
+//Start counting for a call and return the time it starts at
+uint64_t bench_begin(void)
+{
+	if (bench_hw.leader >= 0)
+	{
+		ioctl(bench_hw.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+	return bench_now();
+}
+
+//Start timing up to cap calls of op at pool size within budget_ms
+void bench_start(bench* b, const char* op, int pool_size, int cap, int budget_ms)
+{
+	b->op = op;
+	b->pool_size = pool_size;
+	b->ns = malloc((cap > 0 ? cap : 1) * sizeof(uint64_t));
+	b->count = 0;
+	b->cap = cap;
+	b->budget = (uint64_t) budget_ms * 1000000ULL;
+	b->bytes = 0;
+	if (bench_hw.leader >= 0)
+	{
+		ioctl(bench_hw.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	}
+	b->start = bench_begin();
+}
+
+//1 while another call should be timed
+int bench_more(bench* b)
+{
+	return b->count < b->cap && (b->count == 0 || bench_now() - b->start < b->budget);
+}
+
+//Record the latency of a call that started at t (bench_begin) and stop counting
+void bench_record(bench* b, uint64_t t)
+{
+	b->ns[b->count] = bench_now() - t;
+	if (bench_hw.leader >= 0)
+	{
+		ioctl(bench_hw.leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+	b->count++;
+}
+
+//Print the counts per call since bench_start, scaled up if the kernel had to share the counters with other groups
+void bench_print_counters(const bench* b)
+{
+	uint64_t values[3 + 2 * BENCH_COUNTERS]; //nr, time_enabled, time_running, then value and id of each counter
+	if (read(bench_hw.leader, values, sizeof(values)) < (ssize_t) (3 * sizeof(uint64_t)) || values[2] == 0)
+	{
+		fprintf(bench_out, " \"counters\": null,");
+		return;
+	}
+	double scale = (double) values[1] / values[2] / b->count;
+	fprintf(bench_out, " \"counters\": {");
+	double per_call[BENCH_COUNTERS];
+	int found[BENCH_COUNTERS];
+	int i;
+	uint64_t j;
+	for (i = 0; i < BENCH_COUNTERS; i++)
+	{
+		found[i] = 0;
+		for (j = 0; j < values[0] && bench_hw.fd[i] >= 0; j++)
+		{
+			if (values[4 + 2 * j] == bench_hw.id[i])
+			{
+				per_call[i] = values[3 + 2 * j] * scale;
+				found[i] = 1;
+			}
+		}
+		if (found[i] == 1)
+		{
+			fprintf(bench_out, "\"%s\": %.1f, ", bench_counter_names[i], per_call[i]);
+		}
+		else
+		{
+			fprintf(bench_out, "\"%s\": null, ", bench_counter_names[i]);
+		}
+	}
+	if (found[0] == 1 && found[1] == 1 && per_call[0] > 0)
+	{
+		fprintf(bench_out, "\"ipc\": %.2f},", per_call[1] / per_call[0]);
+	}
+	else
+	{
+		fprintf(bench_out, "\"ipc\": null},");
+	}
+}
+
+int bench_cmp(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*) a;
+	uint64_t y = *(const uint64_t*) b;
+	return x < y ? -1 : x > y;
+}
+
+//Latency at percentile pct of sorted latencies
+uint64_t bench_pct(const bench* b, double pct)
+{
+	int i = (int) (pct / 100.0 * (b->count - 1) + 0.5);
+	return b->ns[i];
+}
+
+//Print the result of a benchmark as a JSON object and free its timings
+void bench_finish(bench* b)
+{
+	if (b->count == 0)
+	{
+		free(b->ns);
+		return;
+	}
+	uint64_t total = 0;
+	int i;
+	for (i = 0; i < b->count; i++)
+	{
+		total = total + b->ns[i];
+	}
+	qsort(b->ns, b->count, sizeof(uint64_t), bench_cmp);
+
+	fprintf(bench_out, "%s\n    {\"op\": \"%s\", \"pool_size\": %d, \"calls\": %d, \"total_ns\": %llu, \"ops_per_sec\": %.1f,",
+		bench_first == 1 ? "" : ",", b->op, b->pool_size, b->count, (unsigned long long) total,
+		total > 0 ? b->count * 1e9 / total : 0.0);
+	if (b->bytes > 0)
+	{
+		fprintf(bench_out, " \"bytes\": %llu, \"mb_per_sec\": %.1f,", (unsigned long long) b->bytes,
+			total > 0 ? b->bytes * (double) b->count * 1e3 / total : 0.0);
+	}
+	if (bench_hw.leader >= 0)
+	{
+		bench_print_counters(b);
+	}
+	fprintf(bench_out, " \"latency_ns\": {\"min\": %llu, \"mean\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}",
+		(unsigned long long) b->ns[0], (unsigned long long) (total / b->count),
+		(unsigned long long) bench_pct(b, 50), (unsigned long long) bench_pct(b, 90), (unsigned long long) bench_pct(b, 99),
+		(unsigned long long) bench_pct(b, 99.9), (unsigned long long) b->ns[b->count - 1]);
+	bench_first = 0;
+	free(b->ns);
+}
+
+//Size of a file in bytes
+uint64_t bench_file_size(const char* filename)
+{
+	FILE* f = fopen(filename, "rb");
+	if (f == NULL)
+	{
+		return 0;
+	}
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fclose(f);
+	return len > 0 ? (uint64_t) len : 0;
+}
+
+//Give the first filled OIDs of a pool an int and empty the rest, walking the pool's OID list
+void bench_fill(pool* p, int filled)
+{
+	OID * tmp = p->root;
+	int i;
+	for (i = 0; i < p->size && tmp != NULL; i++)
+	{
+		tmp->data = (int*) (intptr_t) (i < filled ? i : 0);
+		tmp->empty = i < filled ? 0 : 1;
+#if NVMLIB_VERSION >= 7
+		tmp->data_type = i < filled ? 1 : 0;
+		tmp->data_size = i < filled ? sizeof(int) : 0;
+#endif
+#if NVMLIB_VERSION >= 8
+		tmp = i + 1 < p->size ? getoid(p, i + 1) : NULL; //the list stops at OIDs not brought into memory yet
+#else
+		tmp = tmp->next;
+#endif
+	}
+}
+
+//A name no other pool has (pools keep the pointer)
+const char* bench_name(const char* op, int n)
+{
+	static int made = 0;
+	char* name = malloc(64);
+	snprintf(name, 64, "%s%d_%d", op, n, made);
+	made++;
+	return name;
+}
+
+//Time each of the write entry points on pool p, filling it up to its last calls empty OIDs
+void bench_writes(pool* p, int n, int ops, int budget_ms)
+{
+	int calls = ops < n ? ops : n;
+	bench b;
+	uint64_t t;
+
+	bench_fill(p, n - calls);
+#if NVMLIB_VERSION == 5
+	bench_start(&b, "pwritef", n, calls, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pwritef(p, b.count);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#else
+	bench_start(&b, "pwriteint", n, calls, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pwriteint(p, b.count);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	bench_fill(p, n - calls);
+	bench_start(&b, "pwritechar", n, calls, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pwritechar(p, 'a' + b.count % 26);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	bench_fill(p, n - calls);
+	bench_start(&b, "pwritestr", n, calls / 16, budget_ms); //16 chars take 16 OIDs
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pwritestr(p, "abcdefghijklmnop");
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#endif
+
+#if NVMLIB_VERSION >= 8
+	bench_fill(p, n - calls);
+	bench_start(&b, "pwriteptr", n, calls, budget_ms);
+	while (bench_more(&b))
+	{
+		OID * target = p->root;
+		t = bench_begin();
+		pwriteptr(p, target);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	char blob[64];
+	memset(blob, 'b', sizeof(blob));
+	bench_fill(p, n - calls);
+	bench_start(&b, "pwrite_blob", n, calls, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pwrite_blob(p, blob, sizeof(blob));
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#endif
+}
+
+//Time the file entry points on pool p, a full pool of n ints
+void bench_files(pool* p, int n, int ops, int budget_ms)
+{
+	bench b;
+	uint64_t t;
+
+	bench_fill(p, n);
+	bench_start(&b, "pfileout", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pfileout(p, BENCH_FILE_BIN);
+		bench_record(&b, t);
+	}
+	b.bytes = bench_file_size(BENCH_FILE_BIN);
+	bench_finish(&b);
+
+	bench_start(&b, "pfilein", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		bench_fill(p, 0);
+		t = bench_begin();
+		pfilein(p, BENCH_FILE_BIN);
+		bench_record(&b, t);
+	}
+	b.bytes = bench_file_size(BENCH_FILE_BIN);
+	bench_finish(&b);
+	remove(BENCH_FILE_BIN);
+
+#if NVMLIB_VERSION >= 7
+	bench_fill(p, n);
+	bench_start(&b, "pfileouttxt", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pfileouttxt(p, BENCH_FILE_TXT);
+		bench_record(&b, t);
+	}
+	b.bytes = bench_file_size(BENCH_FILE_TXT);
+	bench_finish(&b);
+
+	bench_start(&b, "pfileintxt", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		bench_fill(p, 0);
+		t = bench_begin();
+		pfileintxt(p, BENCH_FILE_TXT);
+		bench_record(&b, t);
+	}
+	b.bytes = bench_file_size(BENCH_FILE_TXT);
+	bench_finish(&b);
+	remove(BENCH_FILE_TXT);
+#endif
+}
+
+//Time every entry point at pool size n
+void bench_size(int n, int ops, int budget_ms)
+{
+	bench b;
+	uint64_t t;
+
+	int creates = BENCH_CREATE_OIDS / n > ops ? ops : BENCH_CREATE_OIDS / n;
+	bench_start(&b, "pool_create", n, creates > 0 ? creates : 1, budget_ms);
+	while (bench_more(&b))
+	{
+		const char* name = bench_name("create", n);
+		t = bench_begin();
+		pool_create(name, n); //pools are kept: older versions free them on pool_close but leave them in the list of pools
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+#if NVMLIB_VERSION >= 8
+	bench_start(&b, "pool_destroy", n, creates > 0 ? creates : 1, budget_ms);
+	while (bench_more(&b))
+	{
+		pool* q = pool_create(bench_name("destroy", n), n);
+		bench_fill(q, n); //brings every OID into memory
+		t = bench_begin();
+		pool_destroy(q);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#endif
+
+	pool* p = pool_create(bench_name("bench", n), n);
+	bench_fill(p, n);
+
+#if NVMLIB_VERSION >= 8
+	bench_start(&b, "pool_open", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		pool_close(p);
+		t = bench_begin();
+		pool_open(p->name);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#endif
+
+	bench_start(&b, "getoid", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		int offset = bench_offset(n);
+		t = bench_begin();
+		getoid(p, offset);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	bench_writes(p, n, ops, budget_ms);
+	bench_files(p, n, ops, budget_ms);
+
+#if NVMLIB_VERSION >= 8
+	bench_start(&b, "pool_persist", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pool_persist(p);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+#endif
+
+	bench_start(&b, "pmalloc", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pmalloc(p, 1);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	int frees = p->size - 1 < ops ? p->size - 1 : ops; //the root OID stays
+	bench_start(&b, "pfree", n, frees, budget_ms);
+	while (bench_more(&b))
+	{
+		OID * tmp = getoid(p, 1 + bench_offset(p->size - 1));
+		t = bench_begin();
+		pfree(tmp);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+#if NVMLIB_VERSION >= 8
+	if (p->size > BENCH_RANGE)
+	{
+		bench_start(&b, "pfree_range", n, ops, budget_ms);
+		while (bench_more(&b))
+		{
+			int offset = bench_offset(p->size - BENCH_RANGE);
+			t = bench_begin();
+			pfree_range(p, offset, BENCH_RANGE);
+			bench_record(&b, t);
+			pmalloc_range(p, offset, BENCH_RANGE);
+		}
+		bench_finish(&b);
+
+		bench_start(&b, "pmalloc_range", n, ops, budget_ms);
+		while (bench_more(&b))
+		{
+			int offset = bench_offset(p->size);
+			t = bench_begin();
+			pmalloc_range(p, offset, BENCH_RANGE);
+			bench_record(&b, t);
+			pfree_range(p, offset, BENCH_RANGE);
+		}
+		bench_finish(&b);
+	}
+
+	pool* h = pool_create(bench_name("hash", n), 1);
+	OID* m = phash_create(h, sizeof(int64_t), sizeof(int64_t), 0);
+	int64_t key;
+	for (key = 0; key < n - ops; key++) //only the last puts are timed
+	{
+		phash_put(m, &key, &key);
+	}
+	bench_start(&b, "phash_put", n, ops < n ? ops : n, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		phash_put(m, &key, &key);
+		bench_record(&b, t);
+		key++;
+	}
+	bench_finish(&b);
+	for (; key < n; key++) //keys left when the budget ran out
+	{
+		phash_put(m, &key, &key);
+	}
+
+	bench_start(&b, "phash_get", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		key = bench_offset(n);
+		t = bench_begin();
+		phash_get(m, &key);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+	pool_destroy(h);
+
+	pool* fifo = pool_create(bench_name("queue", n), 1);
+	OID* f = pqueue_create(fifo, PQUEUE_SPSC, sizeof(int64_t), n);
+	bench_start(&b, "pqueue_push", n, ops < n ? ops : n, budget_ms);
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pqueue_push(f, &key);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	bench_start(&b, "pqueue_pop", n, (int) pqueue_count(f), budget_ms); //pops what the pushes left
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pqueue_pop(f, &key);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+	pool_destroy(fifo);
+
+	pool* q = pool_create_paged(bench_name("paged", n), BENCH_FILE_PAGES, n, (int64_t) n * BENCH_PAGED_CACHE);
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		pwriteint(q, i);
+	}
+
+	bench_start(&b, "getoid_paged", n, ops, budget_ms);
+	while (bench_more(&b))
+	{
+		int offset = bench_offset(n);
+		t = bench_begin();
+		getoid(q, offset);
+		bench_record(&b, t);
+	}
+	bench_finish(&b);
+
+	bench_start(&b, "pread_int_paged_scan", n, ops, budget_ms);
+	i = 0;
+	while (bench_more(&b))
+	{
+		t = bench_begin();
+		pread_int(q, i);
+		bench_record(&b, t);
+		i = i + 1 < n ? i + 1 : 0;
+	}
+	bench_finish(&b);
+	pool_destroy(q); //removes its file
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	int min = 1000;
+	int max = 1000000;
+	int ops = 10000;
+	int budget_ms = 1000;
+	unsigned long long emulate[4] = {0, 0, 0, 0};
+	int counters = 0;
+	int i;
+	for (i = 1; i < argc; i = i + 2)
+	{
+		if (strcmp(argv[i], "-counters") == 0)
+		{
+			counters = 1;
+			i--; //takes no value
+		}
+		else if (i + 1 >= argc)
+		{
+			break;
+		}
+		else if (strcmp(argv[i], "-min") == 0)
+		{
+			min = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-max") == 0)
+		{
+			max = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-ops") == 0)
+		{
+			ops = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-budget") == 0)
+		{
+			budget_ms = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-emulate") == 0)
+		{
+			sscanf(argv[i + 1], "%llu,%llu,%llu,%llu", &emulate[0], &emulate[1], &emulate[2], &emulate[3]);
+		}
+	}
+	if (min < 1 || max < min || ops < 1 || budget_ms < 1)
+	{
+		fprintf(stderr, "usage: %s [-min size] [-max size] [-ops count] [-budget ms] [-emulate read_ns,write_ns,write_mb_s,persist_ns] [-counters]\n", argv[0]);
+		return 1;
+	}
+
+	fflush(stdout); //the library prints to stdout, so the JSON goes to a copy of it
+	bench_out = fdopen(dup(fileno(stdout)), "w");
+	if (bench_out == NULL || freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not set up output!\n");
+		return 1;
+	}
+
+#if NVMLIB_VERSION >= 8
+	nvm_emulation e = {emulate[0], emulate[1], emulate[2] * 1000000ULL, emulate[3]};
+	nvm_emulate(&e);
+#endif
+	if (counters == 1 && bench_counters_open() == 0)
+	{
+		fprintf(stderr, "Hardware counters are not available, timing without them\n");
+	}
+	fprintf(bench_out, "{\n  \"library\": \"nvmlib%d\",\n  \"version\": %d,\n  \"ops\": %d,\n  \"budget_ms\": %d,\n", NVMLIB_VERSION, NVMLIB_VERSION, ops, budget_ms);
+	fprintf(bench_out, "  \"counters\": \"%s\",\n", counters == 0 ? "off" : bench_hw.leader >= 0 ? "on" : "unavailable");
+	fprintf(bench_out, "  \"emulation\": {\"read_ns\": %llu, \"write_ns\": %llu, \"write_mb_s\": %llu, \"persist_ns\": %llu},\n  \"results\": [",
+		emulate[0], emulate[1], emulate[2], emulate[3]);
+	long long n;
+	for (n = min; n <= max; n = n * 10)
+	{
+		fprintf(stderr, "pool size %lld...\n", n);
+		bench_size((int) n, ops, budget_ms);
+		fflush(bench_out);
+	}
+	fprintf(bench_out, "\n  ]\n}\n");
+	fclose(bench_out);
+	return 0;
+}
@@ -0,0 +1,163 @@
+//Non-Volatile Memory Library POLB Simulator
+//Replays a trace recorded with pool_trace_start and feeds its OID lookups to simulated POLBs of every size, associativity
+//and replacement policy asked for, printing their hit rates and estimated cycles per lookup as JSON.
+
+//Build from this directory:
+//  gcc -O2 -I../Version8 nvmlib_polb.c -o nvmlib_polb -lpthread
+//Run:
+//  ./nvmlib_polb trace_file [-entries 8,16,32,64] [-ways 1,2,4,0] [-policy lru,fifo,random] [-granule 40]
+//                [-table 1024] [-hit 1] [-walk 30] [-probe 4] > polb.json
+//-ways 0 is fully associative. -granule is log2 of the # of objects one translation covers (40 translates whole pools,
+//like the paper's pool-granularity POLB). -table is the # of slots of the pool table; a miss costs -walk cycles plus -probe
+//cycles for each pool table slot looked at. The default cycle costs are placeholders to be set for the hardware modeled.
+//The library's own messages are thrown away so stdout only holds the JSON.
+
+#include "nvmlib8.c"
+
+#define POLB_MAX_VALUES 32
+
+//Parse a comma separated list of ints into values, returns the # of values
+int polb_list(const char* arg, int* values)
+{
+	int n = 0;
+	while (n < POLB_MAX_VALUES && *arg != '\0')
+	{
+		values[n] = atoi(arg);
+		n++;
+		while (*arg != '\0' && *arg != ',')
+		{
+			arg++;
+		}
+		if (*arg == ',')
+		{
+			arg++;
+		}
+	}
+	return n;
+}
+
+int main(int argc, char** argv)
+{
+	int entries[POLB_MAX_VALUES] = {8, 16, 32, 64};
+	int entry_count = 4;
+	int ways[POLB_MAX_VALUES] = {1, 2, 4, 0};
+	int way_count = 4;
+	int policies[3] = {POLB_LRU, POLB_FIFO, POLB_RANDOM};
+	int policy_count = 3;
+	const char* policy_names[3] = {"lru", "fifo", "random"};
+	polb_config base = {0, 0, 0, 40, 1024, 1, 30, 4};
+	int i;
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s trace_file [-entries n,...] [-ways n,...] [-policy lru,fifo,random] [-granule shift] "
+			"[-table slots] [-hit cycles] [-walk cycles] [-probe cycles]\n", argv[0]);
+		return 1;
+	}
+	for (i = 2; i + 1 < argc; i = i + 2)
+	{
+		if (strcmp(argv[i], "-entries") == 0)
+		{
+			entry_count = polb_list(argv[i + 1], entries);
+		}
+		else if (strcmp(argv[i], "-ways") == 0)
+		{
+			way_count = polb_list(argv[i + 1], ways);
+		}
+		else if (strcmp(argv[i], "-policy") == 0)
+		{
+			policy_count = 0;
+			int k;
+			for (k = 0; k < 3; k++)
+			{
+				if (strstr(argv[i + 1], policy_names[k]) != NULL)
+				{
+					policies[policy_count] = k;
+					policy_count++;
+				}
+			}
+		}
+		else if (strcmp(argv[i], "-granule") == 0)
+		{
+			base.granule_shift = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-table") == 0)
+		{
+			base.table_entries = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-hit") == 0)
+		{
+			base.hit_cycles = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-walk") == 0)
+		{
+			base.walk_cycles = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-probe") == 0)
+		{
+			base.probe_cycles = atoi(argv[i + 1]);
+		}
+	}
+
+	polb_sim** sims = malloc(entry_count * way_count * policy_count * sizeof(polb_sim*));
+	int count = 0;
+	int e;
+	int w;
+	int k;
+	for (e = 0; e < entry_count; e++)
+	{
+		for (w = 0; w < way_count; w++)
+		{
+			for (k = 0; k < policy_count; k++)
+			{
+				polb_config c = base;
+				c.entries = entries[e];
+				c.ways = ways[w] == 0 || ways[w] > entries[e] ? entries[e] : ways[w];
+				c.policy = policies[k];
+				polb_sim* s = polb_sim_create(&c);
+				if (s == NULL)
+				{
+					fprintf(stderr, "ERROR: Bad POLB configuration: %d entries, %d ways!\n", c.entries, c.ways);
+					return 1;
+				}
+				sims[count] = s;
+				count++;
+			}
+		}
+	}
+
+	fflush(stdout); //the library prints to stdout, so the JSON goes to a copy of it
+	FILE* out = fdopen(dup(fileno(stdout)), "w");
+	if (out == NULL || freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not set up output!\n");
+		return 1;
+	}
+
+	polb_attach(sims, count);
+	int64_t calls = pool_trace_replay(argv[1], 1); //one thread keeps the lookup stream in trace order
+	polb_attach(NULL, 0);
+	if (calls < 0)
+	{
+		fprintf(stderr, "ERROR: Could not replay trace %s!\n", argv[1]);
+		return 1;
+	}
+
+	fprintf(out, "{\n  \"trace\": \"%s\",\n  \"calls\": %lld,\n  \"granule_shift\": %d,\n  \"table_entries\": %d,\n", argv[1],
+		(long long) calls, base.granule_shift, base.table_entries);
+	fprintf(out, "  \"hit_cycles\": %u,\n  \"walk_cycles\": %u,\n  \"probe_cycles\": %u,\n  \"results\": [", base.hit_cycles,
+		base.walk_cycles, base.probe_cycles);
+	for (i = 0; i < count; i++)
+	{
+		polb_result r = polb_sim_result(sims[i]);
+		fprintf(out, "%s\n    {\"entries\": %d, \"ways\": %d, \"policy\": \"%s\", \"accesses\": %llu, \"hits\": %llu, \"misses\": %llu, "
+			"\"evictions\": %llu, \"probes\": %llu, \"hit_rate\": %.4f, \"cycles_per_access\": %.2f}", i == 0 ? "" : ",",
+			sims[i]->config.entries, sims[i]->config.ways, policy_names[sims[i]->config.policy], (unsigned long long) r.accesses,
+			(unsigned long long) r.hits, (unsigned long long) r.misses, (unsigned long long) r.evictions,
+			(unsigned long long) r.probes, r.hit_rate, r.cycles_per_access);
+		polb_sim_free(sims[i]);
+	}
+	fprintf(out, "\n  ]\n}\n");
+	fclose(out);
+	free(sims);
+	return 0;
+}
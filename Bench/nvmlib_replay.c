@@ -0,0 +1,61 @@
+//Non-Volatile Memory Library Trace Replay
+//Runs a trace recorded with pool_trace_start again as fast as possible and prints how long it took as JSON,
+//so allocator and layout changes can be measured against recorded workloads.
+
+//Build from this directory:
+//  gcc -O2 -I../Version8 nvmlib_replay.c -o nvmlib_replay -lpthread
+//Run:
+//  ./nvmlib_replay trace_file [-threads n] [-emulate read_ns,write_ns,write_mb_s,persist_ns] > replay.json
+//-threads defaults to 1 (calls in trace order); 0 uses every processor, with each pool's calls kept in order.
+//The library's own messages are thrown away so stdout only holds the JSON.
+
+#include "nvmlib8.c"
+
+int main(int argc, char** argv)
+{
+	int nthreads = 1;
+	unsigned long long emulate[4] = {0, 0, 0, 0};
+	int i;
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s trace_file [-threads n] [-emulate read_ns,write_ns,write_mb_s,persist_ns]\n", argv[0]);
+		return 1;
+	}
+	for (i = 2; i + 1 < argc; i = i + 2)
+	{
+		if (strcmp(argv[i], "-threads") == 0)
+		{
+			nthreads = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-emulate") == 0)
+		{
+			sscanf(argv[i + 1], "%llu,%llu,%llu,%llu", &emulate[0], &emulate[1], &emulate[2], &emulate[3]);
+		}
+	}
+
+	fflush(stdout); //the library prints to stdout, so the JSON goes to a copy of it
+	FILE* out = fdopen(dup(fileno(stdout)), "w");
+	if (out == NULL || freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not set up output!\n");
+		return 1;
+	}
+
+	nvm_emulation e = {emulate[0], emulate[1], emulate[2] * 1000000ULL, emulate[3]};
+	nvm_emulate(&e);
+	uint64_t start = nvm_now();
+	int64_t calls = pool_trace_replay(argv[1], nthreads);
+	uint64_t ns = nvm_now() - start;
+	if (calls < 0)
+	{
+		fprintf(stderr, "ERROR: Could not replay trace %s!\n", argv[1]);
+		return 1;
+	}
+
+	fprintf(out, "{\"trace\": \"%s\", \"threads\": %d, \"calls\": %lld, \"total_ns\": %llu, \"calls_per_sec\": %.1f,\n", argv[1], nthreads,
+		(long long) calls, (unsigned long long) ns, ns > 0 ? calls * 1e9 / ns : 0.0);
+	fprintf(out, " \"emulation\": {\"read_ns\": %llu, \"write_ns\": %llu, \"write_mb_s\": %llu, \"persist_ns\": %llu}}\n",
+		emulate[0], emulate[1], emulate[2], emulate[3]);
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,282 @@
+//Non-Volatile Memory Library Scaling Benchmark
+//Runs a mix of getoid, pwriteint, pmalloc and pfree calls on 1, 2, 4 ... n threads and prints the throughput at each
+//thread count together with the acquisitions, contention and wait time of every lock site as JSON.
+
+//Build from this directory:
+//  gcc -O2 -I../Version8 nvmlib_scale.c -o nvmlib_scale -lpthread -lm
+//Run:
+//  ./nvmlib_scale [-threads n] [-mix getoid,pwriteint,pmalloc,pfree] [-private] [-zipf theta] [-size n] [-ms n] > scale.json
+//-threads is the largest thread count (defaults to the # of processors), -mix is in percent (defaults to 70,20,5,5),
+//-private gives every thread its own pool instead of one shared pool, -zipf picks offsets with a Zipfian skew
+//(0 is uniform, up to 0.99), -size is the starting size of each pool and -ms is how long each thread count runs.
+//Each pfree frees an OID the same thread allocated with pmalloc, so no OID is freed twice.
+//The library's own messages are thrown away so stdout only holds the JSON.
+
+#include "nvmlib8.c"
+#include <math.h>
+
+typedef struct scale_config
+{
+	int mix[4]; //percent of getoid, pwriteint, pmalloc and pfree calls
+	int private_pools;
+	double theta;
+	int size;
+	int ms;
+} scale_config;
+
+typedef struct zipf_gen //Zipfian offsets as in Gray et al., "Quickly Generating Billion-Record Synthetic Databases"
+{
+	int n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+} zipf_gen;
+
+typedef struct scale_worker
+{
+	pthread_t thread;
+	pool* p;
+	const scale_config* config;
+	const zipf_gen* zipf;
+	int* go;
+	int* stop;
+	uint64_t rng;
+	OID** mine; //OIDs this thread allocated and has not freed yet
+	int mine_count;
+	int mine_cap;
+	uint64_t ops;
+} scale_worker;
+
+void zipf_init(zipf_gen* z, int n, double theta)
+{
+	z->n = n;
+	z->theta = theta;
+	z->zetan = 0;
+	int i;
+	for (i = 1; i <= n; i++)
+	{
+		z->zetan = z->zetan + 1.0 / pow(i, theta);
+	}
+	double zeta2 = 1.0 + 1.0 / pow(2, theta);
+	z->alpha = 1.0 / (1.0 - theta);
+	z->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+uint64_t scale_rand(uint64_t* x) //xorshift64
+{
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+	return *x;
+}
+
+//returns an offset below size, offsets near 0 being the most popular ones when theta > 0
+int scale_key(scale_worker* w, int size)
+{
+	if (size < 1)
+	{
+		return 0;
+	}
+	if (w->zipf->theta <= 0)
+	{
+		return (int) (scale_rand(&w->rng) % size);
+	}
+	double u = (scale_rand(&w->rng) >> 11) * (1.0 / 9007199254740992.0);
+	double uz = u * w->zipf->zetan;
+	int k;
+	if (uz < 1.0)
+	{
+		k = 0;
+	}
+	else if (uz < 1.0 + pow(0.5, w->zipf->theta))
+	{
+		k = 1;
+	}
+	else
+	{
+		k = (int) (w->zipf->n * pow(w->zipf->eta * u - w->zipf->eta + 1.0, w->zipf->alpha));
+	}
+	return k % size;
+}
+
+void* scale_run(void* arg)
+{
+	scale_worker* w = arg;
+	while (__atomic_load_n(w->go, __ATOMIC_ACQUIRE) == 0)
+	{
+	}
+	while (__atomic_load_n(w->stop, __ATOMIC_RELAXED) == 0)
+	{
+		int i;
+		for (i = 0; i < 256; i++) //checks for the end every 256 calls
+		{
+			int r = (int) (scale_rand(&w->rng) % 100);
+			if (r < w->config->mix[0])
+			{
+				getoid(w->p, scale_key(w, w->config->size)); //pools never shrink below their starting size
+			}
+			else if (r < w->config->mix[0] + w->config->mix[1])
+			{
+				pwriteint(w->p, r);
+			}
+			else if (r < w->config->mix[0] + w->config->mix[1] + w->config->mix[2] || w->mine_count == 0)
+			{
+				if (w->mine_count == w->mine_cap)
+				{
+					w->mine_cap = w->mine_cap * 2 + 16;
+					w->mine = realloc(w->mine, w->mine_cap * sizeof(OID*));
+				}
+				w->mine[w->mine_count] = pmalloc(w->p, 1);
+				w->mine_count++;
+			}
+			else
+			{
+				w->mine_count--;
+				pfree(w->mine[w->mine_count]);
+			}
+		}
+		w->ops = w->ops + 256;
+	}
+	return NULL;
+}
+
+//Run the mix on nthreads threads for config->ms and print the result, returns the calls per second
+double scale_point(FILE* out, const scale_config* config, const zipf_gen* zipf, int nthreads, double base, int last)
+{
+	static int runs = 0;
+	scale_worker* workers = calloc(nthreads, sizeof(scale_worker));
+	int go = 0;
+	int stop = 0;
+	pool* shared = NULL;
+	char name[64];
+	int i;
+	for (i = 0; i < nthreads; i++) //every thread count starts on new pools
+	{
+		if (shared == NULL || config->private_pools == 1)
+		{
+			snprintf(name, sizeof(name), "scale%d_%d", runs, i);
+			shared = pool_create(name, config->size);
+		}
+		workers[i].p = shared;
+		workers[i].config = config;
+		workers[i].zipf = zipf;
+		workers[i].go = &go;
+		workers[i].stop = &stop;
+		workers[i].rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+		pthread_create(&workers[i].thread, NULL, scale_run, &workers[i]);
+	}
+	runs++;
+
+	pool_lock_profile_reset();
+	uint64_t start = nvm_now();
+	__atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+	usleep(config->ms * 1000);
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	uint64_t ops = 0;
+	for (i = 0; i < nthreads; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		ops = ops + workers[i].ops;
+		free(workers[i].mine);
+	}
+	uint64_t ns = nvm_now() - start;
+
+	double rate = ns > 0 ? ops * 1e9 / ns : 0.0;
+	fprintf(out, "  {\"threads\": %d, \"calls\": %llu, \"total_ns\": %llu, \"calls_per_sec\": %.1f, \"speedup\": %.2f,\n   \"locks\": [",
+		nthreads, (unsigned long long) ops, (unsigned long long) ns, rate, base > 0 ? rate / base : 1.0);
+	lock_profile prof[LOCK_SITES];
+	int n = pool_lock_profile(prof, LOCK_SITES);
+	for (i = 0; i < n; i++)
+	{
+		fprintf(out, "%s\n    {\"site\": \"%s\", \"acquired\": %llu, \"contended\": %llu, \"wait_ns\": %llu}", i == 0 ? "" : ",", prof[i].site,
+			(unsigned long long) prof[i].acquired, (unsigned long long) prof[i].contended, (unsigned long long) prof[i].wait_ns);
+	}
+	fprintf(out, "]}%s\n", last == 1 ? "" : ",");
+
+	for (i = 0; i < nthreads; i++) //the pools are only needed for this thread count
+	{
+		if (i == 0 || workers[i].p != workers[i - 1].p)
+		{
+			pool_destroy(workers[i].p);
+		}
+	}
+	free(workers);
+	return rate;
+}
+
+int main(int argc, char** argv)
+{
+	int max_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	scale_config config = {{70, 20, 5, 5}, 0, 0.0, 10000, 200};
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-private") == 0)
+		{
+			config.private_pools = 1;
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-threads") == 0)
+		{
+			max_threads = atoi(argv[++i]);
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-mix") == 0)
+		{
+			sscanf(argv[++i], "%d,%d,%d,%d", &config.mix[0], &config.mix[1], &config.mix[2], &config.mix[3]);
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-zipf") == 0)
+		{
+			config.theta = atof(argv[++i]);
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-size") == 0)
+		{
+			config.size = atoi(argv[++i]);
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-ms") == 0)
+		{
+			config.ms = atoi(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [-threads n] [-mix getoid,pwriteint,pmalloc,pfree] [-private] [-zipf theta] [-size n] [-ms n]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (max_threads < 1 || config.size < 2 || config.ms < 1
+		|| config.mix[0] + config.mix[1] + config.mix[2] + config.mix[3] != 100)
+	{
+		fprintf(stderr, "ERROR: -threads and -ms must be at least 1, -size at least 2 and -mix must add up to 100!\n");
+		return 1;
+	}
+	if (config.theta > 0.99)
+	{
+		config.theta = 0.99;
+	}
+
+	fflush(stdout); //the library prints to stdout, so the JSON goes to a copy of it
+	FILE* out = fdopen(dup(fileno(stdout)), "w");
+	if (out == NULL || freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not set up output!\n");
+		return 1;
+	}
+
+	zipf_gen zipf;
+	zipf_init(&zipf, config.size, config.theta);
+	fprintf(out, "{\"pools\": \"%s\", \"mix\": {\"getoid\": %d, \"pwriteint\": %d, \"pmalloc\": %d, \"pfree\": %d},\n", config.private_pools == 1 ? "private" : "shared",
+		config.mix[0], config.mix[1], config.mix[2], config.mix[3]);
+	fprintf(out, " \"zipf\": %.2f, \"size\": %d, \"ms\": %d, \"stats\": %d,\n \"points\": [\n", config.theta, config.size, config.ms, NVMLIB_STATS);
+	double base = 0;
+	int n;
+	for (n = 1; n <= max_threads; n = n * 2 > max_threads && n < max_threads ? max_threads : n * 2)
+	{
+		double rate = scale_point(out, &config, &zipf, n, base, n == max_threads);
+		if (n == 1)
+		{
+			base = rate;
+		}
+	}
+	fprintf(out, " ]}\n");
+	fclose(out);
+	return 0;
+}
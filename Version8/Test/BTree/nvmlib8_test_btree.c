@@ -0,0 +1,194 @@
+//Testing Program for B+-Trees of the Non-Volatile Memory Library Version 8
+//Bulk loads a B+-tree from a sorted dataset read with pfilein, runs range and prefix queries both ways over int and
+//string trees, and finds the trees again after writing, mapping and hibernating the pool
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//Prints the keys of int tree t from lo up to hi, or from hi down to lo if backward is 1
+void print_range(OID* t, int64_t lo, int64_t hi, int backward)
+{
+	pbtree_iter it;
+	int code = backward == 1 ? pbtree_seek_last(t, &hi, &it) : pbtree_seek(t, &lo, &it);
+	while (code == POOL_OK && *(int64_t*) it.key >= lo && *(int64_t*) it.key <= hi)
+	{
+		printf("%lld ", (long long) *(int64_t*) it.key);
+		code = backward == 1 ? pbtree_prev(&it) : pbtree_next(&it);
+	}
+	printf("\n");
+}
+
+//returns the # of keys of int tree t, checking they come out in ascending order
+int64_t count_in_order(OID* t)
+{
+	pbtree_iter it;
+	int64_t count = 0;
+	int64_t last = INT64_MIN;
+	int code;
+	for (code = pbtree_seek(t, NULL, &it); code == POOL_OK; code = pbtree_next(&it))
+	{
+		if (*(int64_t*) it.key <= last)
+		{
+			printf("ERROR: key %lld comes after %lld!\n", (long long) *(int64_t*) it.key, (long long) last);
+		}
+		last = *(int64_t*) it.key;
+		count++;
+	}
+	return count;
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Writing the multiples of 3 below 30000 to sorted.bin and reading it into pool2...\n");
+	pool* pool2 = pool_create("pool2", 10000);
+	int i;
+	for (i = 0; i < 10000; i++)
+	{
+		pwriteint(pool2, 3 * i);
+	}
+	pfileout(pool2, "sorted.bin");
+	pool_reset(pool2);
+	pfilein(pool2, "sorted.bin");
+	printf("pool2's size: %lld, int at offset 9999: %d\n", (long long) pool2->size, pread_int(pool2, 9999));
+	printf("\n");
+
+	printf("Creating pool1 and bulk loading an int B+-tree in its root object with pool2's ints and their offsets...\n");
+	pool* pool1 = pool_create("pool1", 10);
+	OID* t = pbtree_create(pool1, PBTREE_INT, sizeof(int64_t), sizeof(int64_t));
+	int64_t* keys = malloc(10000 * sizeof(int64_t));
+	int64_t* offsets = malloc(10000 * sizeof(int64_t));
+	int64_t n = 0;
+	while (n < pool2->size) //each view only covers one run of pool2
+	{
+		pview v = pview_get(pool2, n, pool2->size - n);
+		for (i = 0; i < v.len; i++)
+		{
+			keys[n + i] = pview_int(v, i);
+			offsets[n + i] = n + i;
+		}
+		n = n + v.len;
+	}
+	pbtree_load(t, keys, offsets, n);
+	int64_t key = 2997;
+	printf("Tree offset: %lld, is pool1's root: %s, count: %lld, offset of 2997: %lld\n", (long long) oid_offset(t), t == pool_root(pool1) ? "yes" : "no",
+		(long long) pbtree_count(t), (long long) *(int64_t*) pbtree_get(t, &key));
+	printf("Keys from 100 to 130: ");
+	print_range(t, 100, 130, 0);
+	printf("Keys from 130 down to 100: ");
+	print_range(t, 100, 130, 1);
+	printf("\n");
+
+	printf("Putting 1, 4, 7 ... up to 29998 and removing the multiples of 6...\n");
+	for (key = 1; key < 30000; key = key + 3)
+	{
+		pbtree_put(t, &key, &key);
+	}
+	for (key = 0; key < 30000; key = key + 6)
+	{
+		pbtree_remove(t, &key);
+	}
+	key = 20;
+	int64_t value = -20;
+	pbtree_put(t, &key, &value);
+	printf("count: %lld, keys in order: %lld, value of 20: %lld\n", (long long) pbtree_count(t), (long long) count_in_order(t),
+		(long long) *(int64_t*) pbtree_get(t, &key));
+	printf("Keys from 100 to 130: ");
+	print_range(t, 100, 130, 0);
+	printf("Keys from 29990 up: ");
+	print_range(t, 29990, INT64_MAX, 0);
+	printf("Keys from 10 down: ");
+	print_range(t, INT64_MIN, 10, 1);
+	printf("\n");
+
+	printf("Creating a string B+-tree and finding the keys with prefix \"car\"...\n");
+	OID* s = pbtree_create(pool1, PBTREE_STR, 16, sizeof(int));
+	const char* words[] = {"cat", "car", "apple", "cargo", "banana", "carpet", "dog", "cart", "ca", "zebra"};
+	for (i = 0; i < 10; i++)
+	{
+		pbtree_put(s, words[i], &i);
+	}
+	pbtree_iter it;
+	int code;
+	printf("Keys with prefix car: ");
+	for (code = pbtree_seek(s, "car", &it); code == POOL_OK && strncmp(it.key, "car", 3) == 0; code = pbtree_next(&it))
+	{
+		printf("%s(%d) ", (const char*) it.key, *(int*) it.value);
+	}
+	printf("\n");
+	printf("All keys backward: ");
+	for (code = pbtree_seek_last(s, NULL, &it); code == POOL_OK; code = pbtree_prev(&it))
+	{
+		printf("%s ", (const char*) it.key);
+	}
+	printf("\n\n");
+
+	printf("Writing pool1 to btree.bin and mapping it as pool3...\n");
+	pfileout(pool1, "btree.bin");
+	pool* pool3 = pool_create_map("pool3", "btree.bin");
+	OID* t3 = pool_root(pool3);
+	printf("pool3's root tree count: %lld, keys in order: %lld\n", (long long) pbtree_count(t3), (long long) count_in_order(t3));
+	printf("pool3's keys from 100 to 130: ");
+	print_range(t3, 100, 130, 0);
+	key = 100;
+	pbtree_remove(t3, &key);
+	printf("After removing 100 from pool3's tree: pool3 count %lld, pool1 count %lld\n", (long long) pbtree_count(t3), (long long) pbtree_count(t));
+	printf("\n");
+
+	printf("Hibernating pool1 and finding its trees again after pool_open...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_close(pool1);
+	pool_open("pool1");
+	t = pool_root(pool1);
+	s = getoid(pool1, 1);
+	key = 20;
+	printf("pool1's root tree count: %lld, value of 20: %lld, string tree count: %lld, value of cart: %d\n", (long long) pbtree_count(t),
+		(long long) *(int64_t*) pbtree_get(t, &key), (long long) pbtree_count(s), *(int*) pbtree_get(s, "cart"));
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
+	printf("Checking error codes...\n");
+	code = pbtree_put(getoid(pool2, 1), &key, &value);
+	printf("pbtree_put on an int returns %d (%s)\n", code, pool_strerror(code));
+	code = pbtree_put(s, "a key that is too long", &i);
+	printf("pbtree_put of a 22-char key into 16-byte keys returns %d (%s)\n", code, pool_strerror(code));
+	key = 0;
+	code = pbtree_remove(t, &key);
+	printf("pbtree_remove of a key that is not there returns %d (%s)\n", code, pool_strerror(code));
+	keys[0] = 5;
+	keys[1] = 4;
+	code = pbtree_load(pbtree_create(pool1, PBTREE_INT, sizeof(int64_t), 0), keys, NULL, 2);
+	printf("pbtree_load of unsorted keys returns %d (%s)\n", code, pool_strerror(code));
+	code = pbtree_seek(s, "zzz", &it);
+	printf("pbtree_seek past the last key returns %d (%s)\n", code, pool_strerror(code));
+	printf("\n");
+
+	printf("Destroying pool1, pool2 and pool3...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	pool_destroy(pool3);
+	remove("pool1.hib");
+	free(keys);
+	free(offsets);
+	printf("\n");
+
+	return 0;
+}
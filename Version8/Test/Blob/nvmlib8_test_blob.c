@@ -0,0 +1,115 @@
+//Testing Program for Non-Volatile Memory Library Function Definitions Version 8
+//This Test stores blobs of different sizes (inline and out-of-line) and round trips them through a binary file
+//As described in the paper "Hardware Supported Persistent Object Address Translation" by Dr. James Tuck (NCSU)
+//Written by Avery Acierno (Undergraduate Research)
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//A 64 byte record
+typedef struct record
+{
+	int id;
+	char name[28];
+	double values[4];
+} record;
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating pool1 of size 10...\n\n");
+	pool* pool1 = pool_create("pool1", 10);
+
+	printf("Writing 3 records, a short string, an int and a char to pool1...\n\n");
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		record r;
+		memset(&r, 0, sizeof(record));
+		r.id = i;
+		sprintf(r.name, "record %d", i);
+		r.values[i] = 1.5 * i;
+		pwrite_blob(pool1, &r, sizeof(record));
+	}
+	pwrite_blob(pool1, "short", 6);
+	pwriteint(pool1, 42);
+	pwritechar(pool1, 'z');
+
+	printf("Contents of pool1:\n");
+	preadf(pool1);
+	printf("\n");
+
+	printf("Reading record 1 back from pool1...\n");
+	record r;
+	size_t size = pread_blob(pool1, 1, &r, sizeof(record));
+	printf("size: %zu id: %d name: %s values[1]: %.1f\n", size, r.id, r.name, r.values[1]);
+	const char* s = pread_blob_ptr(pool1, 3, &size);
+	printf("In place blob at offset 3: %s (%zu bytes)\n", s, size);
+	printf("\n");
+
+	printf("Writing pool1 to file blobs.bin...\n");
+	pfileout(pool1, "blobs.bin");
+	printf("\n");
+
+	printf("Writing pool1 to file blobs.txt...\n");
+	pfileouttxt(pool1, "blobs.txt");
+	printf("\n");
+
+	printf("Creating pool2 of size 10...\n\n");
+	pool* pool2 = pool_create("pool2", 10);
+
+	printf("Reading file blobs.bin into pool2...\n");
+	pfilein(pool2, "blobs.bin");
+	printf("\n");
+
+	printf("Contents of pool2:\n");
+	preadf(pool2);
+	printf("\n");
+
+	printf("Comparing pool1 and pool2...\n");
+	int same = 1;
+	for (i = 0; i < 6; i++)
+	{
+		size_t size1, size2;
+		const void* b1 = pread_blob_ptr(pool1, i, &size1);
+		const void* b2 = pread_blob_ptr(pool2, i, &size2);
+		if (pread_type(pool1, i) != pread_type(pool2, i) || size1 != size2 || (b1 != NULL && memcmp(b1, b2, size1) != 0))
+		{
+			same = 0;
+		}
+	}
+	printf("int at offset 4: %d, char at offset 5: %c\n", pread_int(pool2, 4), pread_char(pool2, 5));
+	printf("pool1 and pool2 %s\n", same ? "match" : "DO NOT match");
+	printf("\n");
+
+	printf("Freeing record 0 in pool1...\n");
+	pfree(getoid(pool1, 0));
+	printf("id of record at offset 0 of pool1: %d\n", ((const record*) pread_blob_ptr(pool1, 0, &size))->id);
+	printf("\n");
+
+	printf("Closing pool1...\n\n");
+	pool_close(pool1);
+
+	printf("Closing pool2...\n\n");
+	pool_close(pool2);
+
+	return 0;
+}
@@ -0,0 +1,184 @@
+//Testing Program for Root Directories of the Non-Volatile Memory Library Version 8
+//Makes the root object of a pool a directory, names a vector, hash map, tree, queue, blob and int in it, and finds them
+//by name and kind again after freeing objects before them, writing, mapping and hibernating the pool
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//prints the directory entry of name in pool p and the offset pool_dir_get finds it at
+void print_entry(pool* p, const char* name)
+{
+	pdir_entry e;
+	int code = pool_dir_stat(p, name, &e);
+	if (code != POOL_OK)
+	{
+		printf("%s: %s\n", name, pool_strerror(code));
+		return;
+	}
+	OID* oid = pool_dir_get(p, name, PDIR_ANY);
+	printf("%s: offset %lld, kind %u, size %llu, found at %lld\n", name, (long long) e.offset, e.kind, (unsigned long long) e.size,
+		oid == NULL ? -1LL : (long long) oid_offset(oid));
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+	const char* names[] = {"count", "vector", "hash", "tree", "queue", "blob"};
+	int i;
+
+	printf("Creating pool1 of size 10 and a directory in its root object...\n");
+	pool* pool1 = pool_create("pool1", 10);
+	int code = pool_dir_set(pool1, "count", getoid(pool1, 1));
+	printf("pool_dir_set before the directory exists returns %d (%s)\n", code, pool_strerror(code));
+	OID* d = pool_dir_create(pool1);
+	printf("Directory offset: %lld, is pool1's root: %s, created again: %s\n", (long long) oid_offset(d), d == pool_root(pool1) ? "yes" : "no",
+		pool_dir_create(pool1) == d ? "same directory" : "new directory");
+	printf("\n");
+
+	printf("Naming an int, a vector, a hash map, a tree, a queue and a blob...\n");
+	pwriteint(pool1, 7);
+	pwriteint(pool1, 42);
+	OID* v = pvec_create(pool1, sizeof(int), 0);
+	OID* h = phash_create(pool1, sizeof(int), sizeof(int), 0);
+	OID* t = pbtree_create(pool1, PBTREE_INT, sizeof(int64_t), sizeof(int));
+	OID* q = pqueue_create(pool1, PQUEUE_MPMC, sizeof(int), 8);
+	pwrite_blob(pool1, "a blob with a name", 19);
+	OID* named[] = {getoid(pool1, 2), v, h, t, q, getoid(pool1, 7)};
+	for (i = 0; i < 6; i++)
+	{
+		pool_dir_set(pool1, names[i], named[i]);
+	}
+	for (i = 0; i < 10; i++)
+	{
+		int x = i * 10;
+		int64_t k = i;
+		pvec_push(v, &x);
+		phash_put(h, &i, &x);
+		pbtree_put(t, &k, &x);
+	}
+	i = 5;
+	pqueue_push(q, &i);
+	for (i = 0; i < 6; i++)
+	{
+		print_entry(pool1, names[i]);
+	}
+	printf("\n");
+
+	printf("Naming 40 more objects and removing every other one...\n");
+	char name[24]; //room for "extra" and any int
+	for (i = 0; i < 40; i++)
+	{
+		snprintf(name, sizeof(name), "extra%02d", i);
+		pool_dir_set(pool1, name, getoid(pool1, 1));
+	}
+	for (i = 0; i < 40; i = i + 2)
+	{
+		snprintf(name, sizeof(name), "extra%02d", i);
+		pool_dir_remove(pool1, name);
+	}
+	code = pool_dir_remove(pool1, "extra00");
+	printf("Names: %lld, removing extra00 again returns %d (%s)\n", (long long) phash_count(d), code, pool_strerror(code));
+	print_entry(pool1, "extra01");
+	print_entry(pool1, "extra02");
+	printf("\n");
+
+	printf("Finding the objects by kind...\n");
+	OID* oid = pool_dir_get(pool1, "vector", PDIR_VECTOR);
+	printf("vector as a vector: size %lld, element 9: %d\n", (long long) pvec_size(oid), *(int*) pvec_at(oid, 9));
+	oid = pool_dir_get(pool1, "tree", PDIR_BTREE);
+	int64_t key = 3;
+	printf("tree as a tree: count %lld, value of 3: %d\n", (long long) pbtree_count(oid), *(int*) pbtree_get(oid, &key));
+	oid = pool_dir_get(pool1, "count", PDIR_INT);
+	printf("count as an int: %d\n", pread_int(pool1, oid_offset(oid)));
+	oid = pool_dir_get(pool1, "vector", PDIR_HASH);
+	printf("vector as a hash map leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	oid = pool_dir_get(pool1, "missing", PDIR_ANY);
+	printf("an unnamed object quietly leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	printf("\n");
+
+	printf("Freeing the int at offset 1, which the extra names point at...\n");
+	pfree(getoid(pool1, 1));
+	printf("Names: %lld\n", (long long) phash_count(d));
+	print_entry(pool1, "extra01");
+	for (i = 0; i < 6; i++)
+	{
+		print_entry(pool1, names[i]);
+	}
+	printf("Allocating 2 OIDs at offset 2 with pmalloc_range...\n");
+	pmalloc_range(pool1, 2, 2);
+	print_entry(pool1, "vector");
+	print_entry(pool1, "queue");
+	code = pmalloc_range(pool1, 0, 1) == NULL ? pool_errno : POOL_OK;
+	printf("pmalloc_range at the directory returns %d (%s)\n", code, pool_strerror(code));
+	printf("Freeing offsets 1 to 3 (the count and the 2 new OIDs) with pfree_range...\n");
+	pfree_range(pool1, 1, 3);
+	print_entry(pool1, "count");
+	print_entry(pool1, "vector");
+	print_entry(pool1, "blob");
+	printf("\n");
+
+	printf("Writing pool1 to dir.bin and mapping it as pool2...\n");
+	pfileout(pool1, "dir.bin");
+	pool* pool2 = pool_create_map("pool2", "dir.bin");
+	for (i = 1; i < 6; i++)
+	{
+		print_entry(pool2, names[i]);
+	}
+	oid = pool_dir_get(pool2, "queue", PDIR_QUEUE);
+	int x = 0;
+	pqueue_pop(oid, &x);
+	printf("Popped %d from pool2's queue, %lld left\n", x, (long long) pqueue_count(oid));
+	oid = pool_dir_get(pool2, "hash", PDIR_HASH);
+	i = 4;
+	printf("pool2's hash map: count %lld, value of 4: %d\n", (long long) phash_count(oid), *(int*) phash_get(oid, &i));
+	printf("\n");
+
+	printf("Hibernating pool1 and finding its objects again after pool_open...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_close(pool1);
+	pool_open("pool1");
+	print_entry(pool1, "tree");
+	oid = pool_dir_get(pool1, "blob", PDIR_BLOB);
+	printf("blob: %s\n", oid == NULL ? "(none)" : (char*) oid->data);
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
+	printf("Checking error codes...\n");
+	code = pool_dir_set(pool1, "", pool_dir_get(pool1, "vector", PDIR_VECTOR));
+	printf("pool_dir_set with an empty name returns %d (%s)\n", code, pool_strerror(code));
+	code = pool_dir_set(pool1, "self", pool_root(pool1));
+	printf("pool_dir_set on the directory itself returns %d (%s)\n", code, pool_strerror(code));
+	code = pool_dir_set(pool1, "other", pool_root(pool2));
+	printf("pool_dir_set on an object of pool2 returns %d (%s)\n", code, pool_strerror(code));
+	pool* pool3 = pool_create("pool3", 4);
+	pwriteint(pool3, 1);
+	pool_dir_get(pool3, "count", PDIR_ANY);
+	printf("pool_dir_get on a pool whose root is an int leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	printf("\n");
+
+	printf("Destroying pool1, pool2 and pool3...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	pool_destroy(pool3);
+	remove("pool1.hib");
+	printf("\n");
+
+	return 0;
+}
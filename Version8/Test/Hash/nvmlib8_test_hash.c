@@ -0,0 +1,134 @@
+//Testing Program for Hash Maps of the Non-Volatile Memory Library Version 8
+//Builds a hash map in the root object of a pool, resizes it while keys are put, removed and replaced, and finds it again
+//after writing, mapping and hibernating the pool
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//returns the sum of the values of keys 0 to n - 1 found in hash map m, and stores how many were found in found
+long long map_sum(OID* m, int64_t n, int64_t* found)
+{
+	long long sum = 0;
+	*found = 0;
+	int64_t key;
+	for (key = 0; key < n; key++)
+	{
+		int64_t* value = phash_get(m, &key);
+		if (value != NULL)
+		{
+			sum = sum + *value;
+			*found = *found + 1;
+		}
+	}
+	return sum;
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating pool1 of size 10 and a hash map of int64 keys and values in its root object...\n");
+	pool* pool1 = pool_create("pool1", 10);
+	OID* m = phash_create(pool1, sizeof(int64_t), sizeof(int64_t), 0);
+	printf("Map offset: %lld, is pool1's root: %s, count: %lld\n", (long long) oid_offset(m), m == pool_root(pool1) ? "yes" : "no",
+		(long long) phash_count(m));
+	printf("\n");
+
+	printf("Putting keys 0 to 999 with their squares...\n");
+	int64_t key;
+	int64_t value;
+	int64_t found;
+	for (key = 0; key < 1000; key++)
+	{
+		value = key * key;
+		phash_put(m, &key, &value);
+	}
+	key = 123;
+	printf("count: %lld, value of 123: %lld, sum: %lld, maps being resized: %d\n", (long long) phash_count(m),
+		(long long) *(int64_t*) phash_get(m, &key), map_sum(m, 1000, &found), pool1->hash_move_count);
+	printf("\n");
+
+	printf("Removing the odd keys and replacing the value of 10 with 7...\n");
+	for (key = 1; key < 1000; key = key + 2)
+	{
+		phash_remove(m, &key);
+	}
+	key = 10;
+	value = 7;
+	phash_put(m, &key, &value);
+	long long sum = map_sum(m, 1000, &found);
+	printf("count: %lld, keys found: %lld, sum: %lld\n", (long long) phash_count(m), (long long) found, sum);
+	key = 11;
+	printf("value of 11: %s (%s)\n", phash_get(m, &key) == NULL ? "none" : "found", pool_strerror(pool_errno));
+	printf("\n");
+
+	printf("Putting keys from 1000 on until the map is being resized, then writing pool1 to hash.bin...\n");
+	for (key = 1000; key < 4000 && pool1->hash_move_count == 0; key++)
+	{
+		value = key * key;
+		phash_put(m, &key, &value);
+	}
+	printf("stopped after key %lld, maps being resized: %d\n", (long long) key - 1, pool1->hash_move_count);
+	pwriteint(pool1, 7);
+	pfileout(pool1, "hash.bin");
+	printf("maps being resized after pfileout: %d, count: %lld, sum: %lld\n", pool1->hash_move_count, (long long) phash_count(m),
+		map_sum(m, 4000, &found));
+	printf("\n");
+
+	printf("Mapping hash.bin as pool2...\n");
+	pool* pool2 = pool_create_map("pool2", "hash.bin");
+	OID* m2 = pool_root(pool2);
+	printf("pool2's root map count: %lld, sum: %lld\n", (long long) phash_count(m2), map_sum(m2, 4000, &found));
+	key = 5000;
+	value = 42;
+	phash_put(m2, &key, &value);
+	printf("After putting 5000 in pool2's map: pool2 count %lld, value %lld, pool1 count %lld\n", (long long) phash_count(m2),
+		(long long) *(int64_t*) phash_get(m2, &key), (long long) phash_count(m));
+	printf("\n");
+
+	printf("Hibernating pool1 and finding its map again after pool_open...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_close(pool1);
+	pool_open("pool1");
+	m = pool_root(pool1);
+	key = 10;
+	printf("pool1's root map count: %lld, value of 10: %lld, sum: %lld\n", (long long) phash_count(m), (long long) *(int64_t*) phash_get(m, &key),
+		map_sum(m, 4000, &found));
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
+	printf("Checking error codes...\n");
+	int code = phash_put(getoid(pool1, 1), &key, &value);
+	printf("phash_put on an int returns %d (%s)\n", code, pool_strerror(code));
+	key = 3;
+	code = phash_remove(m, &key);
+	printf("phash_remove of a key that is not there returns %d (%s)\n", code, pool_strerror(code));
+	phash_create(pool1, 0, 8, 0);
+	printf("phash_create with 0-byte keys leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	printf("\n");
+
+	printf("Destroying pool1 and pool2...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	remove("pool1.hib");
+	printf("\n");
+
+	return 0;
+}
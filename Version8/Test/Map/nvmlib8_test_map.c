@@ -0,0 +1,108 @@
+//Testing Program for Non-Volatile Memory Library Function Definitions Version 8
+//This Test builds a pool on top of a mapped binary file and writes to it without changing the file
+//As described in the paper "Hardware Supported Persistent Object Address Translation" by Dr. James Tuck (NCSU)
+//Written by Avery Acierno (Undergraduate Research)
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating pool1 of size 32...\n\n");
+	pool* pool1 = pool_create("pool1", 32);
+
+	printf("Writing multiples of 3 to pool1 (3 to 75) and the string 'mapped'\n\n");
+	int i;
+	for (i = 3; i <= 75; i = i + 3)
+	{
+		pwriteint(pool1, i);
+	}
+	pwritestr(pool1, "mapped");
+
+	printf("Writing pool1 to file plus3.bin...\n");
+	pfileout(pool1, "plus3.bin");
+	printf("\n");
+
+	printf("Creating pool2 on top of file plus3.bin...\n");
+	pool* pool2 = pool_create_map("pool2", "plus3.bin");
+	printf("pool2's size: %lld\n", (long long) pool2->size);
+	printf("pool2's root OID offset: %lld\n", (long long) oid_offset(pool_root(pool2)));
+	printf("\n");
+
+	printf("Contents of pool2:\n");
+	preadf(pool2);
+	printf("\n");
+
+	printf("Reading pool2 in place with pview...\n");
+	pview v = pview_get(pool2, 1, 100);
+	int sum = 0;
+	for (i = 0; i < v.len; i++)
+	{
+		sum = sum + pview_int(v, i);
+	}
+	printf("Sum of the %lld ints in the run at offset 1 of pool2: %d\n", (long long) v.len, sum);
+	printf("\n");
+
+	printf("Changing the int at offset 4 of pool2 to 1000 using getoid...\n");
+	OID* offset4 = getoid(pool2, 4);
+	offset4->data = (int*) 1000;
+	printf("pool2's int at offset 4: %d\n", pread_int(pool2, 4));
+	printf("\n");
+
+	printf("Freeing the OID at offset 0 in pool2...\n");
+	pfree(getoid(pool2, 0));
+	printf("New size of pool2: %lld\n", (long long) pool2->size);
+	printf("pool2's root OID offset: %lld int: %d\n", (long long) oid_offset(pool_root(pool2)), pread_int(pool2, 0));
+	printf("\n");
+
+	printf("Allocating 5 more OIDs to pool2 and writing 99 to them...\n\n");
+	pmalloc(pool2, 5);
+	for (i = 0; i < 5; i++)
+	{
+		pwriteint(pool2, 99);
+	}
+
+	printf("Contents of pool2:\n");
+	preadf(pool2);
+	printf("\n");
+
+	printf("Writing pool2 to file plus3changed.txt...\n");
+	pfileouttxt(pool2, "plus3changed.txt");
+	printf("\n");
+
+	printf("Creating pool3 on top of file plus3.bin again (the file is unchanged)...\n");
+	pool* pool3 = pool_create_map("pool3", "plus3.bin");
+	printf("Contents of pool3:\n");
+	preadf(pool3);
+	printf("\n");
+
+	printf("Closing pool1...\n\n");
+	pool_close(pool1);
+
+	printf("Closing pool2...\n\n");
+	pool_close(pool2);
+
+	printf("Closing pool3...\n\n");
+	pool_close(pool3);
+
+	return 0;
+}
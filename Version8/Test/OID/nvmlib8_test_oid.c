@@ -9,8 +9,24 @@
 #include <string.h>
 #include <unistd.h>
 
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
 int main()
 {
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
 	printf("Creating pool1 of size 10...\n\n");
 	pool* pool1 = pool_create("pool1", 10);
 	
@@ -27,7 +43,7 @@ int main()
 
 	printf("Allocating 5 more OIDs to pool1...\n");
 	pmalloc(pool1, 5);
-	printf("New size of pool1: %d\n\n", pool1->size);
+	printf("New size of pool1: %lld\n\n", (long long) pool1->size);
 
 	printf("Writing oids containing odd numbers (even offsets) to oids at offstets 10-14...\n\n");
 	for (i = 0; i < 10; i = i + 2)
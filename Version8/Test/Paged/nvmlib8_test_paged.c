@@ -0,0 +1,118 @@
+//Testing Program for Non-Volatile Memory Library Function Definitions Version 8
+//This Test builds an out-of-core pool whose pages do not all fit in its cache, so pages are written back and read in again
+//As described in the paper "Hardware Supported Persistent Object Address Translation" by Dr. James Tuck (NCSU)
+//Written by Avery Acierno (Undergraduate Research)
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating out-of-core pool1 of size 10000 on file pool1.pages with the smallest cache...\n");
+	pool* pool1 = pool_create_paged("pool1", "pool1.pages", 10000, 0);
+	printf("pool1's size: %lld\n", (long long) pool1->size);
+	printf("pool1's root OID offset: %lld\n", (long long) oid_offset(pool_root(pool1)));
+	printf("\n");
+
+	printf("Writing 0 to 7999 to pool1, then a blob and the string 'paged'\n\n");
+	int i;
+	for (i = 0; i < 8000; i++)
+	{
+		pwriteint(pool1, i);
+	}
+	pwrite_blob(pool1, "a blob longer than an OID's data field", 39);
+	pwritestr(pool1, "paged");
+
+	printf("Reading pool1 back...\n");
+	int sum = 0;
+	for (i = 0; i < 8000; i++)
+	{
+		sum = sum + pread_int(pool1, i);
+	}
+	char buf[64];
+	size_t len = pread_blob(pool1, 8000, buf, sizeof(buf));
+	printf("Sum of pool1's ints: %d\n", sum);
+	printf("pool1's blob at offset 8000: %zu bytes, '%s'\n", len, buf);
+	printf("pool1's chars at offsets 8001 and 8005: %c %c\n", pread_char(pool1, 8001), pread_char(pool1, 8005));
+	printf("pool1's type at offset 9000 (empty): %d\n", pread_type(pool1, 9000));
+	struct pool_stats stats;
+	pool_stats(pool1, &stats);
+	printf("Pages were read in again: %s, written back: %s\n", stats.page_reads > 0 ? "yes" : "no", stats.page_writes > 0 ? "yes" : "no");
+	printf("\n");
+
+	printf("Pinning the OID at offset 5 and reading the rest of pool1...\n");
+	OID* offset5 = getoid(pool1, 5);
+	oid_pin(offset5);
+	for (i = 1000; i < 8000; i++)
+	{
+		pread_int(pool1, i);
+	}
+	printf("Pinned OID offset: %lld, int: %d\n", (long long) oid_offset(offset5), (int) (intptr_t) offset5->data);
+	oid_unpin(offset5);
+	printf("\n");
+
+	printf("Freeing the OID at offset 10 in pool1 using getoid...\n");
+	pfree(getoid(pool1, 10));
+	printf("pool1's new size: %lld\n", (long long) pool1->size);
+	printf("pool1's ints at offsets 10, 1023 and 7998: %d %d %d\n", pread_int(pool1, 10), pread_int(pool1, 1023), pread_int(pool1, 7998));
+	printf("pool1's blob is now at offset 7999: %d\n", pread_type(pool1, 7999));
+	printf("\n");
+
+	printf("Writing pool1 to file paged.bin and mapping it as pool2...\n");
+	pool_persist(pool1);
+	pfileout(pool1, "paged.bin");
+	pool* pool2 = pool_create_map("pool2", "paged.bin");
+	printf("pool2's size: %lld, int at offset 4096: %d\n", (long long) pool2->size, pread_int(pool2, 4096));
+	printf("\n");
+
+	printf("Freeing pool1's first 2000 objects with pfree_range and allocating 1500 at offset 1000 with pmalloc_range...\n");
+	pfree_range(pool1, 0, 2000);
+	printf("pool1's size: %lld, ints at offsets 0 and 1000: %d %d\n", (long long) pool1->size, pread_int(pool1, 0), pread_int(pool1, 1000));
+	OID* gap = pmalloc_range(pool1, 1000, 1500);
+	printf("pool1's size: %lld, gap offset: %lld, types at offsets 1000 and 2499: %d %d, int at offset 2500: %d\n", (long long) pool1->size,
+		(long long) oid_offset(gap), pread_type(pool1, 1000), pread_type(pool1, 2499), pread_int(pool1, 2500));
+	printf("pool1's blob is now at offset 7499: %d\n", pread_type(pool1, 7499));
+	printf("\n");
+
+	printf("Checking error codes on pool1...\n");
+	int code = pwriteptr(pool2, getoid(pool1, 3));
+	printf("pwriteptr into an out-of-core pool returns %d (%s)\n", code, pool_strerror(code));
+	code = pool_hibernate(pool1, "pool1.hib");
+	printf("pool_hibernate on an out-of-core pool returns %d (%s)\n", code, pool_strerror(code));
+	printf("\n");
+
+	printf("Resetting pool1...\n");
+	pool_reset(pool1);
+	printf("pool1's size: %lld, type at offset 0: %d\n", (long long) pool1->size, pread_type(pool1, 0));
+	pwriteint(pool1, 7);
+	printf("pool1's int at offset 0 after writing 7: %d\n", pread_int(pool1, 0));
+	printf("\n");
+
+	printf("Destroying pool1 and pool2...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	printf("pool1.pages is gone: %s\n", access("pool1.pages", F_OK) != 0 ? "yes" : "no");
+	remove("paged.bin");
+	printf("\n");
+
+	return 0;
+}
@@ -0,0 +1,215 @@
+//Testing Program for Queues of the Non-Volatile Memory Library Version 8
+//Hands ints from producer threads to consumer threads through SPSC and MPMC queues, one at a time and in batches,
+//and finds the queues again with their elements after writing, mapping and hibernating the pool
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+#define PER_PRODUCER 100000 //# of ints each producer thread pushes
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//For a producer or consumer thread
+typedef struct worker
+{
+	pthread_t thread;
+	OID* q; //queue of ints
+	int id; //producers push id * PER_PRODUCER + 1 up to (id + 1) * PER_PRODUCER
+	int batch; //# of ints moved per call
+	int* producers_left; //# of producers still pushing
+	long long sum; //sum of the ints a consumer popped
+	long long count; //# of ints a consumer popped
+	int out_of_order; //# of ints a consumer popped before an int pushed before them by the same producer
+} worker;
+
+void* produce(void* arg)
+{
+	worker* w = arg;
+	int buf[64];
+	int i = 0;
+	while (i < PER_PRODUCER)
+	{
+		int n = PER_PRODUCER - i < w->batch ? PER_PRODUCER - i : w->batch;
+		int j;
+		for (j = 0; j < n; j++)
+		{
+			buf[j] = w->id * PER_PRODUCER + i + j + 1;
+		}
+		int64_t k = pqueue_push_n(w->q, buf, n);
+		i = i + (int) k;
+		if (k == 0) //full, let a consumer run
+		{
+			sched_yield();
+		}
+	}
+	__atomic_fetch_sub(w->producers_left, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+void* consume(void* arg)
+{
+	worker* w = arg;
+	int buf[64];
+	int last[8] = {0};
+	while (1)
+	{
+		int done = __atomic_load_n(w->producers_left, __ATOMIC_ACQUIRE) == 0;
+		int64_t k = pqueue_pop_n(w->q, buf, w->batch);
+		if (k == 0 && done == 1) //empty after the last push
+		{
+			break;
+		}
+		else if (k == 0)
+		{
+			sched_yield();
+		}
+		int j;
+		for (j = 0; j < k; j++)
+		{
+			int producer = (buf[j] - 1) / PER_PRODUCER;
+			w->out_of_order = w->out_of_order + (buf[j] <= last[producer]);
+			last[producer] = buf[j];
+			w->sum = w->sum + buf[j];
+			w->count++;
+		}
+	}
+	return NULL;
+}
+
+//Run producers and consumers on queue q moving batch ints per call, and print what the consumers got
+void handoff(OID* q, int producers, int consumers, int batch)
+{
+	worker w[8];
+	int producers_left = producers;
+	memset(w, 0, sizeof(w));
+	int i;
+	for (i = 0; i < producers + consumers; i++)
+	{
+		w[i].q = q;
+		w[i].id = i < producers ? i : i - producers;
+		w[i].batch = batch;
+		w[i].producers_left = &producers_left;
+		pthread_create(&w[i].thread, NULL, i < producers ? produce : consume, &w[i]);
+	}
+	long long sum = 0;
+	long long count = 0;
+	int out_of_order = 0;
+	for (i = 0; i < producers + consumers; i++)
+	{
+		pthread_join(w[i].thread, NULL);
+		sum = sum + w[i].sum;
+		count = count + w[i].count;
+		out_of_order = out_of_order + w[i].out_of_order;
+	}
+	long long n = (long long) producers * PER_PRODUCER;
+	printf("%d producers, %d consumers, %d per call: popped %lld of %lld, sum %s, out of order: %d, left: %lld\n", producers, consumers, batch,
+		count, n, sum == n * (n + 1) / 2 ? "right" : "wrong", out_of_order, (long long) pqueue_count(q));
+}
+
+//Pop every int of queue q and print them
+void print_queue(OID* q)
+{
+	int value;
+	while (pqueue_pop(q, &value) == POOL_OK)
+	{
+		printf("%d ", value);
+	}
+	printf("\n");
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating pool1 and an SPSC queue of 100 ints in its root object...\n");
+	pool* pool1 = pool_create("pool1", 10);
+	OID* s = pqueue_create(pool1, PQUEUE_SPSC, sizeof(int), 100);
+	printf("Queue offset: %lld, is pool1's root: %s, capacity: %lld, count: %lld\n", (long long) oid_offset(s), s == pool_root(pool1) ? "yes" : "no",
+		(long long) pqueue_capacity(s), (long long) pqueue_count(s));
+	handoff(s, 1, 1, 1);
+	handoff(s, 1, 1, 16);
+	printf("\n");
+
+	printf("Creating an MPMC queue of 64 ints...\n");
+	OID* m = pqueue_create(pool1, PQUEUE_MPMC, sizeof(int), 64);
+	handoff(m, 2, 2, 1);
+	handoff(m, 4, 3, 10);
+	printf("\n");
+
+	printf("Filling the MPMC queue and popping part of it...\n");
+	int i;
+	for (i = 1; pqueue_push(m, &i) == POOL_OK; i++)
+	{
+	}
+	printf("pushed %d ints before %s\n", i - 1, pool_strerror(pool_errno));
+	int popped[60];
+	printf("popped %lld in one call\n", (long long) pqueue_pop_n(m, popped, 60));
+	int more[3] = {65, 66, 67};
+	int64_t k = pqueue_push_n(m, more, 3);
+	printf("pushed %lld of 3 more, count: %lld\n", (long long) k, (long long) pqueue_count(m));
+	for (i = 0; i < 3; i++)
+	{
+		pqueue_push(s, &more[i]);
+	}
+	printf("\n");
+
+	printf("Writing pool1 to queue.bin and mapping it as pool2...\n");
+	pfileout(pool1, "queue.bin");
+	pool* pool2 = pool_create_map("pool2", "queue.bin");
+	OID* m2 = getoid(pool2, 1);
+	pqueue_recover(m2);
+	printf("pool2's MPMC queue count: %lld, ints: ", (long long) pqueue_count(m2));
+	print_queue(m2);
+	printf("pool1's MPMC queue count after popping pool2's: %lld\n", (long long) pqueue_count(m));
+	printf("\n");
+
+	printf("Hibernating pool1 and finding its queues again after pool_open...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_close(pool1);
+	pool_open("pool1");
+	s = pool_root(pool1);
+	m = getoid(pool1, 1);
+	pqueue_recover(s);
+	pqueue_recover(m);
+	printf("pool1's SPSC queue count: %lld, ints: ", (long long) pqueue_count(s));
+	print_queue(s);
+	printf("pool1's MPMC queue count: %lld, ints: ", (long long) pqueue_count(m));
+	print_queue(m);
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
+	printf("Checking error codes...\n");
+	int code = pqueue_pop(m, &i);
+	printf("pqueue_pop on an empty queue returns %d (%s)\n", code, pool_strerror(code));
+	pwriteint(pool1, 7);
+	code = pqueue_push(getoid(pool1, 2), &i);
+	printf("pqueue_push on an int returns %d (%s)\n", code, pool_strerror(code));
+	printf("pqueue_push_n of -1 ints returns %lld\n", (long long) pqueue_push_n(m, &i, -1));
+	pqueue_create(pool1, PQUEUE_MPMC, sizeof(int), 0);
+	printf("pqueue_create with no room leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	printf("\n");
+
+	printf("Destroying pool1 and pool2...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	remove("pool1.hib");
+	printf("\n");
+
+	return 0;
+}
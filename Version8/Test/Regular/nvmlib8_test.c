@@ -8,22 +8,38 @@
 #include <string.h>
 #include <unistd.h>
 
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
 int main() 
 {	
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
 	printf("Attempting to open an invalid pool name...\n");
 	pool_open("Nonexistent");
 	printf("\n");
 
 	printf("Creating pool1 of size 10...\n");
 	pool* pool1 = pool_create("pool1", 10);
-	printf("Created pool's root OID offset: %d\n", pool1->root->offset);
+	printf("Created pool's root OID offset: %lld\n", (long long) oid_offset(pool1->root));
 	printf("Created pool's root OID pool: %s\n", pool1->root->pool->name);
-	printf("Created pool's size: %d\n", pool1->size);
-	printf("Created pool's OID 3 steps from root offset: %d\n", pool1->root->next->next->next->offset);
+	printf("Created pool's size: %lld\n", (long long) pool1->size);
+	printf("Created pool's OID 3 steps from root offset: %lld\n", (long long) oid_offset(pool1->root->next->next->next));
 	printf("\n");
 
 	printf("Testing pool_root function on pool1...\n");
-	printf("pool1's root OID offset: %d\n", (pool_root(pool1))->offset);
+	printf("pool1's root OID offset: %lld\n", (long long) oid_offset(pool_root(pool1)));
 	printf("\n");
 	
 	printf("Closing pool1...\n\n");
@@ -39,15 +55,15 @@ int main()
 
 	printf("Allocating 10 more OIDs to pool1...\n");
 	newdata_root = pmalloc(pool1, 10);
-	printf("The root OID of the data just added to pool1: %d\n", newdata_root->offset);
-	printf("pool1's new size: %d\n", pool1->size);
-	printf("pool1's OID 14 steps from the offset: %d\n", pool1->root->next->next->next->next->next->next->next->next->next->next->next->next->next->next->offset);
+	printf("The root OID of the data just added to pool1: %lld\n", (long long) oid_offset(newdata_root));
+	printf("pool1's new size: %lld\n", (long long) pool1->size);
+	printf("pool1's OID 14 steps from the offset: %lld\n", (long long) oid_offset(pool1->root->next->next->next->next->next->next->next->next->next->next->next->next->next->next));
 	printf("\n");
 
 	printf("Freeing the OID at offset 10 in pool1...\n");
 	pfree(newdata_root);
-	printf("New size of pool1: %d\n", pool1->size);
-	printf("New offset value at OID 10 steps from root of pool1: %d\n", pool1->root->next->next->next->next->next->next->next->next->next->next->offset);
+	printf("New size of pool1: %lld\n", (long long) pool1->size);
+	printf("New offset value at OID 10 steps from root of pool1: %lld\n", (long long) oid_offset(pool1->root->next->next->next->next->next->next->next->next->next->next));
 	printf("\n");
 
 	printf("Writing multiples of 25 to pool1 (25 to 500)\n\n");
@@ -76,6 +92,18 @@ int main()
 	preadf(pool2);
 	printf("\n");
 
+	printf("Reading pool2 in place with pread_int and pview...\n");
+	printf("pool2's int at offset 4: %d\n", pread_int(pool2, 4));
+	printf("pool2's type at offset 50 (empty): %d\n", pread_type(pool2, 50));
+	pview v = pview_get(pool2, 0, 100);
+	int sum = 0;
+	for (i = 0; i < v.len; i++)
+	{
+		sum = sum + pview_int(v, i);
+	}
+	printf("Sum of the %lld ints in pool2's first run: %d\n", (long long) v.len, sum);
+	printf("\n");
+
 	printf("Freeing the OID at offset 3 x3 and 150 in pool2 using getoid...\n");
 	OID* offset3 = getoid(pool2, 3);
 	pfree(offset3);
@@ -142,6 +170,65 @@ int main()
 	pfileouttxt(pool2, "plus25abcde2strlines.txt");
 	printf("\n");
 
+	printf("Stats of pool2:\n");
+	struct pool_stats stats;
+	int code;
+	pool_stats(pool2, &stats);
+	printf("lookups: %llu, empty-slot scans: %llu, allocations: %llu, frees: %llu\n", (unsigned long long) stats.lookups,
+		(unsigned long long) stats.empty_scans, (unsigned long long) stats.allocations, (unsigned long long) stats.frees);
+	printf("bytes written: %llu, exported: %llu, imported: %llu, resident: %llu\n", (unsigned long long) stats.bytes_written,
+		(unsigned long long) stats.bytes_exported, (unsigned long long) stats.bytes_imported, (unsigned long long) stats.resident_bytes);
+	printf("\n");
+
+	printf("Freeing pool2's first 5 ints (25 to 200) with pfree_range...\n");
+	pfree_range(pool2, 0, 5);
+	printf("pool2's size: %lld, int at offset 0: %d, offset of the OID at offset 4: %lld\n", (long long) pool2->size,
+		pread_int(pool2, 0), (long long) oid_offset(getoid(pool2, 4)));
+	printf("Allocating 3 OIDs at offset 1 of pool2 with pmalloc_range...\n");
+	OID* gap = pmalloc_range(pool2, 1, 3);
+	printf("pool2's size: %lld, gap offset: %lld, types at offsets 0, 1, 3 and 4: %d %d %d %d, int at offset 4: %d\n", (long long) pool2->size,
+		(long long) oid_offset(gap), pread_type(pool2, 0), pread_type(pool2, 1), pread_type(pool2, 3), pread_type(pool2, 4), pread_int(pool2, 4));
+	printf("pool2's root links to the gap: %s\n", pool2->root->next == gap ? "yes" : "no");
+	code = pfree_range(pool2, pool2->size - 1, 2);
+	printf("pfree_range past the end of pool2 returns %d (%s)\n", code, pool_strerror(code));
+	printf("\n");
+
+	printf("Checking error codes on pool1...\n");
+	code = pwriteint(NULL, 1);
+	printf("pwriteint on a NULL pool returns %d (%s)\n", code, pool_strerror(code));
+	getoid(pool1, 1000);
+	printf("getoid past the end of pool1 leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	pread_int(pool1, -1);
+	printf("pread_int at offset -1 quietly leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	pool_log_set(test_log, NULL, 2);
+	for (i = 0; i < 5; i++)
+	{
+		getoid(pool1, -1);
+	}
+	pool_log_set(test_log, NULL, 0);
+	printf("\n");
+
+	printf("Resetting pool2...\n");
+	pool_reset(pool2);
+	printf("pool2's size: %lld, type at offset 0: %d\n", (long long) pool2->size, pread_type(pool2, 0));
+	pwriteint(pool2, 7);
+	printf("pool2's int at offset 0 after writing 7: %d\n", pread_int(pool2, 0));
+	printf("\n");
+
+	printf("Hibernating pool1 to pool1.hib on close...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_stats(pool1, &stats);
+	printf("pool1 resident before closing: %s\n", stats.resident_bytes > sizeof(pool) ? "objects in memory" : "nothing");
+	pool_close(pool1);
+	pool_stats(pool1, &stats);
+	printf("pool1 resident after closing: %llu bytes past the pool itself\n", (unsigned long long) (stats.resident_bytes - sizeof(pool)));
+	pool_open("pool1");
+	printf("pool1's size after reopening: %lld\n", (long long) pool1->size);
+	printf("Contents of pool1:\n");
+	preadf(pool1);
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
 	printf("Closing pool1...\n\n");
 	pool_close(pool1);
 
@@ -152,6 +239,17 @@ int main()
 	pool_open("Nonexistent");
 	printf("\n");
 
+	printf("Destroying pool1 and pool2...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	remove("pool1.hib");
+	printf("\n");
+
+	printf("Reopening pool1...\n");
+	pool_open("pool1");
+	printf("pool_open on a destroyed pool leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	printf("\n");
+
 	printf("\n");
 
 	return 0;
@@ -0,0 +1,113 @@
+//Testing Program for Text Pools of the Non-Volatile Memory Library Version 8
+//Edits words.input.txt like Version 4's second test, but in a text pool instead of deleting one OID at a time
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating text pool text1...\n");
+	pool* text1 = pool_create_text("text1");
+	printf("text1's size: %lld\n", (long long) text1->size);
+	printf("\n");
+
+	printf("Reading words.input.txt into text1...\n");
+	pfileintxt(text1, "words.input.txt");
+	printf("text1's size: %lld, chars at offsets 0 to 4: %c%c%c%c%c\n", (long long) text1->size, pread_char(text1, 0), pread_char(text1, 1),
+		pread_char(text1, 2), pread_char(text1, 3), pread_char(text1, 4));
+	printf("\n");
+
+	printf("Deleting the first 2 words (12 chars) of text1...\n");
+	ptext_delete(text1, 0, 12);
+	printf("text1's size: %lld, first char: %c\n", (long long) text1->size, pread_char(text1, 0));
+	printf("\n");
+
+	printf("Writing Edits to text1...\n");
+	pwritestr(text1, "\nI deleted the first 2 words and added this line!!!");
+	printf("text1's size: %lld, last char: %c\n", (long long) text1->size, pread_char(text1, text1->size - 1));
+	printf("\n");
+
+	printf("Writing text1 to words.output.txt...\n");
+	pfileouttxt(text1, "words.output.txt");
+	printf("\n");
+
+	printf("Inserting, replacing and deleting in the middle of text1...\n");
+	ptext_insert(text1, 6, "AIR ");
+	ptext_replace(text1, 0, 1, "A");
+	ptext_replace(text1, 10, 3, "almost everything");
+	ptext_delete(text1, 1, 1);
+	pfree_range(text1, 0, 1);
+	pview v = pview_get(text1, 0, 40);
+	printf("text1's first run (%lld chars): ", (long long) v.len);
+	int i;
+	for (i = 0; i < v.len; i++)
+	{
+		printf("%c", pview_char(v, i) == '\n' ? '/' : pview_char(v, i));
+	}
+	printf("\n");
+	printf("text1's first 40 chars: ");
+	for (i = 0; i < 40; i++)
+	{
+		char c = pread_char(text1, i);
+		printf("%c", c == '\n' ? '/' : c);
+	}
+	printf("\n");
+	printf("text1's size: %lld\n", (long long) text1->size);
+	printf("\n");
+
+	printf("Typing 1000 chars at offset 100 of text1 one at a time...\n");
+	for (i = 0; i < 1000; i++)
+	{
+		char c[2] = {(char) ('a' + i % 26), '\0'};
+		ptext_insert(text1, 100 + i, c);
+	}
+	printf("text1's size: %lld, chars at offsets 100 and 1099: %c %c, pieces: %lld\n", (long long) text1->size, pread_char(text1, 100),
+		pread_char(text1, 1099), (long long) text1->text->pieces);
+	ptext_delete(text1, 100, 1000);
+	printf("\n");
+
+	printf("Checking error codes on text1...\n");
+	getoid(text1, 0);
+	printf("getoid on a text pool leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	int code = pwriteint(text1, 1);
+	printf("pwriteint on a text pool returns %d (%s)\n", code, pool_strerror(code));
+	code = ptext_delete(text1, text1->size - 1, 2);
+	printf("ptext_delete past the end of text1 returns %d (%s)\n", code, pool_strerror(code));
+	pool* pool1 = pool_create("pool1", 10);
+	code = ptext_insert(pool1, 0, "x");
+	printf("ptext_insert on a pool of objects returns %d (%s)\n", code, pool_strerror(code));
+	printf("\n");
+
+	printf("Resetting text1...\n");
+	pool_reset(text1);
+	printf("text1's size: %lld\n", (long long) text1->size);
+	pwritestr(text1, "new text");
+	printf("text1's char at offset 4: %c\n", pread_char(text1, 4));
+	printf("\n");
+
+	printf("Destroying text1 and pool1...\n");
+	pool_destroy(text1);
+	pool_destroy(pool1);
+	printf("\n");
+
+	return 0;
+}
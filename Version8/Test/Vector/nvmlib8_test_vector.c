@@ -0,0 +1,115 @@
+//Testing Program for Vectors of the Non-Volatile Memory Library Version 8
+//Builds a vector in the root object of a pool, grows it, and finds it again after writing, mapping and hibernating the pool
+
+#include "nvmlib8.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Prints the library's messages the way the test expects them
+void test_log(int code, const char* message, void* arg)
+{
+	(void) arg;
+	if (code == POOL_OK)
+	{
+		printf("%s\n", message);
+	}
+	else
+	{
+		printf("ERROR: %s\n", message);
+	}
+}
+
+//returns the sum of the ints of vector v
+long long vector_sum(OID* v)
+{
+	long long sum = 0;
+	int64_t n = pvec_size(v);
+	int64_t i;
+	for (i = 0; i < n; i++)
+	{
+		sum = sum + *(int*) pvec_at(v, i);
+	}
+	return sum;
+}
+
+int main()
+{
+	pool_log_set(test_log, NULL, 0); //the library only reports through a log
+
+	printf("Creating pool1 of size 10 and a vector of ints in its root object...\n");
+	pool* pool1 = pool_create("pool1", 10);
+	OID* v = pvec_create(pool1, sizeof(int), 0);
+	printf("Vector offset: %lld, is pool1's root: %s, size: %lld, capacity: %lld\n", (long long) oid_offset(v), v == pool_root(pool1) ? "yes" : "no",
+		(long long) pvec_size(v), (long long) pvec_capacity(v));
+	printf("\n");
+
+	printf("Pushing 0 to 999 onto the vector...\n");
+	int i;
+	for (i = 0; i < 1000; i++)
+	{
+		pvec_push(v, &i);
+	}
+	printf("size: %lld, capacity: %lld, element 500: %d, sum: %lld\n", (long long) pvec_size(v), (long long) pvec_capacity(v),
+		*(int*) pvec_at(v, 500), vector_sum(v));
+	printf("\n");
+
+	printf("Appending 1000 to 1999 in one call...\n");
+	int more[1000];
+	for (i = 0; i < 1000; i++)
+	{
+		more[i] = 1000 + i;
+	}
+	pvec_append(v, more, 1000);
+	printf("size: %lld, capacity: %lld, element 1999: %d, sum: %lld\n", (long long) pvec_size(v), (long long) pvec_capacity(v),
+		*(int*) pvec_at(v, 1999), vector_sum(v));
+	printf("\n");
+
+	printf("Resizing the vector to 10, then to 20...\n");
+	pvec_resize(v, 10);
+	printf("size: %lld, sum: %lld\n", (long long) pvec_size(v), vector_sum(v));
+	pvec_resize(v, 20);
+	printf("size: %lld, sum: %lld, element 15: %d\n", (long long) pvec_size(v), vector_sum(v), *(int*) pvec_at(v, 15));
+	pvec_reserve(v, 3000);
+	printf("capacity after reserving 3000: %lld, size: %lld\n", (long long) pvec_capacity(v), (long long) pvec_size(v));
+	printf("\n");
+
+	printf("Writing pool1 to vector.bin and mapping it as pool2...\n");
+	pwriteint(pool1, 7);
+	pfileout(pool1, "vector.bin");
+	pool* pool2 = pool_create_map("pool2", "vector.bin");
+	OID* v2 = pool_root(pool2);
+	printf("pool2's root vector size: %lld, capacity: %lld, sum: %lld\n", (long long) pvec_size(v2), (long long) pvec_capacity(v2), vector_sum(v2));
+	i = 42;
+	pvec_push(v2, &i);
+	printf("After pushing 42 onto pool2's vector: size %lld, last element %d, pool1's vector size %lld\n", (long long) pvec_size(v2),
+		*(int*) pvec_at(v2, 20), (long long) pvec_size(v));
+	printf("\n");
+
+	printf("Hibernating pool1 and finding its vector again after pool_open...\n");
+	pool_hibernate(pool1, "pool1.hib");
+	pool_close(pool1);
+	pool_open("pool1");
+	v = pool_root(pool1);
+	printf("pool1's root vector size: %lld, sum: %lld\n", (long long) pvec_size(v), vector_sum(v));
+	pool_hibernate(pool1, NULL);
+	printf("\n");
+
+	printf("Checking error codes...\n");
+	int code = pvec_push(getoid(pool1, 1), &i);
+	printf("pvec_push on an int returns %d (%s)\n", code, pool_strerror(code));
+	pvec_at(v, 20);
+	printf("pvec_at past the end leaves %d (%s)\n", pool_errno, pool_strerror(pool_errno));
+	code = pvec_resize(v, -1);
+	printf("pvec_resize to -1 returns %d (%s)\n", code, pool_strerror(code));
+	printf("\n");
+
+	printf("Destroying pool1 and pool2...\n");
+	pool_destroy(pool1);
+	pool_destroy(pool2);
+	remove("pool1.hib");
+	printf("\n");
+
+	return 0;
+}
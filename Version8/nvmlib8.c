@@ -18,23 +18,166 @@
 
 //CURRENT PROBLEMS
 //1. OID and OID Linked List not seperate structs
-//2. Only works with binary file data to store ints
-//3. pool_root does not incorporate size
+//2. Only works with binary file data to store ints - FIXED (pfileout writes sized records)
+//3. pool_root does not incorporate size - FIXED (pool_dir_create makes the root a directory of named objects, kinds and sizes)
 //4. OIDs do not have different address values between pools
 //5. Frees pools instead of "closing" them - FIXED
 //6. No mode parameters in pool_create
 //7. Name parameter in pool_create is just a variable name - IMPLEMENT LL OF POOLS REFERENCED BY NAME - FIXED
 //8. No pool_open function - FIXED
-//9. No persist function
+//9. No persist function - pool_persist only emulates the cost of persisting (see nvm_emulate)
 //10. pool_root, pmalloc, pfree, getoid use OID* instead of OID
-//11. Cant store char* in void* -> using cast char to ints workaround
+//11. Cant store char* in void* -> using cast char to ints workaround - FIXED (pwrite_blob)
 //12. Empty oid will terminate all reading and file output of pool
 
+//Version 8 Additions:
+//1. OIDs are allocated in blocks and indexed by offset -> getoid takes O(log n) without walking the pool, pmalloc no longer walks the pool
+//2. pread_int, pread_char, pread_ptr, pread_type return data without printing; pview gives in-place access to runs of objects
+//3. pwrite_blob, pread_blob store values of any size; pfileout writes sized records that pfilein reads back losslessly
+//4. pfileout_parallel, pfileouttxt_parallel, pfilein_parallel split a pool into ranges handled by worker threads
+//5. pool_create_map builds a pool on top of a mapped binary file; OIDs are only brought into memory when getoid asks for them
+//6. Binary files are version 2: header, pool name table, directory of (type, size, data), data area and CRC32C of every chunk.
+//   Everything is little-endian and oidptrs are written as (pool name, offset), so a file can be mapped and used as is;
+//   pfilein checks the checksums and pool_verify checks them for a mapped file
+//7. pool_stats returns per-pool counters (lookups, empty-slot scans, allocations, frees, bytes moved, resident memory);
+//   compiling with -DNVMLIB_STATS=0 takes the counters out of the hot paths
+//8. nvm_emulate adds persistent memory read/write latency, write bandwidth and persist costs to pool accesses on DRAM
+//9. pool_trace_start/pool_trace_stop record every call into a binary trace that pool_trace_replay runs again
+//10. polb_sim models the paper's POLB (persistent object lookaside buffer) and pool table walks on the OID lookup stream
+//11. Pools are thread-safe: every call on a pool holds the pool's lock and the list of pools has its own lock;
+//    pool_lock_profile reports acquisitions, contention and wait time for each lock site
+//12. Calls return error codes (POOL_OK or POOL_E*) or NULL and leave the code in pool_errno instead of printing;
+//    messages only go to a function set with pool_log_set, which can limit them to a number a second
+//13. Pool sizes, offsets and index positions are 64-bit, so a pool can hold more than 2^31 objects
+//14. pool_create and pmalloc only reserve room: empty OIDs are brought into memory OID_CHUNK offsets at a time when first used,
+//    so creating or growing a pool takes constant time and memory follows the objects in use (next links stop at OIDs
+//    that are not in memory yet, as they do for mapped pools, so walk large pools with getoid)
+//15. Each pool takes its OIDs and blobs from its own arena of large mapped chunks; pool_destroy frees a pool and
+//    pool_reset empties one for reuse with a few munmap calls instead of a free per object
+//16. pool_hibernate makes pool_close write the pool to a file and release its memory; pool_open maps the file back and
+//    objects are brought in as they are used, like a pool from pool_create_map
+//17. pool_create_paged makes an out-of-core pool: its objects live in pages of a file and only a fixed-size cache of
+//    pages is in memory (CLOCK replacement, dirty write-back, read-ahead for scans); oid_pin keeps a page in memory
+//18. pfree_range frees a run of objects and pmalloc_range opens a run of empty ones at any offset. The index is a treap
+//    of segments of offsets and OIDs only keep their offset in their segment (oid_offset sums the rest up the treap),
+//    so a call cuts the treap at the ends of the run and joins it again: it touches O(log n) segments however long the
+//    run and the pool are, plus the OIDs of a freed run that are in memory, whose data is given up
+//19. pool_create_text makes a text pool: a piece table of chars edited at any offset in O(log n) with ptext_insert,
+//    ptext_delete and ptext_replace, read like a pool of chars and written out by pfileouttxt piece by piece
+//20. pvec_create makes a vector in a blob object: pvec_push and pvec_append grow it geometrically (amortized O(1)),
+//    pvec_at indexes it in O(1) and pvec_resize/pvec_reserve change it without leaving a half-copied blob behind
+//21. phash_create makes a hash map in a blob object: open addressing with SwissTable-style control bytes compared a group
+//    at a time with SSE2, so phash_get takes one or two cache misses; a full map is resized a few groups per write
+//22. pbtree_create makes a B+-tree of int or string keys in a blob object of page-sized nodes: pbtree_load bulk loads
+//    sorted keys, pbtree_seek/pbtree_seek_last with pbtree_next/pbtree_prev scan ranges both ways, and every write
+//    builds new nodes that one 8-byte store makes part of the tree, so a split is never seen half done
+//23. pqueue_create makes a bounded FIFO queue in a blob object: a ring of slots whose pushes and pops take no lock
+//    (PQUEUE_SPSC for one producer and one consumer thread, PQUEUE_MPMC for any #), pqueue_push_n/pqueue_pop_n move
+//    batches, and the head and tail are kept in the blob so the queue is found again with its elements after a restart
+//24. pool_dir_create makes the root object a directory, a hash map in which pool_dir_set names objects, so pool_dir_get
+//    finds a vector, hash map, tree or queue by name and kind in O(1) after pool_open; frees keep its offsets current
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE //for mremap
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define BLOB_INLINE_SIZE sizeof(void*) //blobs up to this size are stored in the data field itself
+#define BLOB_MAX_SIZE ((size_t) UINT32_MAX) //largest blob, as binary files keep the size of an object in 32 bits
+#define PFILE_MAGIC 0x504D564E //"NVMP" at the start of a binary file
+#define PFILE_VERSION 2 //version 1 files (sized records) are still read
+#define PFILE_CHUNK_SIZE (1 << 20) //# of bytes of a binary file covered by each checksum
+#define PFILE_BUF_SIZE (1 << 20) //bytes each export worker gathers before writing
+#define OID_SPARE_BLOCK 256 //# of OIDs allocated at a time for objects brought in from a mapped file
+#define OID_CHUNK 512 //most entries of a segment of the index, whose empty OIDs are brought into memory together (see oid_chunk_fill)
+#define ARENA_CHUNK_SIZE (1 << 20) //# of bytes an arena maps at a time (larger requests get a chunk of their own)
+#define ARENA_ALIGN 16 //alignment of everything taken from an arena, and its smallest blob extent
+#define ARENA_CLASSES 48 //# of blob extent sizes an arena keeps freed extents for (ARENA_ALIGN << class)
+#define BUFFER_PAGE_OIDS 1024 //# of objects on a page of an out-of-core pool (see pool_create_paged)
+#define BUFFER_MIN_FRAMES 4 //fewest frames of a page cache, as pfree holds two pages at once
+#define BUFFER_READ_AHEAD 8 //# of pages read ahead of a scan of an out-of-core pool
+#define TEXT_ADD_CHUNK (64 << 10) //# of bytes a text pool takes from its arena at a time for inserted text
+#define PVEC_MAGIC 0x56564E50 //"PNVV" at the start of the blob of a vector
+#define PVEC_MIN_CAP 4 //# of elements a vector grows to at least
+#define PHASH_MAGIC 0x4D484E50 //"PNHM" at the start of the blob of a hash map
+#define PHASH_GROUP 16 //# of slots whose control bytes are compared at once
+#define PHASH_MIN_CAP 16 //# of slots of the smallest table
+#define PHASH_MOVE_GROUPS 4 //# of groups of the old table each write moves while a hash map is resized
+#define PHASH_EMPTY 0x80 //control byte of a slot never used
+#define PHASH_DELETED 0xFE //control byte of a slot whose key was removed
+#define PHASH_PAD(n) (((size_t) (n) + 7) & ~(size_t) 7) //keys and values start 8-byte aligned in a slot
+#define PBTREE_MAGIC 0x54424E50 //"PNBT" at the start of the blob of a B+-tree
+#define PBTREE_NODE_SIZE 4096 //# of bytes of a node of a B+-tree, a page
+#define PBTREE_MAX_HEIGHT 16 //# of levels a B+-tree can have
+#define PBTREE_MAX_KEY 256 //largest key of a B+-tree, in bytes
+#define PBTREE_MAX_VALUE 1024 //largest value of a B+-tree, in bytes
+#define PBTREE_INT 1 //B+-tree keys are int64_t in numeric order
+#define PBTREE_STR 2 //B+-tree keys are C strings of up to key_size - 1 chars in strcmp order
+#define PQUEUE_MAGIC 0x514E4E50 //"PNNQ" at the start of the blob of a queue
+#define PQUEUE_SPSC 1 //queue pushed to by one thread and popped by one thread at a time
+#define PQUEUE_MPMC 2 //queue pushed to and popped by any # of threads
+#define PQUEUE_MAX_CAP ((uint64_t) 1 << 40) //most slots of a queue
+#define PDIR_MAGIC 0x52444E50 //"PNDR" in the kind field of the hash map that is the directory of a pool
+#define PDIR_NAME_SIZE 64 //# of bytes of a name in a directory, so names are up to 63 chars
+#define PDIR_ANY 0 //kinds of named objects (see pool_dir_get): any kind
+#define PDIR_INT 1 //an int, a char, an oidptr or a blob, as in data_type
+#define PDIR_CHAR 2
+#define PDIR_PTR 3
+#define PDIR_BLOB 4
+#define PDIR_VECTOR 5 //a vector (see pvec_create)
+#define PDIR_HASH 6 //a hash map (see phash_create)
+#define PDIR_BTREE 7 //a B+-tree (see pbtree_create)
+#define PDIR_QUEUE 8 //a queue (see pqueue_create)
+#define TRACE_MAGIC 0x544D564E //"NVMT" at the start of a trace
+#define TRACE_VERSION 1
+#define POLB_LRU 0 //replace the translation used longest ago
+#define POLB_FIFO 1 //replace the translation filled longest ago
+#define POLB_RANDOM 2 //replace a random translation of the set
+#define LOCK_REGISTRY 0 //lock sites (see pool_lock_profile)
+#define LOCK_GETOID 1
+#define LOCK_PREAD 2
+#define LOCK_PWRITE 3
+#define LOCK_PMALLOC 4
+#define LOCK_PFREE 5
+#define LOCK_FILE 6
+#define LOCK_POOL 7
+#define LOCK_MAP 8
+#define LOCK_TRACE 9
+#define LOCK_POLB 10
+#define LOCK_SITES 11
+#define POOL_OK 0 //error codes returned by the library and left in pool_errno (see pool_strerror)
+#define POOL_ENULL 1
+#define POOL_ECLOSED 2
+#define POOL_EFULL 3
+#define POOL_ERANGE 4
+#define POOL_ENOENT 5
+#define POOL_EINVAL 6
+#define POOL_EIO 7
+#define POOL_EBADF 8
+#define POOL_EFREED 9
+#define POOL_EBUSY 10
+#define POOL_ETYPE 11
+#define POOL_ERRORS 12
+
+#ifndef NVMLIB_STATS
+#define NVMLIB_STATS 1 //0 leaves the pool_stats counters out
+#endif
+#if NVMLIB_STATS
+#define POOL_STAT(p, field, n) __atomic_fetch_add(&(p)->stats.field, (uint64_t) (n), __ATOMIC_RELAXED)
+#else
+#define POOL_STAT(p, field, n) ((void) 0)
+#endif
 
 //STRUCT DEFINITIONS
 
@@ -43,701 +186,9737 @@ typedef struct oid
 {
 	void* data; //place to store data
 	size_t data_size; //place to store size of data
-	int data_type; //place to store type of data (1=int, 2=char, 3=oidptr)
-	int offset; //offset from root OID of pool
+	int64_t rel; //offset in seg, or from the root OID of the pool if seg is NULL (see oid_offset)
+	int data_type; //place to store type of data (1=int, 2=char, 3=oidptr, 4=blob)
 	int empty; //1 if char data has been written to, 0 else
 	struct oid * next;
 	struct pool * pool;
+	struct index_seg * seg; //segment of the index holding the OID (NULL for OIDs of out-of-core pools, copies and freed OIDs)
 } OID;
 
+//For a segment of the index of a pool: the entries of a run of offsets, in a treap ordered by offset like the pieces
+//of a text pool, so the segment holding an offset is found in O(log n) and a run of offsets is cut out or put in
+//without touching the segments after it. OIDs keep their offset in their segment (see oid_offset).
+typedef struct index_seg
+{
+	OID ** slots; //entry at each offset of the segment (see index_mapped), NULL while none of its offsets is in memory
+	int64_t map_first; //# in the mapped file of the object at the first offset while slots is NULL (-1 if its offsets are empty)
+	int64_t count; //# of offsets of the segment
+	int64_t cap; //# of entries slots has room for
+	int64_t total; //# of offsets of the segment and the segments under it
+	uint32_t prio; //random heap priority, which keeps the treap O(log n) deep
+	struct index_seg * left;
+	struct index_seg * right;
+	struct index_seg * parent;
+} index_seg;
+
+//For the header at the start of a version 2 binary file (every field is little-endian)
+typedef struct pfile_header
+{
+	uint32_t magic; //PFILE_MAGIC
+	uint32_t version; //PFILE_VERSION
+	uint32_t header_size; //# of bytes in the header
+	uint32_t chunk_size; //# of bytes covered by each checksum
+	uint64_t count; //# of objects in the file
+	uint64_t names_pos; //position of the pool names of oidptrs (NUL terminated, one after another)
+	uint64_t names_size; //# of bytes of pool names
+	uint64_t dir_pos; //position of the directory (a pfile_entry for every object)
+	uint64_t data_pos; //position of the data area
+	uint64_t data_size; //# of bytes in the data area
+	uint64_t crc_pos; //position of the CRC32C of every chunk from names_pos up to crc_pos
+	uint32_t name_count; //# of pool names
+	uint32_t header_crc; //CRC32C of the header up to this field
+} pfile_header;
+
+//For the directory entry of an object in a version 2 binary file
+typedef struct pfile_entry
+{
+	uint32_t type; //type of data (1=int, 2=char, 3=oidptr, 4=blob)
+	uint32_t size; //# of bytes of data (ints are 4, chars 1, oidptrs 16: pool name # and offset)
+	uint64_t value; //data of up to 8 bytes, else position of the data in the data area (aligned to 8)
+} pfile_entry;
+
+//For a block of OIDs brought into memory together (see oid_chunk_fill)
+typedef struct oid_block
+{
+	OID * oids; //OIDs of the block, adjacent in memory
+	int64_t count; //# of OIDs in the block
+	struct oid_block * next;
+} oid_block;
+
+//For the counters of a pool (see pool_stats)
+struct pool_stats
+{
+	uint64_t lookups; //objects looked up by offset (getoid, pread_*, pview_get)
+	uint64_t empty_scans; //searches for the first OID with no data (pwrite*, pfilein*)
+	uint64_t scan_steps; //offsets looked at by those searches
+	uint64_t allocations; //pmalloc calls
+	uint64_t oids_allocated; //OIDs added by pmalloc
+	uint64_t frees; //pfree calls
+	uint64_t renumber_steps; //OIDs renumbered by pfree
+	uint64_t materialized; //objects copied out of a mapped file into their own OID
+	uint64_t page_reads; //pages of an out-of-core pool read from its file
+	uint64_t page_writes; //pages of an out-of-core pool written back to its file
+	uint64_t bytes_written; //data bytes written by pwrite*
+	uint64_t bytes_exported; //file bytes written by pfileout*
+	uint64_t bytes_imported; //file bytes read by pfilein*
+	uint64_t resident_bytes; //heap memory held by the pool (filled in by pool_stats)
+	uint64_t mapped_bytes; //bytes of the pool's mapped file (filled in by pool_stats)
+	uint64_t persists; //pool_persist calls
+	uint64_t emulated_ns; //ns spent waiting on emulated persistent memory (see nvm_emulate)
+};
+
+//For the costs of persistent memory added to pool accesses (see nvm_emulate)
+typedef struct nvm_emulation
+{
+	uint64_t read_ns; //added to every object read
+	uint64_t write_ns; //added to every object written
+	uint64_t write_bw; //bytes per second that written data may reach across all pools (0 for no limit)
+	uint64_t persist_ns; //added to every pool_persist
+} nvm_emulation;
+
+//For the configuration of a simulated POLB and pool table
+typedef struct polb_config
+{
+	int entries; //# of translations the POLB holds
+	int ways; //associativity (entries for a fully associative POLB)
+	int policy; //replacement policy (POLB_LRU, POLB_FIFO or POLB_RANDOM)
+	int granule_shift; //a translation covers 2^granule_shift objects of a pool (40 or more for a whole pool)
+	int table_entries; //# of slots of the pool table, an open-addressed hash table of pools
+	uint32_t hit_cycles; //cycles of a POLB lookup
+	uint32_t walk_cycles; //cycles added by a pool table walk on a miss
+	uint32_t probe_cycles; //cycles added for each slot of the pool table the walk looks at
+} polb_config;
+
+//For the results of a simulated POLB
+typedef struct polb_result
+{
+	uint64_t accesses; //OID lookups
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions; //misses that replaced a valid translation
+	uint64_t probes; //pool table slots looked at by walks
+	uint64_t cycles; //estimated cycles spent translating
+	double hit_rate;
+	double cycles_per_access;
+} polb_result;
+
+//For a simulated POLB
+typedef struct polb_sim
+{
+	polb_config config;
+	int sets; //# of sets (entries / ways)
+	uint64_t* tags; //translation held by each entry (pool # << 40 | granule), 0 if empty
+	uint64_t* stamps; //last use (LRU) or fill (FIFO) of each entry
+	uint32_t* table; //pool # in each slot of the pool table (0 if empty)
+	uint64_t clock; //# of accesses so far, for stamps
+	uint64_t rand; //state of the random replacement
+	polb_result result;
+} polb_sim;
+
+//For a function that takes the library's messages (see pool_log_set), code is POOL_OK for messages that are not errors
+typedef void (*pool_log_fn)(int code, const char* message, void* arg);
+
+//For the contention of one lock site (see pool_lock_profile)
+typedef struct lock_profile
+{
+	const char* site; //calls that take the lock
+	uint64_t acquired; //# of times the lock was taken
+	uint64_t contended; //# of times it was held by another thread
+	uint64_t wait_ns; //ns spent waiting for it
+} lock_profile;
+
+//For the lock counts of one thread, kept apart so counting does not add contention of its own
+typedef struct lock_counts
+{
+	uint64_t acquired[LOCK_SITES];
+	uint64_t contended[LOCK_SITES];
+	uint64_t wait_ns[LOCK_SITES];
+	struct lock_counts * next;
+} lock_counts;
+
+//For a chunk of memory mapped by an arena
+typedef struct arena_chunk
+{
+	size_t size; //# of bytes of the chunk, this header included
+	size_t used; //# of bytes handed out so far, this header included
+	struct arena_chunk * next;
+} arena_chunk;
+
+//For the memory of a pool's OIDs and blobs, taken from a few large chunks so all of it can be released at once
+typedef struct pool_arena
+{
+	arena_chunk * chunks; //LL of chunks, the one being filled first
+	void* free_lists[ARENA_CLASSES]; //freed blob extents of each size class, each holding the next one
+	uint64_t used; //# of bytes handed out
+	pthread_mutex_t lock; //taken for every allocation, as parallel file workers allocate without the pool's lock
+} pool_arena;
+
+//For a frame of the page cache of an out-of-core pool (see pool_create_paged)
+typedef struct buffer_frame
+{
+	int64_t page; //page held by the frame (-1 if none)
+	int pins; //# of pins holding the page in the frame (see oid_pin)
+	int dirty; //1 if the page changed since it was read
+	int ref; //set when the page is used, cleared as the CLOCK hand passes
+	int chain; //next frame in the same hash bucket (-1 at the end)
+} buffer_frame;
+
+//For the page cache of an out-of-core pool
+typedef struct pool_buffer
+{
+	int fd; //file holding the pool's pages and large blobs
+	char* filename;
+	int64_t cache_bytes; //memory the frames were sized for
+	buffer_frame* frames;
+	int frame_count;
+	OID* oids; //objects of the page in each frame, BUFFER_PAGE_OIDS per frame
+	pfile_entry* recs; //slots of the page in each frame as last read or written (type 0 for slots written since)
+	int* buckets; //first frame of each hash bucket of pages (-1 if none)
+	int bucket_mask; //# of buckets - 1
+	int hand; //frame the CLOCK hand is at
+	int pinned; //# of frames pinned by oid_pin
+	int64_t* page_pos; //position of each page in the file (-1 for pages never written, which are empty)
+	int64_t page_count; //# of pages of the pool
+	int64_t page_cap; //# of pages page_pos has room for
+	uint64_t end; //end of the file, where pages and large blobs are added
+	int64_t first_empty; //pages before this one are full
+	int64_t last_miss; //page read in last, to spot scans
+	int64_t ahead; //last page the kernel was asked to read ahead
+} pool_buffer;
+
+//For a piece of the text of a text pool (see pool_create_text): a run of bytes that never change, in a treap
+//ordered by position in the text, so the piece holding an offset is found in O(log n)
+typedef struct text_piece
+{
+	const char* bytes; //first byte of the piece, in a file read in or in the inserted text
+	int64_t len; //# of bytes of the piece
+	int64_t total; //# of bytes of the piece and the pieces under it
+	uint32_t prio; //random heap priority, which keeps the treap O(log n) deep
+	struct text_piece * left;
+	struct text_piece * right;
+} text_piece;
+
+//For the text of a text pool
+typedef struct pool_text
+{
+	text_piece* tree; //pieces of the text in order (NULL while the text is empty)
+	char* add; //chunk inserted text is copied into, only ever appended to
+	size_t add_used; //# of bytes of add in use
+	size_t add_cap; //# of bytes of add
+	int64_t pieces; //# of pieces in the tree
+	uint64_t rand; //state of the priorities
+} pool_text;
+
+//For a hash map being resized (see phash_rehash): its blob is already the new table, and the keys left in the old
+//table are moved a few groups at a time by writes to the map
+typedef struct phash_move
+{
+	OID * map; //the hash map
+	char* old; //blob of the old table, kept until every key has left it
+	size_t old_bytes; //# of bytes of old
+	uint64_t next; //first group of old not moved yet
+	uint64_t left; //# of keys still in old
+} phash_move;
+
 //For a pool
 typedef struct pool
 {
 	OID * root; //Linked list of OIDs starting at root OID
-	int size; //# of objects in pool
+	int64_t size; //# of objects in pool
 	int closed; //whether the pool is open or not
 	const char* name; //name of pool
+	index_seg * index; //segments of the index in a treap, for random access (NULL while the pool has no objects in memory)
+	int64_t segments; //# of segments of the index
+	uint64_t index_rand; //state of the priorities of the segments
+	oid_block * blocks; //LL of OID blocks owned by the pool
+	OID * spare; //unused OIDs of the last spare block
+	int64_t spare_count; //# of OIDs left at spare
+	const char* map; //binary file mapped as the pool's storage (NULL if none)
+	size_t map_len; //# of bytes mapped
+	int map_version; //format of the mapped file (0=plain ints, 1=sized records, 2=pfile_header)
+	uint64_t* map_pos; //position of each record of a mapped version 1 file
+	const pfile_entry* map_dir; //directory of a mapped version 2 file
+	uint64_t map_data_pos; //position of the data area of a mapped version 2 file
+	pfile_header map_header; //header of a mapped version 2 file in host order, which entries are checked against when used
+	const char** map_names; //pool names of oidptrs in a mapped version 2 file
+	uint32_t map_name_count; //# of pool names in map_names
+	uint32_t trace_id; //# of the pool in the trace being recorded (see trace_pool_id)
+	uint32_t trace_gen; //trace that trace_id belongs to
+	uint32_t sim_id; //# of the pool for the translation simulator (see polb_sim)
+	char* hibernate; //file the pool is written to and released into when it is closed (NULL to stay in memory)
+	int hibernated; //1 while the pool's objects are only in the hibernate file
+	int64_t pointers_in; //oidptrs other pools hold into the pool, which keep it from hibernating
+	int64_t pointers_out; //oidptrs the pool holds into other pools
+	pool_buffer * buffer; //page cache of an out-of-core pool (NULL if the pool is in memory, see pool_create_paged)
+	pool_text * text; //pieces of a text pool (NULL for pools of objects, see pool_create_text)
+	phash_move * hash_moves; //hash maps of the pool being resized
+	int hash_move_count; //# of hash_moves in use
+	int hash_move_cap; //# of hash_moves allocated
+	pthread_mutex_t lock; //held by every call on the pool (recursive, as calls make other calls)
+	pool_arena arena; //memory of the pool's OIDs and blobs
+	struct pool_stats stats; //counters (zero if NVMLIB_STATS is 0)
 	struct pool * next;
 } pool;
 pool* head_pool = NULL; //initializes the LL of pools with head indicator
 
+//For a read-only view of a run of objects of the same type
+typedef struct pview
+{
+	const OID * oids; //first OID of the run, for runs of OIDs adjacent in memory (else NULL)
+	const char * raw; //first data of the run, for runs still in the pool's mapped file (else NULL)
+	size_t stride; //# of bytes from one data of a raw run to the next
+	int64_t len; //# of objects in the run (0 if no run at the requested offset)
+	int data_type; //type shared by every object in the run
+} pview;
 
-//POOL MANAGEMENT
+//For the header at the start of the blob of a vector (see pvec_create), little-endian like a binary file.
+//The elements follow it; the blob is as long as the capacity, so pfileout and pfilein keep the vector as it is.
+typedef struct pvec_header
+{
+	uint32_t magic; //PVEC_MAGIC
+	uint32_t elem_size; //# of bytes of an element
+	uint64_t size; //# of elements in use
+	uint64_t capacity; //# of elements the blob has room for
+	uint64_t reserved; //keeps the elements 16-byte aligned
+} pvec_header;
 
-//Create a pool with specified size (in # of objects) and a name.
-pool* pool_create(const char* name, int size)
+//For the header at the start of the blob of a hash map (see phash_create), little-endian like a binary file.
+//A control byte for each slot follows it (PHASH_EMPTY, PHASH_DELETED or the low 7 bits of the hash of the slot's key),
+//then the slots, each a key and then a value padded to 8 bytes.
+typedef struct phash_header
 {
-	pool* p = malloc(sizeof(pool)); //creates pool pointer
-	p->size = size; //sets pool size (# of objects);
-	p->closed = 0;
-	p->name = name; //sets pool name
-	p->next = NULL; //sets NULL pointer to next pool
+	uint32_t magic; //PHASH_MAGIC
+	uint32_t key_size; //# of bytes of a key
+	uint32_t value_size; //# of bytes of a value
+	uint32_t kind; //0, or PDIR_MAGIC for the directory of a pool (see pool_dir_create)
+	uint64_t count; //# of keys in the map (in both tables while it is resized)
+	uint64_t capacity; //# of slots, a power of 2 and at least PHASH_MIN_CAP
+	uint64_t deleted; //# of slots holding PHASH_DELETED
+	uint64_t reserved2; //keeps the control bytes 16-byte aligned
+} phash_header;
 
-	if (head_pool == NULL) //inserts pool in the proper LL position
+//For the header of a B+-tree (see pbtree_create), which takes the place of node 0 of its blob so 0 can mean no node.
+//The blob is an array of PBTREE_NODE_SIZE byte nodes; everything is little-endian like a binary file.
+typedef struct pbtree_header
+{
+	uint32_t magic; //PBTREE_MAGIC
+	uint32_t key_type; //PBTREE_INT or PBTREE_STR
+	uint32_t key_size; //# of bytes of a key (8 for PBTREE_INT)
+	uint32_t value_size; //# of bytes of a value
+	uint64_t count; //# of keys in the tree
+	uint64_t root; //node of the root (0 while the tree is empty)
+	uint64_t nodes; //# of nodes the blob has room for, node 0 included
+	uint64_t used; //# of nodes handed out, node 0 included
+	uint64_t free; //first node of the list of freed nodes (0 if none)
+	uint64_t free_count; //# of nodes on the free list
+} pbtree_header;
+
+//For the start of a node of a B+-tree. A leaf then holds its keys and after them its values (padded to 8 bytes);
+//an inner node holds its keys and after them n + 1 children, child i leading to the keys below key i.
+typedef struct pbtree_node
+{
+	uint32_t leaf; //1 for a leaf, 0 for an inner node
+	uint32_t n; //# of keys
+	uint64_t next_free; //next node of the free list while the node is free
+} pbtree_node;
+
+//For a position in a B+-tree (see pbtree_seek), valid until the next write to the tree.
+//The tree keeps no links between leaves, as a write would have to copy the neighbours of each node it replaces,
+//so the iterator keeps the path from the root instead.
+typedef struct pbtree_iter
+{
+	OID * tree; //the tree
+	uint64_t path[PBTREE_MAX_HEIGHT]; //node at each level from the root down to a leaf
+	int pos[PBTREE_MAX_HEIGHT]; //child taken at each level, and the entry in the leaf
+	int depth; //level of the leaf
+	const void* key; //key of the entry (NULL once the iterator has run off either end)
+	void* value; //value of the entry
+	int64_t int_key; //key of an int tree, which key points at
+} pbtree_iter;
+
+//For the header at the start of the blob of a queue (see pqueue_create), little-endian like a binary file.
+//The head and the tail have cache lines of their own, so producers and consumers do not take lines from each other.
+//The slots follow it, each an element (PQUEUE_SPSC) or a sequence # and then the element padded to 8 bytes (PQUEUE_MPMC).
+typedef struct pqueue_header
+{
+	uint32_t magic; //PQUEUE_MAGIC
+	uint32_t kind; //PQUEUE_SPSC or PQUEUE_MPMC
+	uint32_t elem_size; //# of bytes of an element
+	uint32_t slot_size; //# of bytes of a slot
+	uint64_t capacity; //# of slots, a power of 2
+	uint64_t reserved[5];
+	uint64_t head; //position of the next element to pop (positions only go up, the slot is position % capacity)
+	uint64_t reserved2[7];
+	uint64_t tail; //position the next element is pushed at
+	uint64_t reserved3[7];
+} pqueue_header;
+
+//For the value of a name in the directory of a pool (see pool_dir_set), little-endian like a binary file
+typedef struct pdir_entry
+{
+	int64_t offset; //offset of the object, kept up to date as objects before it are freed or made
+	uint32_t kind; //PDIR_INT to PDIR_QUEUE
+	uint32_t reserved;
+	uint64_t size; //# of bytes of the object's data when it was named
+} pdir_entry;
+
+
+//BYTE ORDER AND CHECKSUMS
+
+//Convert a 32 bit value between host and little-endian order
+uint32_t le32(uint32_t x)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap32(x);
+#else
+	return x;
+#endif
+}
+
+//Convert a 64 bit value between host and little-endian order
+uint64_t le64(uint64_t x)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap64(x);
+#else
+	return x;
+#endif
+}
+
+uint32_t crc32c_table[256]; //for processors without CRC32C instructions
+int crc32c_hw_ok = 0; //1 if the processor has CRC32C instructions
+pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+//CRC32C one byte at a time from a table
+uint32_t crc32c_sw(uint32_t crc, const unsigned char* buf, size_t len)
+{
+	while (len > 0)
 	{
-		head_pool = p;
+		crc = crc32c_table[(crc ^ *buf) & 0xFF] ^ (crc >> 8);
+		buf++;
+		len--;
 	}
-	else
+	return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+
+//CRC32C 8 bytes at a time with the SSE4.2 crc32 instruction
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hw(uint32_t crc, const unsigned char* buf, size_t len)
+{
+#if defined(__x86_64__)
+	uint64_t crc64 = crc;
+	while (len >= 8)
 	{
-		pool* tmp_pool = head_pool;
-		while (tmp_pool->next != NULL)
-		{
-			tmp_pool = tmp_pool->next;
-		}
-		tmp_pool->next = p;
+		uint64_t word;
+		memcpy(&word, buf, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf = buf + 8;
+		len = len - 8;
 	}
-	
-	p->root = malloc(sizeof(OID)); //allocate root OID for the pool
-	p->root->offset = 0;
-	p->root->empty = 1;	
-	p->root->next = NULL;
-	p->root->pool = p;
-	
-	OID * tmp = p->root;
-	int i;	
-	for (i = 1; i < size; i++) //allocates # of OIDs specified by size
+	crc = (uint32_t) crc64;
+#endif
+	while (len > 0)
 	{
-		tmp->next = malloc(sizeof(OID));
-		tmp->next->offset = i;
-		tmp->next->empty = 1;
-		tmp->next->next = NULL;
-		tmp->next->pool = p;
-		tmp = tmp->next;
+		crc = _mm_crc32_u8(crc, *buf);
+		buf++;
+		len--;
 	}
+	return crc;
+}
 
-	return p;
+int crc32c_has_hw()
+{
+	return __builtin_cpu_supports("sse4.2");
 }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
 
-//Reopen a pool that is previously created by the same program.
-//Permissions will be checked.
-pool* pool_open(const char* name)
+//CRC32C 8 bytes at a time with the ARMv8 crc32c instructions
+uint32_t crc32c_hw(uint32_t crc, const unsigned char* buf, size_t len)
 {
-	pool* p = head_pool;
-	
-	if (p == NULL) //NULL head_pool exception
+	while (len >= 8)
 	{
-		return NULL;
+		uint64_t word;
+		memcpy(&word, buf, 8);
+		crc = __crc32cd(crc, word);
+		buf = buf + 8;
+		len = len - 8;
 	}
-	
-	do
+	while (len > 0)
 	{
-		if (strcmp(p->name, name) == 0)
+		crc = __crc32cb(crc, *buf);
+		buf++;
+		len--;
+	}
+	return crc;
+}
+
+int crc32c_has_hw()
+{
+	return 1;
+}
+#else
+uint32_t crc32c_hw(uint32_t crc, const unsigned char* buf, size_t len)
+{
+	return crc32c_sw(crc, buf, len);
+}
+
+int crc32c_has_hw()
+{
+	return 0;
+}
+#endif
+
+//Fill in the CRC32C table and check for CRC32C instructions (once)
+void crc32c_init()
+{
+	uint32_t i;
+	for (i = 0; i < 256; i++)
+	{
+		uint32_t c = i;
+		int j;
+		for (j = 0; j < 8; j++)
 		{
-			p->closed = 0;
-			printf("Pool %s successfully opened.\n", name);
-			return p;
+			c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
 		}
-		p = p->next;
-	} 
-	while (p != NULL);
+		crc32c_table[i] = c;
+	}
+	crc32c_hw_ok = crc32c_has_hw();
+}
 
-	printf("ERROR: No pool of name %s found!\n", name);
-	return NULL;
+//CRC32C (Castagnoli) of len bytes of buf, continuing from the CRC of the bytes before them (0 to start)
+uint32_t crc32c(uint32_t crc, const void* buf, size_t len)
+{
+	pthread_once(&crc32c_once, crc32c_init);
+	crc = ~crc;
+	crc = crc32c_hw_ok ? crc32c_hw(crc, buf, len) : crc32c_sw(crc, buf, len);
+	return ~crc;
 }
 
-//Close a pool
-void pool_close(pool* p)
+//Convert every field of a pfile_header between host and little-endian order
+void pfile_header_swap(pfile_header* h)
 {
-	p->closed = 1;
+	h->magic = le32(h->magic);
+	h->version = le32(h->version);
+	h->header_size = le32(h->header_size);
+	h->chunk_size = le32(h->chunk_size);
+	h->count = le64(h->count);
+	h->names_pos = le64(h->names_pos);
+	h->names_size = le64(h->names_size);
+	h->dir_pos = le64(h->dir_pos);
+	h->data_pos = le64(h->data_pos);
+	h->data_size = le64(h->data_size);
+	h->crc_pos = le64(h->crc_pos);
+	h->name_count = le32(h->name_count);
+	h->header_crc = le32(h->header_crc);
 }
 
-//Return the root object of the pool p with specified size.
-//The root object is intended for programmers to design as a directory of the pool.
-OID* pool_root(pool* p) //, int size)
+//# of checksummed chunks in a binary file
+uint64_t pfile_chunks(const pfile_header* h)
 {
-	if (p == NULL) //pool NULL exception
+	return (h->crc_pos - h->names_pos + h->chunk_size - 1) / h->chunk_size;
+}
+
+//Read the header of a version 2 binary file of len bytes from raw into h, returns 0 if it is not one or is damaged
+int pfile_header_read(const void* raw, uint64_t len, pfile_header* h)
+{
+	if (len < sizeof(pfile_header))
 	{
-		printf("ERROR: The specified pool is NULL!\n");
-		return NULL;	
+		return 0;
 	}
-	else if (p->closed == 1) //pool closed exception
+	memcpy(h, raw, sizeof(pfile_header));
+	uint32_t crc = crc32c(0, raw, offsetof(pfile_header, header_crc));
+	pfile_header_swap(h);
+	if (h->magic != PFILE_MAGIC || h->version != PFILE_VERSION || h->header_size != sizeof(pfile_header) || h->header_crc != crc)
 	{
-		printf("ERROR: The specified pool is closed!\n");
-		return NULL;
+		return 0;
 	}
-	else
+	return h->chunk_size > 0 && h->names_pos >= h->header_size && h->names_size <= len && h->names_pos + h->names_size <= h->dir_pos
+		&& h->dir_pos % 8 == 0 && h->count <= len / sizeof(pfile_entry) && h->dir_pos + h->count * sizeof(pfile_entry) <= h->data_pos
+		&& h->data_size <= len && h->data_pos + h->data_size <= h->crc_pos && h->crc_pos <= len
+		&& h->crc_pos + pfile_chunks(h) * sizeof(uint32_t) <= len;
+}
+
+//returns 1 if directory entry e of the binary file raw with header h (see pfile_header_read) is an object whose data
+//is all in the file: a known type of the right size, and data past 8 bytes aligned and inside the data area
+int pfile_entry_check(const char* raw, const pfile_header* h, const pfile_entry* e)
+{
+	uint32_t type = le32(e->type);
+	uint32_t size = le32(e->size);
+	uint64_t value = le64(e->value);
+	if ((type == 0 && size == 0) || (type == 1 && size == sizeof(int32_t)) || (type == 2 && size == sizeof(char)) || (type == 4 && size <= sizeof(uint64_t)))
 	{
-		return p->root;
+		return 1;
+	}
+	else if ((type != 3 || size != 2 * sizeof(uint64_t)) && type != 4)
+	{
+		return 0;
 	}
+	else if (value % 8 != 0 || value > h->data_size || size > h->data_size - value)
+	{
+		return 0;
+	}
+	uint64_t name;
+	memcpy(&name, raw + h->data_pos + value, sizeof(name));
+	return type == 4 || le64(name) < h->name_count || le64(name) == UINT64_MAX; //oidptrs to NULL have no pool name
 }
 
 
-//OBJECT MANAGEMENT
+//NVM EMULATION
 
-//Allocate a chunk of persistent data of size on pool p and return the ObjectID of the first byte.
-OID* pmalloc(pool * p, int size)
+nvm_emulation nvm_emu; //costs in use (see nvm_emulate)
+int nvm_emu_on = 0; //1 if any of the costs is set
+uint64_t nvm_emu_clock = 0; //time the emulated write bandwidth is taken until (ns)
+
+//Current time in ns
+uint64_t nvm_now()
 {
-	if (p == NULL) //pool NULL exception
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+//Spin until time end (ns), returns the ns spent spinning
+uint64_t nvm_spin_until(uint64_t end)
+{
+	uint64_t start = nvm_now();
+	uint64_t now = start;
+	while (now < end)
 	{
-		printf("ERROR: The specified pool is NULL!\n");
-		return NULL;	
+		now = nvm_now();
 	}
-	else if (p->closed == 1) //pool closed exception
+	return now - start;
+}
+
+//Add the cost of reading count objects of pool p
+void nvm_read(pool* p, int64_t count)
+{
+	if (nvm_emu_on == 0 || nvm_emu.read_ns == 0)
 	{
-		printf("ERROR: The specified pool is closed!\n");
-		return NULL;
+		return;
 	}
-	else
+	POOL_STAT(p, emulated_ns, nvm_spin_until(nvm_now() + nvm_emu.read_ns * count));
+}
+
+//Add the cost of writing an object of bytes to pool p: the write latency, then waiting for the write bandwidth.
+//Writers share the bandwidth by taking turns on nvm_emu_clock.
+void nvm_write(pool* p, size_t bytes)
+{
+	if (nvm_emu_on == 0)
 	{
-		OID * newdata_root = p->root;
-		int i;
-		for (i = 1; i < p->size; i++) //cycles to last OID of pool
-		{
-			newdata_root = newdata_root->next;
-		}
-	
-		OID * tmp = newdata_root;
-		int j;	
-		for (j = p->size; j < (p->size + size); j++) //allocates # of OIDs specified by size
+		return;
+	}
+	uint64_t end = nvm_now() + nvm_emu.write_ns;
+	if (nvm_emu.write_bw > 0)
+	{
+		uint64_t take = (uint64_t) ((double) bytes * 1e9 / nvm_emu.write_bw);
+		uint64_t clock = __atomic_load_n(&nvm_emu_clock, __ATOMIC_RELAXED);
+		uint64_t next;
+		do
 		{
-			tmp->next = malloc(sizeof(OID));
-			tmp->next->offset = j;
-			//tmp->next->data = '\0';
-			tmp->next->empty = 1;
-			tmp->next->next = NULL;
-			tmp->next->pool = p;
-			tmp = tmp->next;
+			next = (clock > end ? clock : end) + take;
 		}
-
-		p->size = p->size + size; //increases size of the pool to accomadate new OIDs
-
-		return  newdata_root->next;
+		while (__atomic_compare_exchange_n(&nvm_emu_clock, &clock, next, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == 0);
+		end = next;
 	}
+	POOL_STAT(p, emulated_ns, nvm_spin_until(end));
 }
 
-//Free persistent data pointed by the OID
-void pfree(OID* oid)
+//Emulate persistent memory with the costs in e on every pool (NULL goes back to plain DRAM speed).
+//Delays are spun on the monotonic clock, so they hold up the calling thread like a slow load or store would.
+void nvm_emulate(const nvm_emulation* e)
 {
-	if (oid == NULL) //oid  NULL exception
+	if (e == NULL)
 	{
-		printf("ERROR: The specified oid is NULL!\n");	
-	}
-	else if (oid->pool->closed == 1) //pool closed exception
-	{
-		printf("ERROR: The specified pool is closed!\n");
+		memset(&nvm_emu, 0, sizeof(nvm_emu));
 	}
 	else
 	{
-		if (oid != NULL)
-		{
-			oid->pool->size = oid->pool->size - 1; //decrements size of the pool
+		nvm_emu = *e;
+	}
+	nvm_emu_clock = 0;
+	nvm_emu_on = nvm_emu.read_ns > 0 || nvm_emu.write_ns > 0 || nvm_emu.write_bw > 0 || nvm_emu.persist_ns > 0;
+}
 
-			OID * tmp = oid->pool->root;
-			int i;
-			for (i = 0; i < oid->offset - 1; i++) //cycles to OID of pool before OID to be deleted
-			{
-				tmp = tmp->next;
-			}
 
-			if (oid->offset == 0)
-			{
-				oid->pool->root = oid->next;
-			}
-			else if (oid->offset == 1)
-			{
-				oid->pool->root->next = oid->next;
-			}
-			else
-			{
-				tmp->next = tmp->next->next; //skips the pool about to be freed in LL
-			}
+//ERRORS AND LOGGING
 
-			free(oid);
+__thread int pool_errno = POOL_OK; //code of the last call of this thread that failed
+const char* pool_errors[POOL_ERRORS] = {"no error", "NULL pool or OID", "pool is closed", "pool or queue is full", "offset out of range",
+	"no such pool, key or element", "invalid argument", "file could not be opened, read or written", "damaged file", "OID already freed",
+	"already in progress", "object is empty or of another type"};
+pool_log_fn log_fn = NULL; //off until pool_log_set
+void* log_arg = NULL;
+int log_rate = 0; //messages a second (0 for all of them)
+uint64_t log_second = 0; //second log_count is counting
+int log_count = 0; //messages so far in log_second
+int log_dropped = 0; //messages not passed on since the last one that was
 
-			for (; i < tmp->pool->size - 1; i++)
-			{
-				tmp->next->offset = tmp->next->offset - 1;
-				tmp = tmp->next;
-			}
-		}
-		else
-		{
-			printf("ERROR: oid passed to pfree is NULL!\n");
-		}
-	}
+//returns a description of an error code
+const char* pool_strerror(int code)
+{
+	return code >= 0 && code < POOL_ERRORS ? pool_errors[code] : "unknown error";
 }
 
+//Send the library's messages to fn (NULL turns them off again), at most per_second of them a second (0 for no limit).
+//Messages over the limit are dropped and counted, and the count is passed on with the next message that gets through.
+void pool_log_set(pool_log_fn fn, void* arg, int per_second)
+{
+	__atomic_store_n(&log_fn, NULL, __ATOMIC_RELEASE);
+	log_arg = arg;
+	log_rate = per_second;
+	log_count = 0;
+	log_dropped = 0;
+	__atomic_store_n(&log_fn, fn, __ATOMIC_RELEASE);
+}
 
-//OID ACCESS
-
-//returns an oid at a cerain offset value
-OID* getoid(pool* p, int offset)
+//Record code as this thread's error (unless it is POOL_OK) and pass the message to the log, returns code.
+//The message is only formatted when a log is set, so failing calls cost next to nothing by default.
+int pool_log(int code, const char* format, ...)
 {
-	if (p == NULL) //pool NULL exception
+	if (code != POOL_OK)
 	{
-		printf("ERROR: The specified pool is NULL!\n");
-		return NULL;	
+		pool_errno = code;
 	}
-	else if (p->closed == 1) //pool closed exception
+	pool_log_fn fn = __atomic_load_n(&log_fn, __ATOMIC_ACQUIRE);
+	if (fn == NULL)
 	{
-		printf("ERROR: The specified pool is closed!\n");
-		return NULL;
+		return code;
 	}
-	else
+	if (log_rate > 0)
 	{
-		if (offset >= p->size)
+		uint64_t second = nvm_now() / 1000000000ULL;
+		uint64_t seen = __atomic_load_n(&log_second, __ATOMIC_RELAXED);
+		if (seen != second && __atomic_compare_exchange_n(&log_second, &seen, second, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
 		{
-			printf("ERROR: offset too large for pool size!\n");
-			return NULL;
+			__atomic_store_n(&log_count, 0, __ATOMIC_RELAXED);
 		}
-		else
+		if (__atomic_add_fetch(&log_count, 1, __ATOMIC_RELAXED) > log_rate)
 		{
-			OID * tmp = p->root;
-			while (tmp->offset != offset)
-			{
-				tmp = tmp->next;
-			}
-			return tmp;
+			__atomic_add_fetch(&log_dropped, 1, __ATOMIC_RELAXED);
+			return code;
 		}
 	}
+
+	char message[512];
+	int dropped = __atomic_exchange_n(&log_dropped, 0, __ATOMIC_RELAXED);
+	if (dropped > 0)
+	{
+		snprintf(message, sizeof(message), "%d messages were dropped", dropped);
+		fn(POOL_OK, message, log_arg);
+	}
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	fn(code, message, log_arg);
+	return code;
 }
 
-//returns a certain pool in the pool LL
-pool* getpool(const char* name)
+
+//LOCKING
+
+const char* lock_site_names[LOCK_SITES] = {"registry", "getoid", "pread", "pwrite", "pmalloc", "pfree", "file", "pool", "map",
+	"trace", "polb"};
+lock_counts* lock_all = NULL; //counts of every thread that has taken a lock
+pthread_mutex_t lock_all_lock = PTHREAD_MUTEX_INITIALIZER; //taken while a thread adds its counts to lock_all
+__thread lock_counts* lock_mine = NULL; //counts of this thread
+
+pthread_mutex_t map_lock; //taken while objects are brought into memory, which exports may do from several threads
+pthread_mutex_t registry_lock; //taken while the list of pools is used
+pthread_once_t locks_once = PTHREAD_ONCE_INIT;
+
+//Make the library's locks recursive: bringing in an oidptr can bring in the OID it points to,
+//and pool_create_map creates its pool with pool_create
+void locks_init()
 {
-	pool* p = head_pool;
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&map_lock, &attr);
+	pthread_mutex_init(&registry_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
 
-	if (p == NULL) //NULL head_pool exception
+//Take lock m for a site, counting the wait if another thread holds it
+void site_lock(pthread_mutex_t* m, int site)
+{
+#if NVMLIB_STATS
+	if (lock_mine == NULL)
 	{
-		printf("ERROR: No pools have been created yet!\n");
-		return NULL;
+		lock_mine = calloc(1, sizeof(lock_counts));
+		pthread_mutex_lock(&lock_all_lock);
+		lock_mine->next = lock_all;
+		lock_all = lock_mine;
+		pthread_mutex_unlock(&lock_all_lock);
 	}
-
-	do
+	if (pthread_mutex_trylock(m) != 0)
 	{
-		if (strcmp(p->name, name) == 0)
-		{
-			return p;
-		}
-		p = p->next;
-	} 
-	while (p->next != NULL);
+		uint64_t start = nvm_now();
+		pthread_mutex_lock(m);
+		__atomic_store_n(&lock_mine->contended[site], lock_mine->contended[site] + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&lock_mine->wait_ns[site], lock_mine->wait_ns[site] + nvm_now() - start, __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&lock_mine->acquired[site], lock_mine->acquired[site] + 1, __ATOMIC_RELAXED);
+#else
+	pthread_mutex_lock(m);
+#endif
+}
 
-	printf("ERROR: No pool of name %s found!\n", name);
-	return NULL;
+//Take the lock of pool p
+void pool_lock(pool* p, int site)
+{
+	site_lock(&p->lock, site);
 }
 
+void pool_unlock(pool* p)
+{
+	pthread_mutex_unlock(&p->lock);
+}
 
-//READING AND WRITING:
+//Take the lock of the list of pools
+void registry_lock_take()
+{
+	pthread_once(&locks_once, locks_init);
+	site_lock(&registry_lock, LOCK_REGISTRY);
+}
 
-//Write int to a pool
-void pwriteint(pool* p, int num)
+void registry_lock_give()
 {
-	if (p == NULL) //pool NULL exception
-	{
-		printf("ERROR: The specified pool is NULL!\n");	
-	}
-	else if (p->closed == 1) //pool closed exception
+	pthread_mutex_unlock(&registry_lock);
+}
+
+//Fill in up to max lock sites with the counts of every thread, returns the # of sites filled in (zero counts if NVMLIB_STATS is 0)
+int pool_lock_profile(lock_profile* out, int max)
+{
+	int n = max < LOCK_SITES ? max : LOCK_SITES;
+	int i;
+	for (i = 0; i < n; i++)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		out[i].site = lock_site_names[i];
+		out[i].acquired = 0;
+		out[i].contended = 0;
+		out[i].wait_ns = 0;
 	}
-	else
+	pthread_mutex_lock(&lock_all_lock);
+	lock_counts* c;
+	for (c = lock_all; c != NULL; c = c->next)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
-		{
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
-		}
-	
-		if (tmp->offset >= p->size || tmp->empty == 0)
+		for (i = 0; i < n; i++)
 		{
-			printf("ERROR: Pool already full!\n");
+			out[i].acquired = out[i].acquired + __atomic_load_n(&c->acquired[i], __ATOMIC_RELAXED);
+			out[i].contended = out[i].contended + __atomic_load_n(&c->contended[i], __ATOMIC_RELAXED);
+			out[i].wait_ns = out[i].wait_ns + __atomic_load_n(&c->wait_ns[i], __ATOMIC_RELAXED);
 		}
-		else
-		{
-			tmp->data = (int*) num;
-			tmp->data_size = sizeof(int);
+	}
+	pthread_mutex_unlock(&lock_all_lock);
+	return n;
+}
+
+//Start the lock counts of pool_lock_profile over
+void pool_lock_profile_reset()
+{
+	pthread_mutex_lock(&lock_all_lock);
+	lock_counts* c;
+	for (c = lock_all; c != NULL; c = c->next)
+	{
+		memset(c->acquired, 0, sizeof(c->acquired)); //threads that are counting at the time may lose a count
+		memset(c->contended, 0, sizeof(c->contended));
+		memset(c->wait_ns, 0, sizeof(c->wait_ns));
+	}
+	pthread_mutex_unlock(&lock_all_lock);
+}
+
+
+//TRACING
+
+//Calls recorded in a trace, each record is:
+//op (1 byte), ns since the last record, thread #, pool # (0 for NULL), then the op's arguments and string (see trace_ops).
+//Everything after the op is a LEB128 varint; arguments are zigzag encoded and strings are a length then their bytes.
+#define TRACE_DEFINE 1 //pool #, size, 1 if the pool existed before the trace, name (written before a pool's first record)
+#define TRACE_POOL_CREATE 2 //size
+#define TRACE_POOL_CREATE_MAP 3 //filename
+#define TRACE_POOL_OPEN 4 //name
+#define TRACE_POOL_CLOSE 5
+#define TRACE_POOL_PERSIST 6
+#define TRACE_PMALLOC 7 //size
+#define TRACE_PFREE 8 //offset
+#define TRACE_GETOID 9 //offset
+#define TRACE_PREAD 10 //offset, type read (0 for pread_type)
+#define TRACE_PVIEW 11 //offset, max_len
+#define TRACE_PWRITEINT 12 //value
+#define TRACE_PWRITECHAR 13 //value
+#define TRACE_PWRITESTR 14 //string
+#define TRACE_PWRITEPTR 15 //pool # of the target (0 for NULL), offset of the target
+#define TRACE_PWRITE_BLOB 16 //size (the bytes are not kept)
+#define TRACE_PFILEIN 17 //1 for txt, # of threads (-1 for the serial call), filename
+#define TRACE_PFILEOUT 18 //1 for txt, # of threads (-1 for the serial call), filename
+#define TRACE_POOL_DESTROY 19
+#define TRACE_POOL_RESET 20
+#define TRACE_POOL_HIBERNATE 21 //filename (empty to stay in memory)
+#define TRACE_POOL_CREATE_PAGED 22 //size, cache bytes, filename
+#define TRACE_PMALLOC_RANGE 23 //offset, count
+#define TRACE_PFREE_RANGE 24 //offset, count
+#define TRACE_POOL_CREATE_TEXT 25
+#define TRACE_PTEXT_INSERT 26 //offset, string
+#define TRACE_PTEXT_DELETE 27 //offset, length
+#define TRACE_PTEXT_REPLACE 28 //offset, length, string
+#define TRACE_PVEC_CREATE 29 //element size, capacity
+#define TRACE_PVEC_APPEND 30 //offset of the vector, # of elements (their bytes are not kept)
+#define TRACE_PVEC_RESIZE 31 //offset of the vector, size
+#define TRACE_PVEC_RESERVE 32 //offset of the vector, capacity
+#define TRACE_PHASH_CREATE 33 //key size << 32 | value size, capacity
+#define TRACE_PHASH_PUT 34 //offset of the map, first 8 bytes of the key (the rest of it and the value are not kept)
+#define TRACE_PHASH_GET 35 //offset of the map, first 8 bytes of the key
+#define TRACE_PHASH_REMOVE 36 //offset of the map, first 8 bytes of the key
+#define TRACE_PBTREE_CREATE 37 //key type << 32 | key size, value size
+#define TRACE_PBTREE_PUT 38 //offset of the tree, first 8 bytes of the key (the rest of it and the value are not kept)
+#define TRACE_PBTREE_GET 39 //offset of the tree, first 8 bytes of the key
+#define TRACE_PBTREE_REMOVE 40 //offset of the tree, first 8 bytes of the key
+#define TRACE_PBTREE_LOAD 41 //offset of the tree, # of keys (replayed as keys 0, 1, 2...)
+#define TRACE_PQUEUE_CREATE 42 //kind << 32 | element size, capacity
+#define TRACE_PQUEUE_PUSH 43 //offset of the queue, # of elements (their bytes are not kept)
+#define TRACE_PQUEUE_POP 44 //offset of the queue, # of elements
+#define TRACE_PQUEUE_RECOVER 45 //offset of the queue
+#define TRACE_POOL_DIR_CREATE 46
+#define TRACE_POOL_DIR_SET 47 //offset of the object (-1 for NULL), name
+#define TRACE_POOL_DIR_GET 48 //kind, name
+#define TRACE_POOL_DIR_REMOVE 49 //name
+#define TRACE_OPS 50
+
+//For the # of arguments of each op and whether a string follows them
+const unsigned char trace_ops[TRACE_OPS][2] = {{0, 0}, {2, 1}, {1, 0}, {0, 1}, {0, 1}, {0, 0}, {0, 0}, {1, 0}, {1, 0}, {1, 0},
+	{2, 0}, {2, 0}, {1, 0}, {1, 0}, {0, 1}, {2, 0}, {1, 0}, {2, 1}, {2, 1}, {0, 0}, {0, 0}, {0, 1}, {2, 1},
+	{2, 0}, {2, 0}, {0, 0}, {1, 1}, {2, 0}, {2, 1},
+	{2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0},
+	{2, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0},
+	{2, 0}, {2, 0}, {2, 0}, {1, 0},
+	{0, 0}, {1, 1}, {1, 1}, {0, 1}};
+
+FILE* trace_file = NULL; //trace being recorded (NULL if none)
+pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER; //taken while a record is written
+uint32_t trace_gen = 0; //# of the trace being recorded, so pools know whether their trace_id is current
+uint32_t trace_pools = 0; //# of pools given a trace_id in the trace being recorded
+uint64_t trace_last = 0; //time of the last record (ns)
+int trace_threads = 0; //# of threads that have recorded into any trace
+__thread int trace_thread = -1; //# of this thread in traces
+__thread int trace_quiet = 0; //calls made by other library calls are not recorded
+
+//Append v to buf as a LEB128 varint, returns the # of bytes
+int trace_varint(unsigned char* buf, uint64_t v)
+{
+	int n = 0;
+	while (v >= 0x80)
+	{
+		buf[n] = (unsigned char) (v | 0x80);
+		v = v >> 7;
+		n++;
+	}
+	buf[n] = (unsigned char) v;
+	return n + 1;
+}
+
+//Zigzag encode v so small negative #s stay short
+uint64_t trace_zigzag(int64_t v)
+{
+	return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+//Write the head of a record (op, time, thread, pool #) to the trace (trace_lock held)
+void trace_head(int op, uint32_t id)
+{
+	unsigned char buf[32];
+	uint64_t now = nvm_now();
+	int n = 0;
+	buf[n++] = (unsigned char) op;
+	n = n + trace_varint(buf + n, now - trace_last);
+	n = n + trace_varint(buf + n, (uint64_t) trace_thread);
+	n = n + trace_varint(buf + n, id);
+	fwrite(buf, 1, n, trace_file);
+	trace_last = now;
+}
+
+//Write a string to the trace (trace_lock held)
+void trace_string(const char* str, size_t len)
+{
+	unsigned char buf[16];
+	fwrite(buf, 1, trace_varint(buf, len), trace_file);
+	fwrite(str, 1, len, trace_file);
+}
+
+//returns the # of pool p in the trace, writing its TRACE_DEFINE record first if it has none yet (trace_lock held)
+uint32_t trace_pool_id(pool* p, int existed)
+{
+	if (p == NULL)
+	{
+		return 0;
+	}
+	if (p->trace_gen != trace_gen)
+	{
+		trace_pools++;
+		p->trace_id = trace_pools;
+		p->trace_gen = trace_gen;
+		unsigned char buf[32];
+		trace_head(TRACE_DEFINE, p->trace_id);
+		int n = trace_varint(buf, trace_zigzag(p->size));
+		n = n + trace_varint(buf + n, trace_zigzag(existed));
+		fwrite(buf, 1, n, trace_file);
+		trace_string(p->name, strlen(p->name));
+	}
+	return p->trace_id;
+}
+
+//Record a call of op on pool p with arguments a and b and string str (see the TRACE_ ops).
+//q is the pool of the target of a pwriteptr.
+void trace_call(int op, pool* p, pool* q, int64_t a, int64_t b, const char* str)
+{
+	if (__atomic_load_n(&trace_file, __ATOMIC_RELAXED) == NULL || trace_quiet > 0)
+	{
+		return;
+	}
+	site_lock(&trace_lock, LOCK_TRACE);
+	if (trace_file == NULL) //stopped while waiting
+	{
+		pthread_mutex_unlock(&trace_lock);
+		return;
+	}
+	if (trace_thread < 0)
+	{
+		trace_thread = trace_threads;
+		trace_threads++;
+	}
+
+	uint32_t id = trace_pool_id(p, op != TRACE_POOL_CREATE && op != TRACE_POOL_CREATE_MAP && op != TRACE_POOL_CREATE_PAGED
+		&& op != TRACE_POOL_CREATE_TEXT);
+	unsigned char buf[32];
+	int n = 0;
+	if (op == TRACE_PWRITEPTR)
+	{
+		a = trace_pool_id(q, 1);
+	}
+	trace_head(op, id);
+	if (trace_ops[op][0] > 0)
+	{
+		n = n + trace_varint(buf + n, trace_zigzag(a));
+	}
+	if (trace_ops[op][0] > 1)
+	{
+		n = n + trace_varint(buf + n, trace_zigzag(b));
+	}
+	fwrite(buf, 1, n, trace_file);
+	if (trace_ops[op][1] == 1)
+	{
+		trace_string(str == NULL ? "" : str, str == NULL ? 0 : strlen(str));
+	}
+	pthread_mutex_unlock(&trace_lock);
+}
+
+//Start recording every library call into a trace file, returns POOL_EIO if the file cannot be written.
+//Pools that already exist are recorded as empty pools of their size when first used.
+int pool_trace_start(const char* filename)
+{
+	site_lock(&trace_lock, LOCK_TRACE);
+	if (trace_file != NULL) //one trace at a time
+	{
+		pthread_mutex_unlock(&trace_lock);
+		return pool_log(POOL_EBUSY, "A trace is already being recorded!");
+	}
+	FILE* file_ptr = fopen(filename, "wb");
+	if (file_ptr == NULL) //unwritable file exception
+	{
+		pthread_mutex_unlock(&trace_lock);
+		return pool_log(POOL_EIO, "Could not open file %s!", filename);
+	}
+	setvbuf(file_ptr, NULL, _IOFBF, PFILE_BUF_SIZE);
+	uint32_t header[2] = {le32(TRACE_MAGIC), le32(TRACE_VERSION)};
+	fwrite(header, sizeof(uint32_t), 2, file_ptr);
+	trace_gen++;
+	trace_pools = 0;
+	trace_last = nvm_now();
+	__atomic_store_n(&trace_file, file_ptr, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&trace_lock);
+	return POOL_OK;
+}
+
+//Stop recording and close the trace file
+void pool_trace_stop()
+{
+	site_lock(&trace_lock, LOCK_TRACE);
+	if (trace_file != NULL)
+	{
+		fclose(trace_file);
+		__atomic_store_n(&trace_file, NULL, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&trace_lock);
+}
+
+
+//TRANSLATION SIMULATOR
+
+uint32_t polb_pool_ids = 0; //# of pools given a sim_id
+polb_sim** polb_sims = NULL; //POLBs fed by every OID lookup (see polb_attach)
+int polb_sim_count = 0;
+pthread_mutex_t polb_lock = PTHREAD_MUTEX_INITIALIZER; //taken while the attached POLBs are fed
+
+//Create a simulated POLB, returns NULL if the configuration is not usable
+polb_sim* polb_sim_create(const polb_config* c)
+{
+	if (c == NULL || c->entries < 1 || c->ways < 1 || c->entries % c->ways != 0 || c->table_entries < 1
+		|| c->policy < POLB_LRU || c->policy > POLB_RANDOM)
+	{
+		pool_log(POOL_EINVAL, "Bad POLB configuration!");
+		return NULL;
+	}
+	polb_sim* s = calloc(1, sizeof(polb_sim));
+	s->config = *c;
+	s->sets = c->entries / c->ways;
+	s->tags = calloc(c->entries, sizeof(uint64_t));
+	s->stamps = calloc(c->entries, sizeof(uint64_t));
+	s->table = calloc(c->table_entries, sizeof(uint32_t));
+	s->rand = 88172645463325252ULL;
+	return s;
+}
+
+void polb_sim_free(polb_sim* s)
+{
+	if (s != NULL)
+	{
+		free(s->tags);
+		free(s->stamps);
+		free(s->table);
+		free(s);
+	}
+}
+
+//Walk the pool table for pool id, adding it if it is not there, returns the # of slots looked at
+uint64_t polb_walk(polb_sim* s, uint32_t id)
+{
+	uint32_t n = (uint32_t) s->config.table_entries;
+	uint32_t slot = (id * 2654435761u) % n;
+	uint64_t probes = 1;
+	while (s->table[slot] != id && s->table[slot] != 0 && probes < n)
+	{
+		slot = (slot + 1) % n;
+		probes++;
+	}
+	if (s->table[slot] == 0)
+	{
+		s->table[slot] = id;
+	}
+	return probes;
+}
+
+//Translate object offset of pool id with a simulated POLB
+void polb_sim_access(polb_sim* s, uint32_t id, int64_t offset)
+{
+	const polb_config* c = &s->config;
+	uint64_t granule = c->granule_shift >= 40 ? 0 : (uint64_t) offset >> c->granule_shift;
+	uint64_t tag = ((uint64_t) id << 40) | (granule & ((1ULL << 40) - 1)); //pool # in the top 24 bits
+	uint64_t h = tag * 0x9E3779B97F4A7C15ULL; //sets are indexed by a multiplicative hash of the translation
+	int set = (int) ((h >> 32) % (uint64_t) s->sets);
+	uint64_t* tags = s->tags + set * c->ways;
+	uint64_t* stamps = s->stamps + set * c->ways;
+	int i;
+
+	s->clock++;
+	s->result.accesses++;
+	s->result.cycles = s->result.cycles + c->hit_cycles;
+	for (i = 0; i < c->ways; i++)
+	{
+		if (tags[i] == tag)
+		{
+			s->result.hits++;
+			if (c->policy == POLB_LRU)
+			{
+				stamps[i] = s->clock;
+			}
+			return;
+		}
+	}
+
+	s->result.misses++;
+	uint64_t probes = polb_walk(s, id);
+	s->result.probes = s->result.probes + probes;
+	s->result.cycles = s->result.cycles + c->walk_cycles + probes * c->probe_cycles;
+
+	int victim = -1;
+	for (i = 0; i < c->ways && victim < 0; i++) //fills an empty entry first
+	{
+		if (tags[i] == 0)
+		{
+			victim = i;
+		}
+	}
+	if (victim < 0 && c->policy == POLB_RANDOM)
+	{
+		s->rand ^= s->rand << 13;
+		s->rand ^= s->rand >> 7;
+		s->rand ^= s->rand << 17;
+		victim = (int) (s->rand % (uint64_t) c->ways);
+	}
+	else if (victim < 0) //LRU and FIFO both drop the oldest stamp
+	{
+		victim = 0;
+		for (i = 1; i < c->ways; i++)
+		{
+			if (stamps[i] < stamps[victim])
+			{
+				victim = i;
+			}
+		}
+	}
+	if (tags[victim] != 0)
+	{
+		s->result.evictions++;
+	}
+	tags[victim] = tag;
+	stamps[victim] = s->clock;
+}
+
+//returns the results of a simulated POLB so far
+polb_result polb_sim_result(const polb_sim* s)
+{
+	polb_result r = s->result;
+	r.hit_rate = r.accesses > 0 ? (double) r.hits / r.accesses : 0.0;
+	r.cycles_per_access = r.accesses > 0 ? (double) r.cycles / r.accesses : 0.0;
+	return r;
+}
+
+//Feed every OID lookup of every pool to the count POLBs in sims from now on (count 0 stops).
+//Several configurations can be compared on one run of a workload or trace (see pool_trace_replay).
+void polb_attach(polb_sim** sims, int count)
+{
+	pthread_mutex_lock(&polb_lock);
+	polb_sims = count > 0 ? sims : NULL;
+	__atomic_store_n(&polb_sim_count, count > 0 ? count : 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&polb_lock);
+}
+
+//Feed a lookup of an offset of pool p to the attached POLBs
+void polb_feed(pool* p, int64_t offset)
+{
+	site_lock(&polb_lock, LOCK_POLB);
+	int i;
+	for (i = 0; i < polb_sim_count; i++)
+	{
+		polb_sim_access(polb_sims[i], p->sim_id, offset);
+	}
+	pthread_mutex_unlock(&polb_lock);
+}
+
+
+//ARENAS
+
+//Set up an empty arena
+void arena_init(pool_arena* a)
+{
+	a->chunks = NULL;
+	memset(a->free_lists, 0, sizeof(a->free_lists));
+	a->used = 0;
+	pthread_mutex_init(&a->lock, NULL);
+}
+
+//returns size bytes from arena a, aligned to ARENA_ALIGN (NULL if no chunk could be mapped)
+void* arena_alloc(pool_arena* a, size_t size)
+{
+	size_t head = (sizeof(arena_chunk) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	pthread_mutex_lock(&a->lock);
+	arena_chunk* c = a->chunks;
+	if (c == NULL || c->size - c->used < size)
+	{
+		size_t len = head + size > ARENA_CHUNK_SIZE ? head + size : ARENA_CHUNK_SIZE;
+		void* m = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (m == MAP_FAILED)
+		{
+			pthread_mutex_unlock(&a->lock);
+			return NULL;
+		}
+		c = m;
+		c->size = len;
+		c->used = head;
+		if (a->chunks != NULL && len > ARENA_CHUNK_SIZE) //a chunk of its own goes behind the one being filled
+		{
+			c->next = a->chunks->next;
+			a->chunks->next = c;
+		}
+		else
+		{
+			c->next = a->chunks;
+			a->chunks = c;
+		}
+	}
+	void* ptr = (char*) c + c->used;
+	c->used = c->used + size;
+	a->used = a->used + size;
+	pthread_mutex_unlock(&a->lock);
+	return ptr;
+}
+
+//returns the size class of a blob extent of size bytes
+int arena_class(size_t size)
+{
+	int c = 0;
+	while (c + 1 < ARENA_CLASSES && ((size_t) ARENA_ALIGN << c) < size)
+	{
+		c++;
+	}
+	return c;
+}
+
+//returns the most items of each bytes that fit in a blob after a header of header bytes (see BLOB_MAX_SIZE)
+uint64_t blob_max_count(size_t header, size_t each)
+{
+	return (BLOB_MAX_SIZE - header) / each;
+}
+
+//returns an extent of at least size bytes for a blob, reusing one freed from the same size class
+void* arena_blob_alloc(pool_arena* a, size_t size)
+{
+	int c = arena_class(size);
+	pthread_mutex_lock(&a->lock);
+	void* ptr = a->free_lists[c];
+	if (ptr != NULL)
+	{
+		memcpy(&a->free_lists[c], ptr, sizeof(void*));
+		pthread_mutex_unlock(&a->lock);
+		return ptr;
+	}
+	pthread_mutex_unlock(&a->lock);
+	return arena_alloc(a, (size_t) ARENA_ALIGN << c);
+}
+
+//Give the extent of a blob of size bytes back to its arena
+void arena_blob_free(pool_arena* a, void* ptr, size_t size)
+{
+	int c = arena_class(size);
+	pthread_mutex_lock(&a->lock);
+	memcpy(ptr, &a->free_lists[c], sizeof(void*));
+	a->free_lists[c] = ptr;
+	pthread_mutex_unlock(&a->lock);
+}
+
+//Unmap every chunk of arena a, leaving it empty
+void arena_release(pool_arena* a)
+{
+	pthread_mutex_lock(&a->lock);
+	arena_chunk* c = a->chunks;
+	while (c != NULL)
+	{
+		arena_chunk* next = c->next;
+		munmap(c, c->size);
+		c = next;
+	}
+	a->chunks = NULL;
+	memset(a->free_lists, 0, sizeof(a->free_lists));
+	a->used = 0;
+	pthread_mutex_unlock(&a->lock);
+}
+
+
+//BUFFER MANAGER
+
+//An out-of-core pool (see pool_create_paged) keeps its objects in a file, BUFFER_PAGE_OIDS objects to a page of
+//pfile_entry slots, and only holds the pages of a fixed # of frames in memory. A page in a frame is decoded into OIDs
+//that getoid and the pwrite functions hand out as usual; they stay valid until their frame takes another page,
+//which can happen on the next call on the pool, unless their page is pinned (see oid_pin).
+
+int file_pwrite(int fd, const void* buf, size_t len, uint64_t pos);
+int file_pread(int fd, void* buf, size_t len, uint64_t pos);
+void oidptr_count(pool* p, const OID* target, int n);
+
+//Create the page cache of an out-of-core pool over a new file, with as many frames as fit in cache_bytes.
+//returns NULL if the file cannot be created.
+pool_buffer* buffer_create(const char* filename, int64_t cache_bytes)
+{
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) //missing file exception
+	{
+		pool_log(POOL_EIO, "Could not open file %s!", filename);
+		return NULL;
+	}
+
+	pool_buffer* b = malloc(sizeof(pool_buffer));
+	b->fd = fd;
+	b->filename = strdup(filename);
+	b->cache_bytes = cache_bytes;
+	int64_t n = cache_bytes / (int64_t) (BUFFER_PAGE_OIDS * (sizeof(OID) + sizeof(pfile_entry)) + sizeof(buffer_frame));
+	b->frame_count = n < BUFFER_MIN_FRAMES ? BUFFER_MIN_FRAMES : (n > INT32_MAX / BUFFER_PAGE_OIDS ? INT32_MAX / BUFFER_PAGE_OIDS : (int) n);
+	b->frames = malloc(b->frame_count * sizeof(buffer_frame));
+	b->oids = malloc((size_t) b->frame_count * BUFFER_PAGE_OIDS * sizeof(OID));
+	b->recs = malloc((size_t) b->frame_count * BUFFER_PAGE_OIDS * sizeof(pfile_entry));
+	b->bucket_mask = 1;
+	while (b->bucket_mask < b->frame_count) //about one frame per bucket
+	{
+		b->bucket_mask = b->bucket_mask * 2;
+	}
+	b->buckets = malloc(b->bucket_mask * sizeof(int));
+	b->bucket_mask = b->bucket_mask - 1;
+	int i;
+	for (i = 0; i <= b->bucket_mask; i++)
+	{
+		b->buckets[i] = -1;
+	}
+	for (i = 0; i < b->frame_count; i++)
+	{
+		b->frames[i].page = -1;
+		b->frames[i].pins = 0;
+		b->frames[i].dirty = 0;
+		b->frames[i].ref = 0;
+		b->frames[i].chain = -1;
+	}
+	b->hand = 0;
+	b->pinned = 0;
+	b->page_pos = NULL;
+	b->page_count = 0;
+	b->page_cap = 0;
+	b->end = 0;
+	b->first_empty = 0;
+	b->last_miss = -2;
+	b->ahead = -1;
+	return b;
+}
+
+//Close and remove the file of a page cache and free it. Blobs of its frames are in the pool's arena.
+void buffer_free(pool_buffer* b)
+{
+	close(b->fd);
+	unlink(b->filename); //the page table is only in memory, so the file cannot be used again
+	free(b->filename);
+	free(b->frames);
+	free(b->oids);
+	free(b->recs);
+	free(b->buckets);
+	free(b->page_pos);
+	free(b);
+}
+
+//Make room in the page table of b for the pages of size objects, returns POOL_OK or POOL_EFULL.
+//New pages are never written, so they read as empty.
+int buffer_reserve(pool_buffer* b, int64_t size)
+{
+	int64_t pages = (size + BUFFER_PAGE_OIDS - 1) / BUFFER_PAGE_OIDS;
+	if (pages > b->page_cap)
+	{
+		int64_t cap = b->page_cap > 0 ? b->page_cap : 64;
+		while (cap < pages)
+		{
+			cap = cap * 2;
+		}
+		int64_t* pos = realloc(b->page_pos, cap * sizeof(int64_t));
+		if (pos == NULL)
+		{
+			return pool_log(POOL_EFULL, "Could not reserve room for %lld objects!", (long long) size);
+		}
+		b->page_pos = pos;
+		b->page_cap = cap;
+	}
+	while (b->page_count < pages)
+	{
+		b->page_pos[b->page_count] = -1;
+		b->page_count++;
+	}
+	return POOL_OK;
+}
+
+//Drop every page of a page cache without writing it back and empty its file.
+//The blob copies of its frames go with the pool's arena.
+void buffer_clear(pool_buffer* b)
+{
+	int i;
+	for (i = 0; i < b->frame_count; i++)
+	{
+		b->frames[i].page = -1;
+		b->frames[i].pins = 0;
+		b->frames[i].dirty = 0;
+		b->frames[i].ref = 0;
+		b->frames[i].chain = -1;
+	}
+	for (i = 0; i <= b->bucket_mask; i++)
+	{
+		b->buckets[i] = -1;
+	}
+	int64_t k;
+	for (k = 0; k < b->page_count; k++)
+	{
+		b->page_pos[k] = -1;
+	}
+	b->hand = 0;
+	b->pinned = 0;
+	b->end = 0;
+	b->first_empty = 0;
+	b->last_miss = -2;
+	b->ahead = -1;
+	if (ftruncate(b->fd, 0) != 0)
+	{
+		pool_log(POOL_EIO, "Could not empty file %s!", b->filename);
+	}
+}
+
+//returns the frame holding a page (-1 if it is not in memory)
+int buffer_lookup(pool_buffer* b, int64_t page)
+{
+	int f = b->buckets[page & b->bucket_mask];
+	while (f >= 0 && b->frames[f].page != page)
+	{
+		f = b->frames[f].chain;
+	}
+	return f;
+}
+
+//returns the frame holding OID oid of pool p (-1 if oid is not a slot of a page in memory)
+int buffer_frame_of(pool* p, const OID* oid)
+{
+	pool_buffer* b = p->buffer;
+	if (oid < b->oids || oid >= b->oids + (size_t) b->frame_count * BUFFER_PAGE_OIDS)
+	{
+		return -1;
+	}
+	int64_t i = oid - b->oids;
+	int f = (int) (i / BUFFER_PAGE_OIDS);
+	if (b->frames[f].page < 0 || b->frames[f].page * BUFFER_PAGE_OIDS + i % BUFFER_PAGE_OIDS != oid->rel)
+	{
+		return -1;
+	}
+	return f;
+}
+
+//Mark the page of an OID written, so its frame is written back before it takes another page.
+//Every write to an OID goes through here; it does nothing for pools in memory.
+void oid_dirty(OID* oid)
+{
+	pool* p = oid->pool;
+	if (p->buffer == NULL)
+	{
+		return;
+	}
+	int f = buffer_frame_of(p, oid);
+	if (f >= 0)
+	{
+		p->buffer->frames[f].dirty = 1;
+		p->buffer->recs[oid - p->buffer->oids].type = 0; //a large blob written since gets a new place in the file
+	}
+}
+
+//Write the page of frame f of pool p back to the file, returns POOL_OK or POOL_EIO.
+//Large blobs written since the page was read are added at the end of the file first.
+int buffer_write_back(pool* p, int f)
+{
+	pool_buffer* b = p->buffer;
+	OID* oids = &b->oids[(size_t) f * BUFFER_PAGE_OIDS];
+	pfile_entry* recs = &b->recs[(size_t) f * BUFFER_PAGE_OIDS];
+	int i;
+	for (i = 0; i < BUFFER_PAGE_OIDS; i++)
+	{
+		OID* tmp = &oids[i];
+		pfile_entry* e = &recs[i];
+		uint64_t value = 0;
+		if (tmp->empty == 1)
+		{
+			e->type = 0;
+			e->size = 0;
+			e->value = 0;
+			continue;
+		}
+		else if (tmp->data_type == 1)
+		{
+			value = (uint32_t) (int) (intptr_t) tmp->data;
+		}
+		else if (tmp->data_type == 2)
+		{
+			value = (unsigned char) (char) (intptr_t) tmp->data;
+		}
+		else if (tmp->data_type == 3) //oidptrs are only good for the life of the process, like in version 1 files
+		{
+			value = (uintptr_t) tmp->data;
+		}
+		else if (tmp->data_size <= BLOB_INLINE_SIZE)
+		{
+			memcpy(&value, &tmp->data, tmp->data_size);
+			value = le64(value); //small blobs keep their bytes in the order they are in
+		}
+		else if (le32(e->type) == 4 && le32(e->size) == tmp->data_size) //still in the file
+		{
+			value = le64(e->value);
+		}
+		else
+		{
+			if (file_pwrite(b->fd, tmp->data, tmp->data_size, b->end) == 0)
+			{
+				return pool_log(POOL_EIO, "Could not write file %s!", b->filename);
+			}
+			value = b->end;
+			b->end = b->end + ((tmp->data_size + 7) & ~(uint64_t) 7);
+		}
+		e->type = le32((uint32_t) tmp->data_type);
+		e->size = le32((uint32_t) tmp->data_size);
+		e->value = le64(value);
+	}
+
+	int64_t page = b->frames[f].page;
+	if (b->page_pos[page] < 0) //pages get their place in the file when first written
+	{
+		b->page_pos[page] = (int64_t) b->end;
+		b->end = b->end + BUFFER_PAGE_OIDS * sizeof(pfile_entry);
+	}
+	if (file_pwrite(b->fd, recs, BUFFER_PAGE_OIDS * sizeof(pfile_entry), (uint64_t) b->page_pos[page]) == 0)
+	{
+		return pool_log(POOL_EIO, "Could not write file %s!", b->filename);
+	}
+	b->frames[f].dirty = 0;
+	POOL_STAT(p, page_writes, 1);
+	return POOL_OK;
+}
+
+//Read a page of pool p into frame f, decoding its slots into OIDs. Returns POOL_OK, or POOL_EIO or POOL_EFULL if
+//the page or one of its blobs could not be read in, leaving the frame holding no page.
+int buffer_read(pool* p, int f, int64_t page)
+{
+	pool_buffer* b = p->buffer;
+	OID* oids = &b->oids[(size_t) f * BUFFER_PAGE_OIDS];
+	pfile_entry* recs = &b->recs[(size_t) f * BUFFER_PAGE_OIDS];
+	if (b->page_pos[page] < 0) //never written, so every slot is empty
+	{
+		memset(recs, 0, BUFFER_PAGE_OIDS * sizeof(pfile_entry));
+	}
+	else if (file_pread(b->fd, recs, BUFFER_PAGE_OIDS * sizeof(pfile_entry), (uint64_t) b->page_pos[page]) == 0)
+	{
+		return pool_log(POOL_EIO, "Could not read page %lld of file %s!", (long long) page, b->filename);
+	}
+	else
+	{
+		POOL_STAT(p, page_reads, 1);
+	}
+
+	int i;
+	for (i = 0; i < BUFFER_PAGE_OIDS; i++)
+	{
+		OID* tmp = &oids[i];
+		uint32_t type = le32(recs[i].type);
+		uint32_t size = le32(recs[i].size);
+		uint64_t value = le64(recs[i].value);
+		tmp->data = NULL;
+		tmp->data_size = 0;
+		tmp->data_type = type;
+		tmp->empty = type == 0;
+		tmp->rel = page * BUFFER_PAGE_OIDS + i;
+		tmp->next = i + 1 < BUFFER_PAGE_OIDS ? &oids[i + 1] : NULL; //next links stop at the end of a page
+		tmp->pool = p;
+		tmp->seg = NULL;
+		if (type == 1)
+		{
+			tmp->data = (int*) (intptr_t) (int32_t) (uint32_t) value;
+			tmp->data_size = sizeof(int);
+		}
+		else if (type == 2)
+		{
+			tmp->data = (int*) (intptr_t) (char) value;
+			tmp->data_size = sizeof(int);
+		}
+		else if (type == 3)
+		{
+			tmp->data = (void*) (uintptr_t) value;
+			tmp->data_size = sizeof(void*);
+		}
+		else if (type == 4 && size <= BLOB_INLINE_SIZE)
+		{
+			memcpy(&tmp->data, &recs[i].value, size);
+			tmp->data_size = size;
+		}
+		else if (type == 4)
+		{
+			tmp->data = arena_blob_alloc(&p->arena, size);
+			tmp->data_size = size;
+			int error = tmp->data == NULL ? pool_log(POOL_EFULL, "Could not make room for a blob of page %lld of file %s!", (long long) page, b->filename)
+				: file_pread(b->fd, tmp->data, size, value) == 0 ? pool_log(POOL_EIO, "Could not read a blob of page %lld of file %s!", (long long) page, b->filename)
+				: POOL_OK;
+			if (error != POOL_OK) //gives back the blobs read in so far
+			{
+				int j;
+				for (j = 0; j <= i; j++)
+				{
+					if (oids[j].empty == 0 && oids[j].data_type == 4 && oids[j].data_size > BLOB_INLINE_SIZE && oids[j].data != NULL)
+					{
+						arena_blob_free(&p->arena, oids[j].data, oids[j].data_size);
+					}
+				}
+				return error;
+			}
+		}
+	}
+	return POOL_OK;
+}
+
+//Write the page of frame f back if it changed and take it out of memory, freeing its blob copies.
+//Returns POOL_OK, or POOL_EIO if the page could not be written back, in which case it stays in memory and changed.
+int buffer_evict(pool* p, int f)
+{
+	pool_buffer* b = p->buffer;
+	buffer_frame* fr = &b->frames[f];
+	if (fr->page < 0)
+	{
+		return POOL_OK;
+	}
+	if (fr->dirty == 1 && buffer_write_back(p, f) != POOL_OK)
+	{
+		return POOL_EIO;
+	}
+	int i;
+	for (i = 0; i < BUFFER_PAGE_OIDS; i++)
+	{
+		OID* tmp = &b->oids[(size_t) f * BUFFER_PAGE_OIDS + i];
+		if (tmp->empty == 0 && tmp->data_type == 4 && tmp->data_size > BLOB_INLINE_SIZE)
+		{
+			arena_blob_free(&p->arena, tmp->data, tmp->data_size);
+		}
+	}
+	int* link = &b->buckets[fr->page & b->bucket_mask];
+	while (*link != f)
+	{
+		link = &b->frames[*link].chain;
+	}
+	*link = fr->chain;
+	fr->page = -1;
+	fr->chain = -1;
+	return POOL_OK;
+}
+
+//returns the frame to give the next page with the CLOCK policy: the hand passes over pinned frames and clears the
+//reference bit of used ones, taking the first frame it finds unused since it last came by (-1 if every frame is pinned)
+int buffer_victim(pool_buffer* b)
+{
+	int i;
+	for (i = 0; i < 2 * b->frame_count; i++) //two turns find an unpinned frame if there is one
+	{
+		int f = b->hand;
+		b->hand = b->hand + 1 == b->frame_count ? 0 : b->hand + 1;
+		buffer_frame* fr = &b->frames[f];
+		if (fr->pins > 0)
+		{
+			continue;
+		}
+		else if (fr->page >= 0 && fr->ref == 1)
+		{
+			fr->ref = 0;
+			continue;
+		}
+		return f;
+	}
+	return -1;
+}
+
+//returns the frame holding a page of pool p, reading it in if needed. Misses on consecutive pages are taken for a scan,
+//so the kernel is asked to read the next BUFFER_READ_AHEAD pages in the background. Returns -1 after logging why if
+//every frame is pinned, the page in the frame it needs could not be written back or the page could not be read in.
+int buffer_page(pool* p, int64_t page)
+{
+	pool_buffer* b = p->buffer;
+	int f = buffer_lookup(b, page);
+	if (f >= 0)
+	{
+		b->frames[f].ref = 1;
+		return f;
+	}
+
+	if (page == b->last_miss + 1)
+	{
+		int64_t k = b->ahead > page ? b->ahead + 1 : page + 1;
+		for (; k <= page + BUFFER_READ_AHEAD && k < b->page_count; k++)
+		{
+			if (b->page_pos[k] >= 0)
+			{
+				posix_fadvise(b->fd, b->page_pos[k], BUFFER_PAGE_OIDS * sizeof(pfile_entry), POSIX_FADV_WILLNEED);
+			}
+			b->ahead = k;
+		}
+	}
+	b->last_miss = page;
+
+	f = buffer_victim(b);
+	if (f < 0) //all frames pinned exception
+	{
+		pool_log(POOL_EFULL, "Every page in memory of pool %s is pinned!", p->name);
+		return -1;
+	}
+	else if (buffer_evict(p, f) != POOL_OK || buffer_read(p, f, page) != POOL_OK)
+	{
+		return -1;
+	}
+	buffer_frame* fr = &b->frames[f];
+	fr->page = page;
+	fr->dirty = 0;
+	fr->ref = 1;
+	fr->chain = b->buckets[page & b->bucket_mask];
+	b->buckets[page & b->bucket_mask] = f;
+	return f;
+}
+
+//returns the OID at an offset of an out-of-core pool (NULL if its page could not be brought in, see buffer_page)
+OID* buffer_oid(pool* p, int64_t offset)
+{
+	int f = buffer_page(p, offset / BUFFER_PAGE_OIDS);
+	return f < 0 ? NULL : &p->buffer->oids[(size_t) f * BUFFER_PAGE_OIDS + offset % BUFFER_PAGE_OIDS];
+}
+
+//Write every changed page of pool p back to its file, returns POOL_OK or POOL_EIO
+int buffer_flush(pool* p)
+{
+	int error = POOL_OK;
+	int f;
+	for (f = 0; f < p->buffer->frame_count; f++)
+	{
+		if (p->buffer->frames[f].page >= 0 && p->buffer->frames[f].dirty == 1 && buffer_write_back(p, f) != POOL_OK)
+		{
+			error = POOL_EIO;
+		}
+	}
+	return error;
+}
+
+//returns the first OID of an out-of-core pool with no data (NULL if the pool is full or a page could not be brought in).
+//Pages before first_empty are known to be full, so writes do not read the pool from the start every time.
+OID* buffer_first_empty(pool* p)
+{
+	pool_buffer* b = p->buffer;
+	int64_t page;
+	for (page = b->first_empty; page * BUFFER_PAGE_OIDS < p->size; page++)
+	{
+		int f = buffer_page(p, page);
+		if (f < 0)
+		{
+			return NULL;
+		}
+		OID* oids = &b->oids[(size_t) f * BUFFER_PAGE_OIDS];
+		int64_t i;
+		for (i = 0; i < BUFFER_PAGE_OIDS && page * BUFFER_PAGE_OIDS + i < p->size; i++)
+		{
+			if (oids[i].empty == 1)
+			{
+				POOL_STAT(p, scan_steps, i + 1);
+				b->first_empty = page;
+				return &oids[i];
+			}
+		}
+		POOL_STAT(p, scan_steps, i);
+	}
+	b->first_empty = page;
+	return NULL;
+}
+
+//Copy the data of OID src into OID dst, leaving dst's place (offset, next, pool) as it is
+void oid_move_data(OID* dst, const OID* src)
+{
+	dst->data = src->data;
+	dst->data_size = src->data_size;
+	dst->data_type = src->data_type;
+	dst->empty = src->empty;
+}
+
+//returns the offset of an out-of-core pool past which every slot is empty: the end of the last page that was written or is in memory
+int64_t buffer_used_end(pool* p)
+{
+	pool_buffer* b = p->buffer;
+	int64_t page = (p->size + BUFFER_PAGE_OIDS - 1) / BUFFER_PAGE_OIDS - 1;
+	while (page >= 0 && b->page_pos[page] < 0 && buffer_lookup(b, page) < 0) //never written, so every slot is empty
+	{
+		page--;
+	}
+	int64_t end = (page + 1) * BUFFER_PAGE_OIDS;
+	return end < p->size ? end : p->size;
+}
+
+//Copy up to n slots of an out-of-core pool from offset src to offset dst, as many as fit in both of their pages.
+//returns the # of slots copied (-1 if either page could not be brought in)
+int64_t buffer_copy(pool* p, int64_t dst, int64_t src, int64_t n)
+{
+	pool_buffer* b = p->buffer;
+	int h = buffer_page(p, src / BUFFER_PAGE_OIDS);
+	if (h < 0)
+	{
+		return -1;
+	}
+	b->frames[h].pins++; //the source page stays while the destination page is read
+	int g = buffer_page(p, dst / BUFFER_PAGE_OIDS);
+	b->frames[h].pins--;
+	if (g < 0)
+	{
+		return -1;
+	}
+	if (n > BUFFER_PAGE_OIDS - src % BUFFER_PAGE_OIDS)
+	{
+		n = BUFFER_PAGE_OIDS - src % BUFFER_PAGE_OIDS;
+	}
+	if (n > BUFFER_PAGE_OIDS - dst % BUFFER_PAGE_OIDS)
+	{
+		n = BUFFER_PAGE_OIDS - dst % BUFFER_PAGE_OIDS;
+	}
+	size_t s = (size_t) h * BUFFER_PAGE_OIDS + src % BUFFER_PAGE_OIDS;
+	size_t d = (size_t) g * BUFFER_PAGE_OIDS + dst % BUFFER_PAGE_OIDS;
+	int64_t i;
+	for (i = 0; i < n; i++) //the slots only overlap within one page, so the copy goes the way that leaves its sources intact
+	{
+		int64_t j = d < s ? i : n - 1 - i;
+		oid_move_data(&b->oids[d + j], &b->oids[s + j]);
+		b->recs[d + j] = b->recs[s + j];
+	}
+	b->frames[g].dirty = 1;
+	return n;
+}
+
+//Empty the slots of an out-of-core pool from offset first up to last without freeing their data (pool lock held).
+//Pages never written are skipped as they are empty already. Returns POOL_OK or the error of a page not brought in.
+int buffer_empty(pool* p, int64_t first, int64_t last)
+{
+	pool_buffer* b = p->buffer;
+	while (first < last)
+	{
+		int64_t page = first / BUFFER_PAGE_OIDS;
+		int64_t n = (page + 1) * BUFFER_PAGE_OIDS < last ? (page + 1) * BUFFER_PAGE_OIDS - first : last - first;
+		if (b->page_pos[page] >= 0 || buffer_lookup(b, page) >= 0)
+		{
+			int f = buffer_page(p, page);
+			if (f < 0)
+			{
+				return pool_errno;
+			}
+			size_t s = (size_t) f * BUFFER_PAGE_OIDS + first % BUFFER_PAGE_OIDS;
+			int64_t i;
+			for (i = 0; i < n; i++)
+			{
+				OID* tmp = &b->oids[s + i];
+				tmp->data = NULL;
+				tmp->data_size = 0;
+				tmp->data_type = 0;
+				tmp->empty = 1;
+			}
+			memset(&b->recs[s], 0, n * sizeof(pfile_entry));
+			b->frames[f].dirty = 1;
+		}
+		first = first + n;
+	}
+	return POOL_OK;
+}
+
+//Remove count objects of an out-of-core pool from offset k on, moving the objects after them down page by page
+//(pool lock held). Slots past the last page ever written are empty, so the move stops there.
+//Returns POOL_OK, or the error of a page that could not be brought in, which leaves the move where it stopped.
+int buffer_remove(pool* p, int64_t k, int64_t count)
+{
+	pool_buffer* b = p->buffer;
+	int64_t used = buffer_used_end(p);
+	int64_t i;
+	for (i = k; i < k + count && i < used; i++) //gives up the data of the removed objects
+	{
+		int64_t page = i / BUFFER_PAGE_OIDS;
+		if (b->page_pos[page] < 0 && buffer_lookup(b, page) < 0)
+		{
+			i = (page + 1) * BUFFER_PAGE_OIDS - 1;
+			continue;
+		}
+		OID* tmp = buffer_oid(p, i);
+		if (tmp == NULL)
+		{
+			return pool_errno;
+		}
+		else if (tmp->empty == 0 && tmp->data_type == 3)
+		{
+			oidptr_count(p, tmp->data, -1);
+		}
+		else if (tmp->empty == 0 && tmp->data_type == 4 && tmp->data_size > BLOB_INLINE_SIZE)
+		{
+			arena_blob_free(&p->arena, tmp->data, tmp->data_size);
+		}
+	}
+
+	int64_t dst = k;
+	int64_t src = k + count;
+	while (src < used)
+	{
+		int64_t n = buffer_copy(p, dst, src, used - src);
+		if (n < 0)
+		{
+			return pool_errno;
+		}
+		POOL_STAT(p, renumber_steps, n);
+		dst = dst + n;
+		src = src + n;
+	}
+	int error = buffer_empty(p, dst, src < used ? src : used); //the copies moved the data, so it is not freed again
+	p->size = p->size - count;
+	if (k / BUFFER_PAGE_OIDS < b->first_empty)
+	{
+		b->first_empty = k / BUFFER_PAGE_OIDS;
+	}
+	return error;
+}
+
+//Make room for count empty objects at offset k of an out-of-core pool, moving the objects from k on up page by page
+//starting from the last one (pool lock held), returns POOL_OK, POOL_EFULL or the error of a page not brought in
+int buffer_insert(pool* p, int64_t k, int64_t count)
+{
+	pool_buffer* b = p->buffer;
+	int error = buffer_reserve(b, p->size + count);
+	if (error != POOL_OK)
+	{
+		return error;
+	}
+	int64_t used = buffer_used_end(p);
+	int64_t src = used;
+	int64_t dst = used + count;
+	while (src > k)
+	{
+		int64_t n = src - k;
+		if (n > (src - 1) % BUFFER_PAGE_OIDS + 1) //the run ends at the start of the page of the last slot of either side
+		{
+			n = (src - 1) % BUFFER_PAGE_OIDS + 1;
+		}
+		if (n > (dst - 1) % BUFFER_PAGE_OIDS + 1)
+		{
+			n = (dst - 1) % BUFFER_PAGE_OIDS + 1;
+		}
+		if (buffer_copy(p, dst - n, src - n, n) < 0)
+		{
+			return pool_errno;
+		}
+		POOL_STAT(p, renumber_steps, n);
+		src = src - n;
+		dst = dst - n;
+	}
+	error = buffer_empty(p, k, k + count < used ? k + count : used);
+	p->size = p->size + count;
+	if (k / BUFFER_PAGE_OIDS < b->first_empty)
+	{
+		b->first_empty = k / BUFFER_PAGE_OIDS;
+	}
+	return error;
+}
+
+
+//TEXT STORAGE
+
+//A text pool (see pool_create_text) holds one char per offset like a pool of chars, but its text is a piece table:
+//the bytes of files read in and of inserted text are never moved, and the text is the sequence of pieces of them
+//in a treap. Inserting, deleting or replacing splits the treap at the edges of the edit and joins the parts again,
+//which takes O(log n) expected in the # of pieces instead of moving every char after the edit.
+
+//returns the # of bytes of the pieces of treap t
+int64_t text_total(const text_piece* t)
+{
+	return t == NULL ? 0 : t->total;
+}
+
+//Recount the bytes under piece t after its children changed
+void text_update(text_piece* t)
+{
+	t->total = text_total(t->left) + t->len + text_total(t->right);
+}
+
+//returns a new piece of len bytes at bytes, taken from pool p's arena (NULL if the arena is out of memory)
+text_piece* text_piece_alloc(pool* p, const char* bytes, int64_t len)
+{
+	pool_text* x = p->text;
+	text_piece* t = arena_blob_alloc(&p->arena, sizeof(text_piece));
+	if (t == NULL)
+	{
+		return NULL;
+	}
+	x->rand ^= x->rand << 13; //xorshift64
+	x->rand ^= x->rand >> 7;
+	x->rand ^= x->rand << 17;
+	t->bytes = bytes;
+	t->len = len;
+	t->total = len;
+	t->prio = (uint32_t) (x->rand >> 32);
+	t->left = NULL;
+	t->right = NULL;
+	x->pieces++;
+	return t;
+}
+
+//Give the pieces of treap t back to pool p's arena (the bytes they point at stay, as other pieces may share them)
+void text_free(pool* p, text_piece* t)
+{
+	if (t != NULL)
+	{
+		text_free(p, t->left);
+		text_free(p, t->right);
+		arena_blob_free(&p->arena, t, sizeof(text_piece));
+		p->text->pieces--;
+	}
+}
+
+//returns the treap of the pieces of a followed by those of b
+text_piece* text_merge(text_piece* a, text_piece* b)
+{
+	if (a == NULL)
+	{
+		return b;
+	}
+	else if (b == NULL)
+	{
+		return a;
+	}
+	else if (a->prio > b->prio)
+	{
+		a->right = text_merge(a->right, b);
+		text_update(a);
+		return a;
+	}
+	b->left = text_merge(a, b->left);
+	text_update(b);
+	return b;
+}
+
+//Split treap t into the first pos bytes (l) and the rest (r), cutting the piece pos falls in two.
+//The second half of a cut piece is *spare, made beforehand so a split cannot fail; *spare is NULL once it is used.
+void text_split(text_piece* t, int64_t pos, text_piece** l, text_piece** r, text_piece** spare)
+{
+	if (t == NULL)
+	{
+		*l = NULL;
+		*r = NULL;
+		return;
+	}
+	int64_t left = text_total(t->left);
+	if (pos <= left)
+	{
+		text_split(t->left, pos, l, &t->left, spare);
+		text_update(t);
+		*r = t;
+	}
+	else if (pos >= left + t->len)
+	{
+		text_split(t->right, pos - left - t->len, &t->right, r, spare);
+		text_update(t);
+		*l = t;
+	}
+	else //the second half takes t's place over its right subtree, with t's priority so both stay heaps
+	{
+		text_piece* n = *spare;
+		*spare = NULL;
+		n->bytes = t->bytes + (pos - left);
+		n->len = t->len - (pos - left);
+		n->prio = t->prio;
+		n->right = t->right;
+		t->right = NULL;
+		t->len = pos - left;
+		text_update(n);
+		text_update(t);
+		*l = t;
+		*r = n;
+	}
+}
+
+//returns where len bytes of str are kept for pool p's text, copied to the end of the chunk of inserted text
+//(NULL if no chunk could be made for them)
+const char* text_add(pool* p, const char* str, size_t len)
+{
+	pool_text* x = p->text;
+	if (x->add == NULL || x->add_cap - x->add_used < len)
+	{
+		size_t cap = len > TEXT_ADD_CHUNK ? len : TEXT_ADD_CHUNK;
+		char* add = arena_alloc(&p->arena, cap);
+		if (add == NULL)
+		{
+			pool_log(POOL_EFULL, "Could not make room for %llu bytes of text in pool %s!", (unsigned long long) len, p->name);
+			return NULL;
+		}
+		x->add = add;
+		x->add_cap = cap;
+		x->add_used = 0;
+	}
+	char* bytes = x->add + x->add_used;
+	memcpy(bytes, str, len);
+	x->add_used = x->add_used + len;
+	return bytes;
+}
+
+//Replace del bytes at offset pos of pool p's text with len bytes at bytes, which stay where they are (pool lock held).
+//Bytes that carry on from the piece before pos (text typed in one go) make that piece longer instead of adding one.
+//The pieces the edit may need are made first, so the text is left as it was if they cannot be.
+//returns POOL_OK or POOL_EFULL (bytes NULL is text_add having failed)
+int text_edit(pool* p, int64_t pos, int64_t del, const char* bytes, int64_t len)
+{
+	pool_text* x = p->text;
+	if (len > 0 && bytes == NULL)
+	{
+		return POOL_EFULL;
+	}
+	else if (del == 0 && len == 0)
+	{
+		return POOL_OK;
+	}
+	text_piece* cut = text_piece_alloc(p, NULL, 0);
+	text_piece* cut_end = del > 0 ? text_piece_alloc(p, NULL, 0) : NULL;
+	text_piece* add = len > 0 ? text_piece_alloc(p, bytes, len) : NULL;
+	if (cut == NULL || (del > 0 && cut_end == NULL) || (len > 0 && add == NULL))
+	{
+		text_free(p, cut);
+		text_free(p, cut_end);
+		text_free(p, add);
+		return pool_log(POOL_EFULL, "Could not make room for the pieces of the text of pool %s!", p->name);
+	}
+
+	text_piece* l;
+	text_piece* m;
+	text_piece* r;
+	text_split(x->tree, pos, &l, &r, &cut);
+	if (del > 0)
+	{
+		text_split(r, del, &m, &r, &cut_end);
+		text_free(p, m);
+	}
+	text_piece* last = l;
+	while (add != NULL && last != NULL && last->right != NULL)
+	{
+		last = last->right;
+	}
+	if (add != NULL && last != NULL && last->bytes + last->len == bytes)
+	{
+		last->len = last->len + len;
+		text_piece* t;
+		for (t = l; t != NULL; t = t->right) //the pieces above it are on the right spine
+		{
+			t->total = t->total + len;
+		}
+		text_free(p, add);
+	}
+	else if (add != NULL)
+	{
+		l = text_merge(l, add);
+	}
+	x->tree = text_merge(l, r);
+	text_free(p, cut); //spares the splits did not use
+	text_free(p, cut_end);
+	p->size = p->size - del + len;
+	return POOL_OK;
+}
+
+//Insert len bytes at bytes at offset pos of pool p's text (pool lock held), returns POOL_OK or POOL_EFULL
+int text_insert(pool* p, int64_t pos, const char* bytes, int64_t len)
+{
+	return text_edit(p, pos, 0, bytes, len);
+}
+
+//Delete len bytes at offset pos of pool p's text (pool lock held), returns POOL_OK or POOL_EFULL
+int text_delete(pool* p, int64_t pos, int64_t len)
+{
+	return text_edit(p, pos, len, NULL, 0);
+}
+
+//returns the piece of pool p's text holding offset pos and stores the offset of pos in the piece in at
+const text_piece* text_find(pool* p, int64_t pos, int64_t* at)
+{
+	const text_piece* t = p->text->tree;
+	while (t != NULL)
+	{
+		int64_t left = text_total(t->left);
+		if (pos < left)
+		{
+			t = t->left;
+		}
+		else if (pos < left + t->len)
+		{
+			*at = pos - left;
+			return t;
+		}
+		else
+		{
+			pos = pos - left - t->len;
+			t = t->right;
+		}
+	}
+	return NULL;
+}
+
+//Write the pieces of treap t to file_ptr in order, returns 0 if a write failed
+int text_write(const text_piece* t, FILE* file_ptr)
+{
+	if (t == NULL)
+	{
+		return 1;
+	}
+	int ok = text_write(t->left, file_ptr);
+	ok = ok && fwrite(t->bytes, 1, t->len, file_ptr) == (size_t) t->len;
+	return ok && text_write(t->right, file_ptr);
+}
+
+//Add the bytes of file filename to the end of pool p's text as one piece (pool lock held), returns POOL_OK, POOL_EIO or POOL_EFULL
+int text_read_file(pool* p, const char* filename)
+{
+	FILE* file_ptr = fopen(filename, "r");
+	if (file_ptr == NULL) //missing file exception
+	{
+		return pool_log(POOL_EIO, "Could not open file %s!", filename);
+	}
+	struct stat st;
+	int error = POOL_OK;
+	if (fstat(fileno(file_ptr), &st) != 0)
+	{
+		error = pool_log(POOL_EIO, "Could not read file %s!", filename);
+	}
+	else if (st.st_size > 0)
+	{
+		char* bytes = arena_alloc(&p->arena, st.st_size);
+		size_t len = bytes == NULL ? 0 : fread(bytes, 1, st.st_size, file_ptr);
+		if (bytes == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Could not make room for the %lld bytes of file %s!", (long long) st.st_size, filename);
+		}
+		else if ((error = text_insert(p, p->size, bytes, len)) == POOL_OK)
+		{
+			nvm_write(p, len);
+			POOL_STAT(p, bytes_imported, len);
+		}
+	}
+	fclose(file_ptr);
+	return error;
+}
+
+//Empty the text of pool p once its arena is released (pool lock held)
+void text_clear(pool* p)
+{
+	p->text->tree = NULL;
+	p->text->add = NULL;
+	p->text->add_used = 0;
+	p->text->add_cap = 0;
+	p->text->pieces = 0;
+	p->size = 0;
+}
+
+
+//HASH TABLES
+
+//The table of a hash map (see phash_create) is open addressing in the style of SwissTable: the slots are probed
+//PHASH_GROUP at a time, and the control bytes of a group are compared with the 7 bits of hash kept for each key in one
+//SSE2 compare, so a lookup reads the control bytes of a group and then the slot whose bits match, two cache misses
+//in most cases. A map that fills up gets a new table (see phash_rehash) and its keys are moved into it a few groups
+//per write instead of all at once; the pool keeps the old table until the last key has left it.
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//returns the hash of len bytes at key, the same on every machine so a table can be written out and read back
+uint64_t phash_hash(const void* key, size_t len)
+{
+	const unsigned char* k = key;
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ (len * 0xC2B2AE3D27D4EB4FULL);
+	uint64_t word;
+	while (len >= 8)
+	{
+		memcpy(&word, k, 8);
+		h = (h ^ (le64(word) * 0xC2B2AE3D27D4EB4FULL)) * 0x9E3779B97F4A7C15ULL;
+		h = h ^ (h >> 29);
+		k = k + 8;
+		len = len - 8;
+	}
+	word = 0;
+	size_t i;
+	for (i = 0; i < len; i++) //the last bytes are read as a little-endian word
+	{
+		word = word | (uint64_t) k[i] << (8 * i);
+	}
+	h = (h ^ (word * 0xC2B2AE3D27D4EB4FULL)) * 0x9E3779B97F4A7C15ULL;
+	h = (h ^ (h >> 32)) * 0xFF51AFD7ED558CCDULL; //mixes the high bits into the low 7 kept in the control bytes
+	return h ^ (h >> 33);
+}
+
+//returns a bit for each of the PHASH_GROUP control bytes at ctrl that equals c
+unsigned phash_match(const unsigned char* ctrl, unsigned char c)
+{
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+	return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) c)));
+#else
+	unsigned bits = 0;
+	int i;
+	for (i = 0; i < PHASH_GROUP; i++)
+	{
+		bits = bits | (unsigned) (ctrl[i] == c) << i;
+	}
+	return bits;
+#endif
+}
+
+//returns a bit for each of the PHASH_GROUP control bytes at ctrl that is PHASH_EMPTY or PHASH_DELETED (the high bit set)
+unsigned phash_match_free(const unsigned char* ctrl)
+{
+#if defined(__SSE2__)
+	return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) ctrl));
+#else
+	unsigned bits = 0;
+	int i;
+	for (i = 0; i < PHASH_GROUP; i++)
+	{
+		bits = bits | (unsigned) (ctrl[i] >> 7) << i;
+	}
+	return bits;
+#endif
+}
+
+//returns the # of bytes of a slot of table h
+size_t phash_slot_size(const phash_header* h)
+{
+	return PHASH_PAD(le32(h->key_size)) + PHASH_PAD(le32(h->value_size));
+}
+
+//returns the # of bytes of the blob of a table of cap slots of slot_size bytes
+size_t phash_bytes(uint64_t cap, size_t slot_size)
+{
+	return sizeof(phash_header) + cap + cap * slot_size;
+}
+
+//returns slot i of table h
+char* phash_slot(phash_header* h, uint64_t i)
+{
+	return (char*) (h + 1) + le64(h->capacity) + i * phash_slot_size(h);
+}
+
+//returns the slot of table h holding key, whose hash is hash, or -1 if the key is not in the table
+int64_t phash_find(phash_header* h, const void* key, uint64_t hash)
+{
+	const unsigned char* ctrl = (const unsigned char*) (h + 1);
+	uint64_t mask = le64(h->capacity) / PHASH_GROUP - 1;
+	uint64_t g = (hash >> 7) & mask;
+	uint64_t step;
+	for (step = 1; step <= mask + 1; step++) //the steps grow by one group each, so every group is visited once
+	{
+		unsigned bits = phash_match(ctrl + g * PHASH_GROUP, (unsigned char) (hash & 0x7F));
+		while (bits != 0)
+		{
+			uint64_t i = g * PHASH_GROUP + __builtin_ctz(bits);
+			if (memcmp(phash_slot(h, i), key, le32(h->key_size)) == 0)
+			{
+				return (int64_t) i;
+			}
+			bits = bits & (bits - 1);
+		}
+		if (phash_match(ctrl + g * PHASH_GROUP, PHASH_EMPTY) != 0) //the key would have been put in this group
+		{
+			return -1;
+		}
+		g = (g + step) & mask;
+	}
+	return -1;
+}
+
+//Put key and value (zeroed if NULL) in the first free slot on the key's probe sequence of table h (pool lock held).
+//The key is not in the table, and the table always has an empty slot as it is never filled past 7/8.
+void phash_place(pool* p, phash_header* h, const void* key, const void* value, uint64_t hash)
+{
+	unsigned char* ctrl = (unsigned char*) (h + 1);
+	uint64_t mask = le64(h->capacity) / PHASH_GROUP - 1;
+	uint64_t g = (hash >> 7) & mask;
+	uint64_t step = 1;
+	unsigned bits = phash_match_free(ctrl + g * PHASH_GROUP);
+	while (bits == 0)
+	{
+		g = (g + step) & mask;
+		step++;
+		bits = phash_match_free(ctrl + g * PHASH_GROUP);
+	}
+	uint64_t i = g * PHASH_GROUP + __builtin_ctz(bits);
+	if (ctrl[i] == PHASH_DELETED)
+	{
+		h->deleted = le64(le64(h->deleted) - 1);
+	}
+	size_t key_size = le32(h->key_size);
+	size_t value_size = le32(h->value_size);
+	char* slot = phash_slot(h, i);
+	memcpy(slot, key, key_size);
+	if (value != NULL)
+	{
+		memcpy(slot + PHASH_PAD(key_size), value, value_size);
+	}
+	else
+	{
+		memset(slot + PHASH_PAD(key_size), 0, value_size);
+	}
+	__atomic_store_n(&ctrl[i], (unsigned char) (hash & 0x7F), __ATOMIC_RELEASE); //the slot is written before it counts
+	nvm_write(p, key_size + value_size + 1);
+}
+
+//Empty slot i of table h (pool lock held). A group with an empty slot ends every probe that reaches it, so the slot
+//can be made empty again if its group has one; otherwise it is marked deleted to keep later keys reachable.
+void phash_erase(pool* p, phash_header* h, uint64_t i)
+{
+	unsigned char* ctrl = (unsigned char*) (h + 1);
+	if (phash_match(ctrl + (i / PHASH_GROUP) * PHASH_GROUP, PHASH_EMPTY) != 0)
+	{
+		ctrl[i] = PHASH_EMPTY;
+	}
+	else
+	{
+		ctrl[i] = PHASH_DELETED;
+		h->deleted = le64(le64(h->deleted) + 1);
+	}
+	nvm_write(p, 1);
+}
+
+//returns the move of hash map m of pool p, or NULL if m is not being resized (pool lock held)
+phash_move* phash_moving(pool* p, const OID* m)
+{
+	int i;
+	for (i = 0; i < p->hash_move_count; i++)
+	{
+		if (p->hash_moves[i].map == m)
+		{
+			return &p->hash_moves[i];
+		}
+	}
+	return NULL;
+}
+
+//Move the keys of up to groups groups of the old table of move mv of pool p into the map's table (pool lock held).
+//Once the old table is empty it is freed and the move ends, so mv must not be used again after that.
+void phash_step(pool* p, phash_move* mv, uint64_t groups)
+{
+	phash_header* old = (phash_header*) mv->old;
+	phash_header* h = mv->map->data;
+	unsigned char* ctrl = (unsigned char*) (old + 1);
+	uint64_t group_count = le64(old->capacity) / PHASH_GROUP;
+	size_t key_size = le32(old->key_size);
+	for (; groups > 0 && mv->next < group_count && mv->left > 0; groups--)
+	{
+		unsigned bits = ~phash_match_free(ctrl + mv->next * PHASH_GROUP) & ((1U << PHASH_GROUP) - 1);
+		while (bits != 0)
+		{
+			uint64_t i = mv->next * PHASH_GROUP + __builtin_ctz(bits);
+			const char* slot = phash_slot(old, i);
+			phash_place(p, h, slot, slot + PHASH_PAD(key_size), phash_hash(slot, key_size));
+			ctrl[i] = PHASH_DELETED; //lookups still probing the old table must not find the key there
+			mv->left--;
+			bits = bits & (bits - 1);
+		}
+		mv->next++;
+	}
+	if (mv->next == group_count || mv->left == 0)
+	{
+		arena_blob_free(&p->arena, mv->old, mv->old_bytes);
+		p->hash_move_count--;
+		*mv = p->hash_moves[p->hash_move_count];
+	}
+}
+
+//Finish every move of pool p (pool lock held), so the blob of each hash map holds all of its keys
+//before the pool is written out
+void phash_settle(pool* p)
+{
+	while (p->hash_move_count > 0)
+	{
+		phash_step(p, &p->hash_moves[p->hash_move_count - 1], UINT64_MAX);
+	}
+}
+
+//Forget the move of hash map m of pool p, whose blob is being freed (pool lock held)
+void phash_drop(pool* p, const OID* m)
+{
+	phash_move* mv = phash_moving(p, m);
+	if (mv != NULL)
+	{
+		arena_blob_free(&p->arena, mv->old, mv->old_bytes);
+		p->hash_move_count--;
+		*mv = p->hash_moves[p->hash_move_count];
+	}
+}
+
+//Give hash map m of pool p, whose table is h, a new table of cap slots and start moving its keys into it
+//(pool lock held), returns the new table or NULL if out of memory. Out-of-core pools move every key at once,
+//as the OID of the map does not stay in memory between calls.
+phash_header* phash_rehash(pool* p, OID* m, phash_header* h, uint64_t cap)
+{
+	if (p->hash_move_count == p->hash_move_cap)
+	{
+		int move_cap = p->hash_move_cap * 2 + 4;
+		phash_move* moves = realloc(p->hash_moves, move_cap * sizeof(phash_move));
+		if (moves == NULL)
+		{
+			pool_log(POOL_EFULL, "Could not resize hash map!");
+			return NULL;
+		}
+		p->hash_moves = moves;
+		p->hash_move_cap = move_cap;
+	}
+	size_t slot_size = phash_slot_size(h);
+	if (cap > blob_max_count(sizeof(phash_header), slot_size + 1))
+	{
+		pool_log(POOL_EFULL, "Hash map cannot grow to %llu slots!", (unsigned long long) cap);
+		return NULL;
+	}
+	size_t bytes = phash_bytes(cap, slot_size);
+	phash_header* n = arena_blob_alloc(&p->arena, bytes);
+	if (n == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not resize hash map to %llu slots!", (unsigned long long) cap);
+		return NULL;
+	}
+	*n = *h;
+	n->capacity = le64(cap);
+	n->deleted = 0;
+	memset(n + 1, PHASH_EMPTY, cap); //the slots are only read once their control bytes say they are full
+	nvm_write(p, sizeof(phash_header) + cap);
+
+	phash_move* mv = &p->hash_moves[p->hash_move_count];
+	p->hash_move_count++;
+	mv->map = m;
+	mv->old = (char*) h;
+	mv->old_bytes = m->data_size;
+	mv->next = 0;
+	mv->left = le64(h->count);
+	__atomic_store_n(&m->data, (void*) n, __ATOMIC_RELEASE); //the old table stays whole until its keys have moved
+	m->data_size = bytes;
+	oid_dirty(m);
+	if (p->buffer != NULL || mv->left == 0)
+	{
+		phash_step(p, mv, UINT64_MAX);
+	}
+	return n;
+}
+
+
+//OID STORAGE
+
+//The index of an in-memory pool is a treap of segments (see index_seg): each holds the entries of up to OID_CHUNK
+//offsets, or of any # of empty offsets while none of them is in memory. Looking an offset up descends the treap,
+//and freeing or allocating a run of objects cuts the treap at the ends of the run and joins it again, so a call
+//touches O(log n) segments and at most a few segments' entries however long the run and the pool are.
+
+//Index entries of objects that are still only in the pool's mapped file hold (# of the object in the file << 1) | 1
+int index_mapped(const OID* entry)
+{
+	return ((uintptr_t) entry & 1) == 1;
+}
+
+//returns the # of offsets of the segments of treap s
+int64_t index_total(const index_seg* s)
+{
+	return s == NULL ? 0 : s->total;
+}
+
+//Recount the offsets under segment s after its children changed, and make it their parent
+void index_update(index_seg* s)
+{
+	s->total = index_total(s->left) + s->count + index_total(s->right);
+	if (s->left != NULL)
+	{
+		s->left->parent = s;
+	}
+	if (s->right != NULL)
+	{
+		s->right->parent = s;
+	}
+}
+
+//Recount the offsets under segment s and the segments above it after the # of offsets of s changed
+void index_recount(index_seg* s)
+{
+	for (; s != NULL; s = s->parent)
+	{
+		s->total = index_total(s->left) + s->count + index_total(s->right);
+	}
+}
+
+//Make treap s the index of pool p
+void index_set(pool* p, index_seg* s)
+{
+	p->index = s;
+	if (s != NULL)
+	{
+		s->parent = NULL;
+	}
+}
+
+//returns a new segment of count empty offsets with no entries in memory, taken from pool p's arena (NULL if the arena is out of memory)
+index_seg* index_seg_alloc(pool* p, int64_t count)
+{
+	index_seg* s = arena_blob_alloc(&p->arena, sizeof(index_seg));
+	if (s == NULL)
+	{
+		return NULL;
+	}
+	p->index_rand ^= p->index_rand << 13; //xorshift64
+	p->index_rand ^= p->index_rand >> 7;
+	p->index_rand ^= p->index_rand << 17;
+	s->slots = NULL;
+	s->map_first = -1;
+	s->count = count;
+	s->cap = 0;
+	s->total = count;
+	s->prio = (uint32_t) (p->index_rand >> 32);
+	s->left = NULL;
+	s->right = NULL;
+	s->parent = NULL;
+	p->segments++;
+	return s;
+}
+
+//returns room for at least count index entries, all NULL, taken from pool p's arena, and stores the # it has room for in cap
+//(NULL if the arena is out of memory)
+OID** index_slots_alloc(pool* p, int64_t count, int64_t* cap)
+{
+	size_t bytes = (size_t) ARENA_ALIGN << arena_class(count * sizeof(OID*)); //the whole extent, so segments can grow into it
+	OID** slots = arena_blob_alloc(&p->arena, bytes);
+	if (slots != NULL)
+	{
+		memset(slots, 0, bytes);
+		*cap = bytes / sizeof(OID*);
+	}
+	return slots;
+}
+
+//Give segment s and its entries back to pool p's arena (its OIDs stay with their blocks)
+void index_seg_free(pool* p, index_seg* s)
+{
+	if (s->slots != NULL)
+	{
+		arena_blob_free(&p->arena, s->slots, s->cap * sizeof(OID*));
+	}
+	arena_blob_free(&p->arena, s, sizeof(index_seg));
+	p->segments--;
+}
+
+//returns the treap of the segments of a followed by those of b
+index_seg* index_merge(index_seg* a, index_seg* b)
+{
+	if (a == NULL)
+	{
+		return b;
+	}
+	else if (b == NULL)
+	{
+		return a;
+	}
+	else if (a->prio > b->prio)
+	{
+		a->right = index_merge(a->right, b);
+		index_update(a);
+		return a;
+	}
+	b->left = index_merge(a, b->left);
+	index_update(b);
+	return b;
+}
+
+//Split treap t into the segments of its first pos offsets (l) and the rest (r).
+//pos must be where a segment starts or the end of t (see index_cut), so a split never makes a segment.
+void index_split(index_seg* t, int64_t pos, index_seg** l, index_seg** r)
+{
+	if (t == NULL)
+	{
+		*l = NULL;
+		*r = NULL;
+		return;
+	}
+	int64_t left = index_total(t->left);
+	if (pos <= left)
+	{
+		index_split(t->left, pos, l, &t->left);
+		index_update(t);
+		*r = t;
+	}
+	else
+	{
+		index_split(t->right, pos - left - t->count, &t->right, r);
+		index_update(t);
+		*l = t;
+	}
+}
+
+//returns the first segment of treap s (NULL if it is empty)
+index_seg* index_first(index_seg* s)
+{
+	while (s != NULL && s->left != NULL)
+	{
+		s = s->left;
+	}
+	return s;
+}
+
+//returns the segment after s in its treap (NULL for the last one)
+index_seg* index_next(index_seg* s)
+{
+	if (s->right != NULL)
+	{
+		return index_first(s->right);
+	}
+	while (s->parent != NULL && s == s->parent->right)
+	{
+		s = s->parent;
+	}
+	return s->parent;
+}
+
+//returns the segment of pool p's index that holds an offset and stores the offset in the segment in at
+//(NULL if the offset is past the end of the index)
+index_seg* index_find(pool* p, int64_t offset, int64_t* at)
+{
+	index_seg* s = p->index;
+	while (s != NULL)
+	{
+		int64_t left = index_total(s->left);
+		if (offset < left)
+		{
+			s = s->left;
+		}
+		else if (offset < left + s->count)
+		{
+			*at = offset - left;
+			return s;
+		}
+		else
+		{
+			offset = offset - left - s->count;
+			s = s->right;
+		}
+	}
+	return NULL;
+}
+
+//returns the entry of segment s of pool p's index at offset at of it (see index_mapped). A segment with no entries of its own
+//stands for a run of objects of the mapped file or of empty OIDs, so file-backed objects take no index memory until used;
+//empty objects kept in the file by pool_hibernate are found from their directory type.
+OID* index_seg_entry(pool* p, const index_seg* s, int64_t at)
+{
+	if (s->slots != NULL)
+	{
+		return s->slots[at];
+	}
+	else if (s->map_first < 0)
+	{
+		return NULL;
+	}
+	uint64_t n = (uint64_t) (s->map_first + at);
+	if (p->map_version == 2 && le32(p->map_dir[n].type) == 0)
+	{
+		return NULL;
+	}
+	return (OID*) (uintptr_t) ((n << 1) | 1);
+}
+
+//returns the index entry at an offset of pool p (NULL for an empty OID not in memory, see index_mapped)
+OID* index_entry(pool* p, int64_t offset)
+{
+	int64_t at;
+	const index_seg* s = index_find(p, offset, &at);
+	return s == NULL ? NULL : index_seg_entry(p, s, at);
+}
+
+//returns the offset in its pool of the first offset of segment s: the offsets of the segments before it, summed up the treap
+int64_t index_start(const index_seg* s)
+{
+	int64_t start = index_total(s->left);
+	for (; s->parent != NULL; s = s->parent)
+	{
+		if (s == s->parent->right)
+		{
+			start = start + index_total(s->parent->left) + s->parent->count;
+		}
+	}
+	return start;
+}
+
+//returns the offset of an OID in its pool (pool lock held, see oid_offset)
+int64_t index_offset(const OID* oid)
+{
+	return oid->seg == NULL ? oid->rel : index_start(oid->seg) + oid->rel;
+}
+
+//returns the offset of an OID from the root OID of its pool (-1 if oid is NULL). Offsets are not kept in the OIDs,
+//as frees and allocations before an OID move it, but summed up the index when asked for, in O(log n).
+int64_t oid_offset(const OID* oid)
+{
+	if (oid == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	pool* p = oid->pool;
+	pool_lock(p, LOCK_GETOID);
+	int64_t offset = index_offset(oid);
+	pool_unlock(p);
+	return offset;
+}
+
+//returns the offset of oid to record in the trace (0 while no trace is being recorded, so calls do not look it up for nothing)
+int64_t trace_offset(const OID* oid)
+{
+	if (oid == NULL || __atomic_load_n(&trace_file, __ATOMIC_RELAXED) == NULL || trace_quiet > 0)
+	{
+		return 0;
+	}
+	return oid_offset(oid);
+}
+
+//Give the OIDs at entries [first, first + n) of segment s their place in it
+void index_own(index_seg* s, int64_t first, int64_t n)
+{
+	int64_t i;
+	for (i = first; i < first + n; i++)
+	{
+		OID* tmp = s->slots[i];
+		if (tmp != NULL && index_mapped(tmp) == 0)
+		{
+			tmp->seg = s;
+			tmp->rel = i;
+		}
+	}
+}
+
+//Make an offset of pool p the start of a segment, cutting the segment it falls in two: the entries from the offset on
+//go to a new segment after it. returns POOL_OK or POOL_EFULL (not logged), with the index unchanged.
+int index_cut(pool* p, int64_t offset)
+{
+	int64_t at;
+	index_seg* s = index_find(p, offset, &at);
+	if (s == NULL || at == 0)
+	{
+		return POOL_OK;
+	}
+	index_seg* n = index_seg_alloc(p, s->count - at);
+	if (n != NULL && s->slots != NULL && (n->slots = index_slots_alloc(p, n->count, &n->cap)) == NULL)
+	{
+		index_seg_free(p, n);
+		n = NULL;
+	}
+	if (n == NULL)
+	{
+		return POOL_EFULL;
+	}
+	if (s->slots != NULL)
+	{
+		POOL_STAT(p, renumber_steps, n->count);
+		memcpy(n->slots, &s->slots[at], n->count * sizeof(OID*));
+		index_own(n, 0, n->count);
+	}
+	else if (s->map_first >= 0)
+	{
+		n->map_first = s->map_first + at;
+	}
+	s->count = at;
+	index_recount(s);
+	index_seg* l;
+	index_seg* r;
+	index_split(p->index, offset, &l, &r);
+	index_set(p, index_merge(index_merge(l, n), r));
+	return POOL_OK;
+}
+
+//Join the segments of pool p's index on either side of an offset into one if their entries fit in OID_CHUNK,
+//or if neither has entries in memory and they stand for one run (of empty OIDs or of the mapped file), so runs of
+//small frees and allocations do not leave the index in splinters. The index is left as it is if there is no room
+//for the joined entries.
+void index_join(pool* p, int64_t offset)
+{
+	int64_t at;
+	index_seg* a = offset > 0 ? index_find(p, offset - 1, &at) : NULL;
+	index_seg* b = index_find(p, offset, &at);
+	if (a == NULL || b == NULL || a == b)
+	{
+		return;
+	}
+	int run = a->slots == NULL && b->slots == NULL && (a->map_first < 0 ? b->map_first < 0 : b->map_first == a->map_first + a->count);
+	if (run == 0 && a->count + b->count > OID_CHUNK)
+	{
+		return;
+	}
+	int64_t count = a->count + b->count;
+	OID** slots = a->slots;
+	int64_t cap = a->cap;
+	int64_t i;
+	if (run == 0 && (a->slots == NULL || a->cap < count))
+	{
+		slots = index_slots_alloc(p, count, &cap);
+		if (slots == NULL)
+		{
+			return;
+		}
+		for (i = 0; i < a->count; i++)
+		{
+			slots[i] = index_seg_entry(p, a, i);
+		}
+		if (a->slots != NULL)
+		{
+			arena_blob_free(&p->arena, a->slots, a->cap * sizeof(OID*));
+		}
+	}
+	for (i = 0; i < b->count && run == 0; i++)
+	{
+		slots[a->count + i] = index_seg_entry(p, b, i);
+	}
+
+	index_seg* l;
+	index_seg* m;
+	index_seg* r;
+	index_split(p->index, offset, &l, &r);
+	index_split(r, b->count, &m, &r);
+	index_set(p, index_merge(l, r));
+	int64_t first = a->count;
+	a->slots = slots;
+	a->cap = cap;
+	a->count = count;
+	index_recount(a);
+	if (b->slots != NULL)
+	{
+		POOL_STAT(p, renumber_steps, b->count);
+		index_own(a, first, b->count);
+	}
+	index_seg_free(p, b);
+}
+
+//Put count empty offsets with no entries in memory into pool p's index at an offset. The segments from the offset on
+//move up with it without their OIDs being renumbered. returns POOL_OK or POOL_EFULL, with the index unchanged.
+int index_insert(pool* p, int64_t offset, int64_t count)
+{
+	index_seg* n = index_seg_alloc(p, count);
+	if (n == NULL || index_cut(p, offset) != POOL_OK)
+	{
+		if (n != NULL)
+		{
+			index_seg_free(p, n);
+		}
+		return pool_log(POOL_EFULL, "Could not reserve room for %lld objects!", (long long) count);
+	}
+	index_seg* l;
+	index_seg* r;
+	index_split(p->index, offset, &l, &r);
+	index_set(p, index_merge(index_merge(l, n), r));
+	index_join(p, offset + count);
+	index_join(p, offset);
+	return POOL_OK;
+}
+
+void oidptr_count(pool* p, const OID* target, int n);
+
+//Give up what an OID being freed from pool p holds; the memory of the OID stays with its block until the pool is gone
+void oid_give_up(pool* p, OID* oid)
+{
+	if (oid->empty == 0 && oid->data_type == 3)
+	{
+		oidptr_count(p, oid->data, -1);
+	}
+	else if (oid->empty == 0 && oid->data_type == 4 && oid->data_size > BLOB_INLINE_SIZE) //frees a blob's out-of-line bytes
+	{
+		if (p->hash_move_count > 0) //a hash map being resized also holds its old table
+		{
+			phash_drop(p, oid);
+		}
+		arena_blob_free(&p->arena, oid->data, oid->data_size);
+	}
+	oid->next = NULL;
+	oid->empty = 1;
+	oid->seg = NULL; //marks it freed
+}
+
+//Give up the OIDs in memory at entries [first, first + n) of segment s of pool p (objects still in the mapped file
+//or never brought in hold nothing to give up)
+void index_give_up(pool* p, index_seg* s, int64_t first, int64_t n)
+{
+	int64_t i;
+	for (i = first; i < first + n && s->slots != NULL; i++)
+	{
+		if (s->slots[i] != NULL && index_mapped(s->slots[i]) == 0)
+		{
+			oid_give_up(p, s->slots[i]);
+		}
+	}
+}
+
+//Give up the OIDs in memory of the segments of treap t and give the segments back to pool p's arena
+void index_drop(pool* p, index_seg* t)
+{
+	if (t != NULL)
+	{
+		index_drop(p, t->left);
+		index_drop(p, t->right);
+		index_give_up(p, t, 0, t->count);
+		index_seg_free(p, t);
+	}
+}
+
+//Take count offsets out of pool p's index from an offset on, giving up their OIDs in memory. The segments after them
+//move down without their OIDs being renumbered; only a segment the run starts or ends inside moves its own entries.
+//returns POOL_OK or POOL_EFULL, with the index unchanged.
+int index_remove(pool* p, int64_t offset, int64_t count)
+{
+	int64_t at;
+	index_seg* s = index_find(p, offset, &at);
+	if (at + count <= s->count && count < s->count && (s->slots != NULL || s->map_first < 0)) //the run is inside one segment, whose entries close up over it
+	{
+		index_give_up(p, s, at, count);
+		if (s->slots != NULL)
+		{
+			int64_t after = s->count - at - count;
+			POOL_STAT(p, renumber_steps, after);
+			memmove(&s->slots[at], &s->slots[at + count], after * sizeof(OID*));
+			index_own(s, at, after);
+		}
+		s->count = s->count - count;
+		index_recount(s);
+	}
+	else if (index_cut(p, offset) != POOL_OK || index_cut(p, offset + count) != POOL_OK)
+	{
+		return pool_log(POOL_EFULL, "Could not cut the index of pool %s!", p->name);
+	}
+	else //the run is made whole segments and taken out of the treap
+	{
+		index_seg* l;
+		index_seg* m;
+		index_seg* r;
+		index_split(p->index, offset, &l, &r);
+		index_split(r, count, &m, &r);
+		index_set(p, index_merge(l, r));
+		index_drop(p, m);
+	}
+	index_join(p, offset);
+	return POOL_OK;
+}
+
+//Allocate a block of count linked, empty OIDs for pool p at entries [first, first + count) of segment seg
+//(NULL if the arena is out of memory)
+OID* oid_block_alloc(pool* p, int64_t count, index_seg* seg, int64_t first)
+{
+	oid_block* b = arena_alloc(&p->arena, sizeof(oid_block));
+	OID* oids = b == NULL ? NULL : arena_alloc(&p->arena, count * sizeof(OID));
+	if (oids == NULL)
+	{
+		return NULL;
+	}
+	b->oids = oids;
+	b->count = count;
+	b->next = p->blocks; //the pool keeps every block it owns
+	p->blocks = b;
+
+	int64_t i;
+	for (i = 0; i < count; i++)
+	{
+		OID * tmp = &b->oids[i];
+		tmp->data = NULL;
+		tmp->data_size = 0;
+		tmp->data_type = 0;
+		tmp->rel = first + i;
+		tmp->empty = 1;
+		tmp->next = (i + 1 < count) ? &b->oids[i + 1] : NULL;
+		tmp->pool = p;
+		tmp->seg = seg;
+	}
+
+	return b->oids;
+}
+
+//Take one OID from the pool's spare OIDs (NULL if the arena is out of memory)
+OID* oid_node_alloc(pool* p)
+{
+	if (p->spare_count == 0)
+	{
+		p->spare = oid_block_alloc(p, OID_SPARE_BLOCK, NULL, 0);
+		if (p->spare == NULL)
+		{
+			return NULL;
+		}
+		p->spare_count = OID_SPARE_BLOCK;
+	}
+	OID * tmp = p->spare;
+	p->spare++;
+	p->spare_count--;
+	tmp->next = NULL;
+	return tmp;
+}
+
+//returns 1 if object n of the pool's mapped file can be used in place, else logs POOL_EBADF and returns 0.
+//Directory entries of a version 2 file are only checked as their objects are used (see pfile_entry_check),
+//so mapping a file does not read its whole directory; pool_verify checks every entry.
+int map_check(pool* p, uint64_t n)
+{
+	if (p->map_version != 2 || pfile_entry_check(p->map, &p->map_header, &p->map_dir[n]) == 1)
+	{
+		return 1;
+	}
+	pool_log(POOL_EBADF, "Bad directory entry in the file of pool %s at file index %llu!", p->name, (unsigned long long) n);
+	return 0;
+}
+
+//returns where the data of object n of the pool's mapped file starts (NULL if its directory entry is bad)
+const char* map_data(pool* p, uint64_t n)
+{
+	if (p->map_version == 0)
+	{
+		return p->map + n * sizeof(int);
+	}
+	else if (p->map_version == 1)
+	{
+		return p->map + p->map_pos[n] + 2 * sizeof(uint32_t);
+	}
+	else if (map_check(p, n) == 0)
+	{
+		return NULL;
+	}
+	else if (le32(p->map_dir[n].size) <= sizeof(uint64_t)) //small data is kept in the directory entry
+	{
+		return (const char*) &(p->map_dir[n].value);
+	}
+	return p->map + p->map_data_pos + le64(p->map_dir[n].value);
+}
+
+//returns the type of data of object n of the pool's mapped file (0 if its directory entry is bad)
+int map_type(pool* p, uint64_t n)
+{
+	if (p->map_version == 0)
+	{
+		return 1;
+	}
+	else if (p->map_version == 1)
+	{
+		uint32_t type;
+		memcpy(&type, p->map + p->map_pos[n], sizeof(type));
+		return (int) type;
+	}
+	return map_check(p, n) == 0 ? 0 : (int) le32(p->map_dir[n].type);
+}
+
+OID* pfile_resolve(const char* name, int64_t offset);
+
+//Read object n of the pool's mapped file into oid (large blobs are left in the file), returns 0 if its directory entry is bad
+int map_read(pool* p, uint64_t n, OID* oid)
+{
+	if (map_check(p, n) == 0)
+	{
+		return 0;
+	}
+	const char* bytes = map_data(p, n);
+	uint32_t rec[2] = {1, sizeof(int)}; //files of plain ints only hold ints
+	if (p->map_version == 1)
+	{
+		memcpy(rec, p->map + p->map_pos[n], sizeof(rec));
+	}
+	else if (p->map_version == 2)
+	{
+		rec[0] = le32(p->map_dir[n].type);
+		rec[1] = le32(p->map_dir[n].size);
+	}
+
+	oid->data = NULL;
+	oid->data_type = rec[0];
+	oid->empty = 0;
+	oid->next = NULL;
+	oid->pool = p;
+	if (rec[0] == 1)
+	{
+		uint32_t num;
+		memcpy(&num, bytes, sizeof(uint32_t));
+		oid->data = (int*) (intptr_t) (int32_t) le32(num);
+		oid->data_size = sizeof(int);
+	}
+	else if (rec[0] == 2)
+	{
+		oid->data = (int*) (intptr_t) bytes[0];
+		oid->data_size = sizeof(int);
+	}
+	else if (rec[0] == 3 && p->map_version == 2) //oidptrs are a pool name # and an offset
+	{
+		uint64_t ref[2];
+		memcpy(ref, bytes, sizeof(ref));
+		ref[0] = le64(ref[0]);
+		oid->data = ref[0] < p->map_name_count ? pfile_resolve(p->map_names[ref[0]], (int64_t) le64(ref[1])) : NULL;
+		oid->data_size = sizeof(void*);
+	}
+	else if (rec[0] == 3)
+	{
+		memcpy(&(oid->data), bytes, sizeof(void*));
+		oid->data_size = sizeof(void*);
+	}
+	else
+	{
+		oid->data_size = rec[1];
+		if (rec[1] <= BLOB_INLINE_SIZE)
+		{
+			memcpy(&(oid->data), bytes, rec[1]);
+		}
+		else
+		{
+			oid->data = (void*) bytes;
+		}
+	}
+	return 1;
+}
+
+//Count an oidptr to target held by pool p, n being 1 when it is made and -1 when it is freed.
+//Pointers from other pools would be left dangling if target's pool hibernated, so they keep it in memory.
+void oidptr_count(pool* p, const OID* target, int n)
+{
+	if (target != NULL && target->pool != p)
+	{
+		__atomic_add_fetch(&target->pool->pointers_in, n, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&p->pointers_out, n, __ATOMIC_RELAXED);
+	}
+}
+
+OID* oid_at(pool* p, int64_t offset);
+
+
+//Point the OID before an offset at the OID at the offset (or make it the root) once either of them changes
+void oid_link(pool* p, int64_t offset)
+{
+	OID * tmp = offset < p->size ? index_entry(p, offset) : NULL;
+	if (offset == 0)
+	{
+		p->root = (tmp != NULL && index_mapped(tmp)) ? NULL : tmp;
+		if (p->root == NULL && p->size > 0) //the root is always in memory
+		{
+			p->root = oid_at(p, 0);
+		}
+		return;
+	}
+	OID * prev = offset <= p->size ? index_entry(p, offset - 1) : NULL;
+	if (prev != NULL && index_mapped(prev) == 0)
+	{
+		prev->next = (tmp != NULL && index_mapped(tmp)) ? NULL : tmp;
+	}
+}
+
+//Give the segment of pool p's index holding an offset entries of its own, cutting a segment with none down to the
+//OID_CHUNK offsets around the offset first. returns the segment and stores the offset in it in at (NULL if there was no room).
+index_seg* index_slots(pool* p, int64_t offset, int64_t* at)
+{
+	index_seg* s = index_find(p, offset, at);
+	if (s->slots != NULL)
+	{
+		return s;
+	}
+	int64_t first = offset - *at % OID_CHUNK;
+	if (index_cut(p, first) != POOL_OK || index_cut(p, first + OID_CHUNK) != POOL_OK)
+	{
+		return NULL;
+	}
+	s = index_find(p, offset, at);
+	int64_t cap;
+	OID** slots = index_slots_alloc(p, s->count, &cap);
+	if (slots == NULL)
+	{
+		return NULL;
+	}
+	int64_t i;
+	for (i = 0; i < s->count; i++) //the objects of the mapped file it stands for, or NULL
+	{
+		slots[i] = index_seg_entry(p, s, i);
+	}
+	s->slots = slots;
+	s->cap = cap;
+	return s;
+}
+
+//Bring the empty OIDs around an offset into memory in one block: the run of offsets with no OID yet that holds the offset,
+//within its segment of the index. A segment with no entries in memory is first cut down to the OID_CHUNK offsets around
+//the offset. The block is linked internally, so only its two ends are linked to the rest of the pool.
+//returns POOL_OK or POOL_EFULL.
+int oid_chunk_fill(pool* p, int64_t offset)
+{
+	int64_t at;
+	index_seg* s = index_slots(p, offset, &at);
+	if (s == NULL)
+	{
+		return pool_log(POOL_EFULL, "Could not bring the OIDs of pool %s into memory!", p->name);
+	}
+	int64_t lo = at;
+	int64_t hi = at + 1;
+	while (lo > 0 && s->slots[lo - 1] == NULL) //pfree may have moved OIDs in memory into the segment
+	{
+		lo--;
+	}
+	while (hi < s->count && s->slots[hi] == NULL)
+	{
+		hi++;
+	}
+
+	OID * tmp = oid_block_alloc(p, hi - lo, s, lo);
+	if (tmp == NULL)
+	{
+		return pool_log(POOL_EFULL, "Could not bring the OIDs of pool %s into memory!", p->name);
+	}
+	int64_t i;
+	for (i = lo; i < hi; i++)
+	{
+		s->slots[i] = &tmp[i - lo];
+	}
+	oid_link(p, offset - at + lo);
+	oid_link(p, offset - at + hi);
+	return POOL_OK;
+}
+
+//returns the OID at an offset, bringing it into memory if it is empty and not in memory yet (see oid_chunk_fill)
+//or still only in the pool's mapped file. Large blobs are copied out of the file then, so the OID can be written
+//without touching the file.
+OID* oid_at(pool* p, int64_t offset)
+{
+	if (p->buffer != NULL)
+	{
+		return buffer_oid(p, offset);
+	}
+	OID * tmp = index_entry(p, offset);
+	if (tmp != NULL && index_mapped(tmp) == 0)
+	{
+		return tmp;
+	}
+
+	pthread_once(&locks_once, locks_init);
+	site_lock(&map_lock, LOCK_MAP);
+	tmp = index_entry(p, offset);
+	if (tmp != NULL && index_mapped(tmp) == 0) //another thread brought it in first
+	{
+		pthread_mutex_unlock(&map_lock);
+		return tmp;
+	}
+	else if (tmp == NULL)
+	{
+		tmp = oid_chunk_fill(p, offset) == POOL_OK ? index_entry(p, offset) : NULL;
+		pthread_mutex_unlock(&map_lock);
+		return tmp;
+	}
+
+	uint64_t n = (uintptr_t) tmp >> 1;
+	OID entry;
+	int64_t at;
+	index_seg* s;
+	if (map_read(p, n, &entry) == 0) //damaged directory entry, so the object cannot be used
+	{
+		pthread_mutex_unlock(&map_lock);
+		return NULL;
+	}
+	else if ((s = index_slots(p, offset, &at)) == NULL) //the object stays in the file
+	{
+		pthread_mutex_unlock(&map_lock);
+		pool_log(POOL_EFULL, "Could not bring the OIDs of pool %s into memory!", p->name);
+		return NULL;
+	}
+	int copied = entry.data_type == 4 && entry.data_size > BLOB_INLINE_SIZE;
+	if (copied == 1)
+	{
+		void* copy = arena_blob_alloc(&p->arena, entry.data_size);
+		if (copy == NULL) //the object stays in the file
+		{
+			pthread_mutex_unlock(&map_lock);
+			pool_log(POOL_EFULL, "Could not make a blob of %llu bytes!", (unsigned long long) entry.data_size);
+			return NULL;
+		}
+		memcpy(copy, entry.data, entry.data_size);
+		entry.data = copy;
+	}
+	tmp = oid_node_alloc(p);
+	if (tmp == NULL) //the object stays in the file
+	{
+		if (copied == 1)
+		{
+			arena_blob_free(&p->arena, entry.data, entry.data_size);
+		}
+		pthread_mutex_unlock(&map_lock);
+		pool_log(POOL_EFULL, "Could not bring the OIDs of pool %s into memory!", p->name);
+		return NULL;
+	}
+	else if (entry.data_type == 3)
+	{
+		oidptr_count(p, entry.data, 1);
+	}
+	POOL_STAT(p, materialized, 1);
+	tmp->data = entry.data;
+	tmp->data_size = entry.data_size;
+	tmp->data_type = entry.data_type;
+	tmp->empty = entry.empty;
+	tmp->rel = at;
+	tmp->seg = s;
+	s->slots[at] = tmp;
+	oid_link(p, offset);
+	oid_link(p, offset + 1);
+	pthread_mutex_unlock(&map_lock);
+	return tmp;
+}
+
+//returns the OID at an offset for reading; objects not in memory are read into scratch instead
+const OID* oid_peek(pool* p, int64_t offset, OID* scratch)
+{
+	if (p->buffer != NULL)
+	{
+		return buffer_oid(p, offset);
+	}
+	else if (p->text != NULL) //every offset of a text pool holds a char of its text
+	{
+		int64_t at;
+		const text_piece* t = text_find(p, offset, &at);
+		scratch->data = (int*) (intptr_t) t->bytes[at];
+		scratch->data_size = sizeof(int);
+		scratch->rel = offset;
+		scratch->data_type = 2;
+		scratch->empty = 0;
+		scratch->next = NULL;
+		scratch->pool = p;
+		scratch->seg = NULL;
+		return scratch;
+	}
+	OID * tmp = index_entry(p, offset);
+	if (tmp == NULL) //empty OIDs are only brought into memory to be written
+	{
+		scratch->data = NULL;
+		scratch->data_size = 0;
+		scratch->rel = offset;
+		scratch->data_type = 0;
+		scratch->empty = 1;
+		scratch->next = NULL;
+		scratch->pool = p;
+		scratch->seg = NULL;
+		return scratch;
+	}
+	else if (index_mapped(tmp) == 0)
+	{
+		return tmp;
+	}
+	if (map_read(p, (uintptr_t) tmp >> 1, scratch) == 0)
+	{
+		return NULL;
+	}
+	scratch->rel = offset;
+	scratch->seg = NULL;
+	return scratch;
+}
+
+//returns the first OID of the pool with no data (NULL if the pool is full)
+OID* pool_first_empty(pool* p)
+{
+	POOL_STAT(p, empty_scans, 1);
+	if (p->buffer != NULL)
+	{
+		return buffer_first_empty(p);
+	}
+	int64_t start = 0;
+	index_seg* s;
+	for (s = index_first(p->index); s != NULL; s = index_next(s)) //objects still in the mapped file always hold data
+	{
+		int64_t i;
+		for (i = 0; i < s->count && (s->slots != NULL || s->map_first < 0 || p->map_version == 2); i++)
+		{
+			OID * tmp = index_seg_entry(p, s, i);
+			if (tmp == NULL || (index_mapped(tmp) == 0 && tmp->empty == 1))
+			{
+				POOL_STAT(p, scan_steps, start + i + 1);
+				return oid_at(p, start + i);
+			}
+		}
+		start = start + s->count;
+	}
+	POOL_STAT(p, scan_steps, p->size);
+	return NULL;
+}
+
+
+//POOL MANAGEMENT
+
+//Create a pool with specified size (in # of objects) and a name.
+//Only room for the objects is reserved; their OIDs are brought into memory as they are used (see oid_chunk_fill).
+pool* pool_create(const char* name, int64_t size)
+{
+	pool* p = malloc(sizeof(pool)); //creates pool pointer
+	p->size = size; //sets pool size (# of objects);
+	p->closed = 0;
+	p->name = name; //sets pool name
+	p->next = NULL; //sets NULL pointer to next pool
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&p->lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	arena_init(&p->arena);
+	p->index = NULL;
+	p->segments = 0;
+	p->index_rand = 0x9E3779B97F4A7C15ULL;
+	p->blocks = NULL;
+	p->spare = NULL;
+	p->spare_count = 0;
+	p->map = NULL;
+	p->map_len = 0;
+	p->map_version = 0;
+	p->map_pos = NULL;
+	p->map_dir = NULL;
+	p->map_data_pos = 0;
+	memset(&p->map_header, 0, sizeof(pfile_header));
+	p->map_names = NULL;
+	p->map_name_count = 0;
+	p->trace_id = 0;
+	p->trace_gen = 0;
+	p->sim_id = __atomic_add_fetch(&polb_pool_ids, 1, __ATOMIC_RELAXED);
+	p->hibernate = NULL;
+	p->hibernated = 0;
+	p->pointers_in = 0;
+	p->pointers_out = 0;
+	p->buffer = NULL;
+	p->text = NULL;
+	p->hash_moves = NULL;
+	p->hash_move_count = 0;
+	p->hash_move_cap = 0;
+	memset(&p->stats, 0, sizeof(p->stats));
+	if (size > 0)
+	{
+		p->index = index_seg_alloc(p, size); //one segment of empty offsets
+		p->root = p->index == NULL ? NULL : oid_at(p, 0); //brings in the first chunk of OIDs
+	}
+	else
+	{
+		p->root = oid_block_alloc(p, 1, NULL, 0); //there is always a root OID
+	}
+	if (p->root == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not reserve room for %lld objects!", (long long) size);
+		arena_release(&p->arena);
+		pthread_mutex_destroy(&p->lock);
+		pthread_mutex_destroy(&p->arena.lock);
+		free(p);
+		return NULL;
+	}
+
+	registry_lock_take(); //the pool is only added to the list once it is ready
+	if (head_pool == NULL) //inserts pool in the proper LL position
+	{
+		head_pool = p;
+	}
+	else
+	{
+		pool* tmp_pool = head_pool;
+		while (tmp_pool->next != NULL)
+		{
+			tmp_pool = tmp_pool->next;
+		}
+		tmp_pool->next = p;
+	}
+	registry_lock_give();
+
+	trace_call(TRACE_POOL_CREATE, p, NULL, size, 0, NULL);
+	return p;
+}
+
+int pool_destroy(pool* p);
+void pool_release(pool* p);
+int pfile_write_bin(pool* p, const char* filename, int nthreads, int keep_empty);
+
+//Map a binary file written by pfileout (or a file of plain ints) as the storage of pool p, which holds no objects.
+//Every object of the file starts out only in the file (empty ones kept by pool_hibernate start out empty), and one
+//segment of the index with no entries stands for all of them, so index memory is only taken as objects are used.
+//Directory entries are checked as their objects are used (see map_check), not here.
+//Returns POOL_OK or an error code.
+int pool_attach(pool* p, const char* filename)
+{
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) //missing file exception
+	{
+		int error = pool_log(POOL_EIO, "Could not open file %s!", filename);
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return error;
+	}
+
+	size_t len = st.st_size;
+	const char* map = NULL;
+	if (len > 0)
+	{
+		map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		return pool_log(POOL_EIO, "Could not map file %s!", filename);
+	}
+
+	int version = 0; //files without a header hold plain ints
+	uint64_t* pos = NULL;
+	uint64_t count = len / sizeof(int);
+	pfile_header h;
+	uint32_t rec[2];
+	if (len >= sizeof(rec))
+	{
+		memcpy(rec, map, sizeof(rec));
+	}
+	if (pfile_header_read(map, len, &h) == 1) //version 2 files are used as they are
+	{
+		version = 2;
+		count = h.count;
+	}
+	else if (len >= sizeof(rec) && le32(rec[0]) == PFILE_MAGIC && le32(rec[1]) == PFILE_VERSION)
+	{
+		munmap((void*) map, len);
+		return pool_log(POOL_EBADF, "Damaged header in file %s!", filename);
+	}
+	else if (len >= sizeof(rec) && rec[0] == PFILE_MAGIC && rec[1] == 1) //finds where each record of a version 1 file starts
+	{
+		version = 1;
+		uint64_t cap = 1024;
+		uint64_t at = sizeof(rec);
+		pos = malloc(cap * sizeof(uint64_t));
+		count = 0;
+		while (at + sizeof(rec) <= len)
+		{
+			memcpy(rec, map + at, sizeof(rec));
+			int ok = (rec[0] == 0) || (rec[0] == 1 && rec[1] == sizeof(int)) || (rec[0] == 2 && rec[1] == sizeof(char))
+				|| (rec[0] == 3 && rec[1] == sizeof(void*)) || rec[0] == 4;
+			if (ok == 0 || at + sizeof(rec) + rec[1] > len)
+			{
+				pool_log(POOL_EBADF, "Bad record in file %s at file index %lld", filename, (long long) count);
+				break;
+			}
+			if (rec[0] != 0) //range tables are not objects
+			{
+				if (count == cap)
+				{
+					cap = cap * 2;
+					pos = realloc(pos, cap * sizeof(uint64_t));
+				}
+				pos[count] = at;
+				count++;
+			}
+			at = at + sizeof(rec) + rec[1];
+		}
+	}
+	if (count > INT64_MAX >> 1) //index entries hold the # of the object shifted left by one
+	{
+		munmap((void*) map, len);
+		free(pos);
+		return pool_log(POOL_EBADF, "File %s holds too many objects for a pool!", filename);
+	}
+
+	p->map = map;
+	p->map_len = len;
+	p->map_version = version;
+	p->map_pos = pos;
+	if (version == 2)
+	{
+		p->map_dir = (const pfile_entry*) (map + h.dir_pos);
+		p->map_data_pos = h.data_pos;
+		p->map_header = h;
+		p->map_names = malloc((h.name_count + 1) * sizeof(char*));
+		const char* name_ptr = map + h.names_pos;
+		const char* names_end = map + h.names_pos + h.names_size;
+		while (p->map_name_count < h.name_count && name_ptr < names_end)
+		{
+			size_t name_len = strnlen(name_ptr, names_end - name_ptr);
+			if (name_ptr + name_len == names_end) //names must be NUL terminated
+			{
+				break;
+			}
+			p->map_names[p->map_name_count] = name_ptr;
+			p->map_name_count++;
+			name_ptr = name_ptr + name_len + 1;
+		}
+	}
+	if (count > 0) //every object starts out only in the file, in one segment with no entries (see index_seg_entry)
+	{
+		index_seg* s = index_seg_alloc(p, (int64_t) count);
+		if (s == NULL) //the mapped file goes with the pool
+		{
+			return pool_log(POOL_EFULL, "Could not reserve room for %lld objects!", (long long) count);
+		}
+		s->map_first = 0;
+		index_set(p, s);
+	}
+	p->size = (int64_t) count;
+	oid_link(p, 0);
+	return POOL_OK;
+}
+
+//Create a pool named name on top of a binary file written by pfileout (or a file of plain ints), mapped into memory.
+//Data is read straight from the file; an object is only copied into its own OID once getoid asks for it,
+//so the file itself is never written and only the pages that are used are read in.
+pool* pool_create_map(const char* name, const char* filename)
+{
+	trace_quiet++; //recorded as a whole below
+	pool* p = pool_create(name, 0);
+	if (p != NULL && pool_attach(p, filename) != POOL_OK)
+	{
+		pool_destroy(p); //takes the mapped file with it
+		p = NULL;
+	}
+	trace_quiet--;
+	if (p == NULL)
+	{
+		return NULL;
+	}
+
+	trace_call(TRACE_POOL_CREATE_MAP, p, NULL, 0, 0, filename);
+	return p;
+}
+
+//Create an out-of-core pool named name of size objects, kept in a new file filename with about cache_bytes of its pages
+//in memory. Pages are read in as they are used and the ones not used lately are written back to make room, so the pool
+//can be much larger than memory. OIDs of the pool are only valid until the next call on it unless pinned (see oid_pin),
+//and oidptrs into it cannot be written. The file goes with the pool; pfileout copies the pool to a file to keep.
+pool* pool_create_paged(const char* name, const char* filename, int64_t size, int64_t cache_bytes)
+{
+	if (size < 0) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "Pool size cannot be negative!");
+		return NULL;
+	}
+	trace_quiet++; //recorded as a whole below
+	pool* p = pool_create(name, 0);
+	if (p != NULL)
+	{
+		pool_lock(p, LOCK_POOL);
+		p->buffer = buffer_create(filename, cache_bytes);
+		if (p->buffer != NULL && buffer_reserve(p->buffer, size) == POOL_OK)
+		{
+			p->size = size;
+			pool_unlock(p);
+		}
+		else
+		{
+			pool_unlock(p);
+			pool_destroy(p);
+			p = NULL;
+		}
+	}
+	trace_quiet--;
+	if (p == NULL)
+	{
+		return NULL;
+	}
+
+	trace_call(TRACE_POOL_CREATE_PAGED, p, NULL, size, cache_bytes, filename);
+	return p;
+}
+
+//Create a text pool named name: an editable text with one char at each offset, read with pread_char, pview and preadf
+//like a pool of chars. ptext_insert, ptext_delete and ptext_replace edit it at any offset in O(log n), pwritechar,
+//pwritestr and pfileintxt add to its end, pfree_range deletes and pfileouttxt writes the text out piece by piece.
+//Its size is the length of its text. It holds no OIDs, so calls that take or hand out OIDs refuse it.
+pool* pool_create_text(const char* name)
+{
+	trace_quiet++; //recorded as a whole below
+	pool* p = pool_create(name, 0);
+	if (p != NULL)
+	{
+		pool_lock(p, LOCK_POOL);
+		p->text = calloc(1, sizeof(pool_text));
+		if (p->text != NULL)
+		{
+			p->text->rand = 0x9E3779B97F4A7C15ULL ^ p->sim_id;
+		}
+		pool_unlock(p);
+		if (p->text == NULL) //calloc exception
+		{
+			pool_destroy(p);
+			p = NULL;
+			pool_log(POOL_EFULL, "Could not make the text of pool %s!", name);
+		}
+	}
+	trace_quiet--;
+	if (p == NULL)
+	{
+		return NULL;
+	}
+
+	trace_call(TRACE_POOL_CREATE_TEXT, p, NULL, 0, 0, NULL);
+	return p;
+}
+
+//Reopen a pool that is previously created by the same program.
+//Permissions will be checked.
+pool* pool_open(const char* name)
+{
+	registry_lock_take();
+	pool* p = head_pool;
+	
+	if (p == NULL) //NULL head_pool exception
+	{
+		registry_lock_give();
+		trace_call(TRACE_POOL_OPEN, NULL, NULL, 0, 0, name);
+		pool_errno = POOL_ENOENT;
+		return NULL;
+	}
+	
+	do
+	{
+		if (strcmp(p->name, name) == 0)
+		{
+			registry_lock_give();
+			trace_call(TRACE_POOL_OPEN, p, NULL, 0, 0, name);
+			pool_lock(p, LOCK_POOL);
+			if (p->hibernated == 1 && p->closed == 1) //maps the hibernate file back, objects come in as they are used
+			{
+				if (pool_attach(p, p->hibernate) != POOL_OK)
+				{
+					pool_release(p); //stays closed, the file is tried again on the next pool_open
+					pool_unlock(p);
+					return NULL;
+				}
+				p->hibernated = 0;
+			}
+			p->closed = 0;
+			pool_unlock(p);
+			pool_log(POOL_OK, "Pool %s successfully opened.", name);
+			return p;
+		}
+		p = p->next;
+	} 
+	while (p != NULL);
+
+	registry_lock_give();
+	trace_call(TRACE_POOL_OPEN, NULL, NULL, 0, 0, name);
+	pool_log(POOL_ENOENT, "No pool of name %s found!", name);
+	return NULL;
+}
+
+//Write pool p to its hibernate file and release its memory (pool lock held), returns POOL_OK or an error code.
+//The file is written next to the old one and renamed over it, so a pool mapped from the same file can still be read.
+int pool_hibernate_out(pool* p)
+{
+	if (__atomic_load_n(&p->pointers_in, __ATOMIC_RELAXED) > 0) //other pools point into it
+	{
+		pool_log(POOL_OK, "Pool %s stays in memory: other pools point into it.", p->name);
+		return POOL_OK;
+	}
+
+	size_t len = strlen(p->hibernate);
+	char* tmp_name = malloc(len + 5);
+	memcpy(tmp_name, p->hibernate, len);
+	memcpy(tmp_name + len, ".tmp", 5);
+	int error = pfile_write_bin(p, tmp_name, 1, 1);
+	if (error == POOL_OK && rename(tmp_name, p->hibernate) != 0)
+	{
+		error = pool_log(POOL_EIO, "Could not write file %s!", p->hibernate);
+	}
+	if (error != POOL_OK) //the pool stays in memory
+	{
+		unlink(tmp_name);
+		free(tmp_name);
+		return error;
+	}
+	free(tmp_name);
+
+	pool_release(p);
+	p->size = 0;
+	p->hibernated = 1;
+	return POOL_OK;
+}
+
+//Close a pool. A pool set to hibernate (see pool_hibernate) is written to its file and its memory is released.
+int pool_close(pool* p)
+{
+	trace_call(TRACE_POOL_CLOSE, p, NULL, 0, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	pool_lock(p, LOCK_POOL); //waits for calls in progress
+	int error = POOL_OK;
+	if (p->closed == 0 && p->hibernate != NULL && p->size > 0)
+	{
+		error = pool_hibernate_out(p);
+	}
+	p->closed = 1;
+	pool_unlock(p);
+	return error;
+}
+
+//Make pool p hibernate whenever it is closed: it is written to filename and its memory is released, then pool_open
+//maps the file back and brings objects in as they are used. OIDs taken from the pool before it hibernates must not be
+//used again, and pools that other pools point into stay in memory. filename NULL keeps the pool in memory.
+//Returns POOL_OK or an error code.
+int pool_hibernate(pool* p, const char* filename)
+{
+	trace_call(TRACE_POOL_HIBERNATE, p, NULL, 0, 0, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->buffer != NULL) //out-of-core pools already live in their file
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is out of core and cannot hibernate!", p->name);
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and cannot hibernate!", p->name);
+	}
+	pool_lock(p, LOCK_POOL);
+	if (p->hibernated == 1) //the pool's objects are in the old file
+	{
+		pool_unlock(p);
+		return pool_log(POOL_EBUSY, "The specified pool is hibernating!");
+	}
+	free(p->hibernate);
+	p->hibernate = filename == NULL ? NULL : strdup(filename);
+	pool_unlock(p);
+	return POOL_OK;
+}
+
+//Release what pool p's objects hold (pool lock held): its arena, which holds its index too, and its mapped file
+void pool_release(pool* p)
+{
+	int64_t i;
+	for (i = 0; i < p->size && p->buffer != NULL && p->pointers_out > 0; i++) //lets go of the pools it points into
+	{
+		OID* tmp = buffer_oid(p, i);
+		if (tmp != NULL && tmp->empty == 0 && tmp->data_type == 3)
+		{
+			oidptr_count(p, tmp->data, -1);
+		}
+	}
+	index_seg* s;
+	for (s = index_first(p->index); s != NULL && p->pointers_out > 0; s = index_next(s))
+	{
+		for (i = 0; i < s->count && s->slots != NULL; i++)
+		{
+			OID* tmp = s->slots[i];
+			if (tmp != NULL && index_mapped(tmp) == 0 && tmp->empty == 0 && tmp->data_type == 3)
+			{
+				oidptr_count(p, tmp->data, -1);
+			}
+		}
+	}
+	arena_release(&p->arena); //the segments of the index were in the arena too
+	p->root = NULL;
+	p->blocks = NULL;
+	p->spare = NULL;
+	p->spare_count = 0;
+	p->index = NULL;
+	p->segments = 0;
+	if (p->map != NULL)
+	{
+		munmap((void*) p->map, p->map_len);
+	}
+	free(p->map_pos);
+	free(p->map_names);
+	p->map = NULL;
+	p->map_len = 0;
+	p->map_version = 0;
+	p->map_pos = NULL;
+	p->map_dir = NULL;
+	p->map_data_pos = 0;
+	memset(&p->map_header, 0, sizeof(pfile_header));
+	p->map_names = NULL;
+	p->map_name_count = 0;
+	if (p->buffer != NULL) //the page cache stays, its pages and file are dropped
+	{
+		buffer_clear(p->buffer);
+	}
+	if (p->text != NULL) //the pieces and their bytes were in the arena
+	{
+		text_clear(p);
+	}
+	p->hash_move_count = 0; //the old tables of hash maps being resized were in the arena too
+}
+
+//Empty pool p for reuse, keeping its name and size. Everything its objects hold is released at once,
+//so OIDs taken from the pool before must not be used again. Returns POOL_OK or an error code.
+int pool_reset(pool* p)
+{
+	trace_call(TRACE_POOL_RESET, p, NULL, 0, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	pool_lock(p, LOCK_POOL);
+	pool_release(p);
+	int error = POOL_OK;
+	if (p->size > 0 && p->buffer == NULL && p->text == NULL) //a text pool is left with an empty text
+	{
+		p->index = index_seg_alloc(p, p->size); //one segment of empty offsets again
+		p->root = p->index == NULL ? NULL : oid_at(p, 0);
+	}
+	else
+	{
+		p->root = oid_block_alloc(p, 1, NULL, 0); //there is always a root OID
+	}
+	if (p->root == NULL)
+	{
+		error = pool_log(POOL_EFULL, "Could not reserve room for %lld objects!", (long long) p->size);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Destroy pool p (open or closed), taking it off the list of pools and releasing everything it holds in a few calls.
+//OIDs of the pool and oidptrs into it must not be used afterwards. Returns POOL_OK or an error code.
+int pool_destroy(pool* p)
+{
+	trace_call(TRACE_POOL_DESTROY, p, NULL, 0, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+
+	registry_lock_take();
+	pool** link = &head_pool;
+	while (*link != NULL && *link != p)
+	{
+		link = &((*link)->next);
+	}
+	if (*link == NULL) //destroyed pool exception
+	{
+		registry_lock_give();
+		return pool_log(POOL_ENOENT, "The specified pool does not exist!");
+	}
+	*link = p->next;
+	registry_lock_give();
+
+	pool_lock(p, LOCK_POOL); //waits for calls in progress
+	pool_release(p);
+	if (p->buffer != NULL)
+	{
+		buffer_free(p->buffer);
+	}
+	free(p->text);
+	free(p->hash_moves);
+	pool_unlock(p);
+	pthread_mutex_destroy(&p->lock);
+	pthread_mutex_destroy(&p->arena.lock);
+	free(p->hibernate);
+	free(p);
+	return POOL_OK;
+}
+
+//Return the root object of the pool p with specified size.
+//The root object is intended for programmers to design as a directory of the pool; pool_dir_create makes it one.
+OID* pool_root(pool* p) //, int size)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;	
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->buffer != NULL && p->size > 0) //the root of an out-of-core pool is the first slot of its first page
+	{
+		pool_lock(p, LOCK_POOL);
+		OID * tmp = oid_at(p, 0);
+		pool_unlock(p);
+		return tmp;
+	}
+	else
+	{
+		return p->root;
+	}
+}
+
+//Copy the counters of pool p into s, adding up the memory the pool holds (its OIDs, index and blob extents).
+//Counters stay at 0 if the library is compiled with NVMLIB_STATS 0.
+int pool_stats(pool* p, struct pool_stats* s)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (s == NULL) //stats NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified stats are NULL!");
+	}
+
+	pool_lock(p, LOCK_POOL);
+	*s = p->stats;
+	s->resident_bytes = sizeof(pool) + p->map_name_count * sizeof(char*);
+	s->resident_bytes = s->resident_bytes + __atomic_load_n(&p->arena.used, __ATOMIC_RELAXED); //OIDs, segments of the index and blob extents, freed ones included
+	s->mapped_bytes = p->map_len;
+	if (p->buffer != NULL) //frames are allocated in full when the pool is created
+	{
+		pool_buffer* b = p->buffer;
+		s->resident_bytes = s->resident_bytes + sizeof(pool_buffer) + (uint64_t) (b->bucket_mask + 1) * sizeof(int) + (uint64_t) b->page_cap * sizeof(int64_t)
+			+ (uint64_t) b->frame_count * (sizeof(buffer_frame) + BUFFER_PAGE_OIDS * (sizeof(OID) + sizeof(pfile_entry)));
+	}
+	if (p->text != NULL) //pieces and text bytes are in the arena
+	{
+		s->resident_bytes = s->resident_bytes + sizeof(pool_text);
+	}
+	s->resident_bytes = s->resident_bytes + (uint64_t) p->hash_move_cap * sizeof(phash_move); //old tables are in the arena
+	pool_unlock(p);
+	return POOL_OK;
+}
+
+//Make the writes to pool p persistent.
+//Pools live in DRAM, so this only adds the persist cost set with nvm_emulate, letting flush policies be compared.
+int pool_persist(pool* p)
+{
+	trace_call(TRACE_POOL_PERSIST, p, NULL, 0, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_POOL); //waits for the writes in progress
+		POOL_STAT(p, persists, 1);
+		int error = p->buffer != NULL ? buffer_flush(p) : POOL_OK; //changed pages of an out-of-core pool go back to its file
+		if (nvm_emu_on == 1 && nvm_emu.persist_ns > 0)
+		{
+			POOL_STAT(p, emulated_ns, nvm_spin_until(nvm_now() + nvm_emu.persist_ns));
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+
+//OBJECT MANAGEMENT
+
+//Allocate a chunk of persistent data of size on pool p and return the ObjectID of the first byte.
+OID* pmalloc(pool * p, int64_t size)
+{
+	trace_call(TRACE_PMALLOC, p, NULL, size, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;	
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools hold no OIDs
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and holds no OIDs!", p->name);
+		return NULL;
+	}
+	else
+	{
+		if (size < 1) //invalid size exception
+		{
+			pool_log(POOL_EINVAL, "pmalloc size must be at least 1!");
+			return NULL;
+		}
+
+		pool_lock(p, LOCK_PMALLOC);
+		POOL_STAT(p, allocations, 1);
+		POOL_STAT(p, oids_allocated, size);
+		int error = p->buffer != NULL ? buffer_reserve(p->buffer, p->size + size) : index_insert(p, p->size, size);
+		if (error != POOL_OK)
+		{
+			pool_unlock(p);
+			return NULL;
+		}
+
+		p->size = p->size + size; //increases size of the pool to accomadate new OIDs (not in memory yet)
+		OID * newdata_root = oid_at(p, p->size - size); //brings in the chunk of the first new OID and links it
+		pool_unlock(p);
+
+		return newdata_root;
+	}
+}
+
+OID* pdir_root(pool* p);
+void pdir_moved(pool* p, int64_t offset, int64_t count);
+
+//Allocate count empty objects at an offset of pool p, moving the objects from the offset on up by count,
+//and return the ObjectID of the first of them. The new objects are one segment of the index put in at the offset,
+//so no OID after them is renumbered and a call takes O(log n) time however large count and the pool are.
+OID* pmalloc_range(pool* p, int64_t offset, int64_t count)
+{
+	trace_call(TRACE_PMALLOC_RANGE, p, NULL, offset, count, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools hold no OIDs
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and holds no OIDs!", p->name);
+		return NULL;
+	}
+	else if (count < 1) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "pmalloc_range count must be at least 1!");
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_PMALLOC);
+	if (offset < 0 || offset > p->size) //the new objects may only go at an offset in use or at the end
+	{
+		pool_unlock(p);
+		pool_log(POOL_ERANGE, "Offset %lld is out of range for pool %s!", (long long) offset, p->name);
+		return NULL;
+	}
+	else if (offset == 0 && pdir_root(p) != NULL) //the directory is only found at the root
+	{
+		pool_unlock(p);
+		pool_log(POOL_EINVAL, "The root of pool %s is its directory and cannot move!", p->name);
+		return NULL;
+	}
+	POOL_STAT(p, allocations, 1);
+	POOL_STAT(p, oids_allocated, count);
+	if (p->buffer != NULL) //out-of-core pools move their objects up instead of renumbering OIDs
+	{
+		int64_t size = p->size;
+		int error = buffer_insert(p, offset, count);
+		if (p->size != size) //the objects moved even if a page could not be emptied after
+		{
+			pdir_moved(p, offset, count);
+		}
+		OID* tmp = error == POOL_OK ? oid_at(p, offset) : NULL;
+		pool_unlock(p);
+		return tmp;
+	}
+	if (index_insert(p, offset, count) != POOL_OK) //the gap is brought into memory when used (see oid_chunk_fill)
+	{
+		pool_unlock(p);
+		return NULL;
+	}
+	p->size = p->size + count;
+	pdir_moved(p, offset, count);
+	oid_link(p, offset); //the OID before the gap stops there until the gap is in memory
+	OID* newdata_root = oid_at(p, offset);
+	pool_unlock(p);
+	return newdata_root;
+}
+
+//Free persistent data pointed by the OID
+int pfree(OID* oid)
+{
+	if (oid == NULL) //oid  NULL exception
+	{
+		trace_call(TRACE_PFREE, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	else if (oid->pool->closed == 1) //pool closed exception
+	{
+		trace_call(TRACE_PFREE, oid->pool, NULL, trace_offset(oid), 0, NULL);
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool* p = oid->pool;
+		pool_lock(p, LOCK_PFREE); //the offset is only stable while the pool is locked
+		int64_t k = index_offset(oid);
+		trace_call(TRACE_PFREE, p, NULL, k, 0, NULL);
+		if (k >= p->size || (p->buffer != NULL ? buffer_frame_of(p, oid) < 0 : oid->seg == NULL)) //freed OID exception (another thread may have freed it first)
+		{
+			pool_unlock(p);
+			return pool_log(POOL_EFREED, "The specified oid was already freed!");
+		}
+		POOL_STAT(p, frees, 1);
+		if (p->buffer != NULL) //out-of-core pools move their objects down a slot instead of renumbering OIDs
+		{
+			int64_t size = p->size;
+			int error = buffer_remove(p, k, 1);
+			if (p->size != size)
+			{
+				pdir_moved(p, k, -1);
+			}
+			pool_unlock(p);
+			return error;
+		}
+		int error = index_remove(p, k, 1); //closes the gap in the index and gives up the OID's data
+		if (error == POOL_OK)
+		{
+			p->size = p->size - 1; //decrements size of the pool
+			oid_link(p, k); //skips the freed OID in LL
+			pdir_moved(p, k, -1);
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Free count objects of pool p from an offset on. The run is cut out of the index as whole segments, so the objects
+//after it move down without being renumbered: a call takes O(log n) time plus the OIDs of the run that are in memory,
+//whose data is given up one by one.
+int pfree_range(pool* p, int64_t offset, int64_t count)
+{
+	trace_call(TRACE_PFREE_RANGE, p, NULL, offset, count, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (count < 1) //invalid size exception
+	{
+		return pool_log(POOL_EINVAL, "pfree_range count must be at least 1!");
+	}
+
+	pool_lock(p, LOCK_PFREE);
+	if (offset < 0 || offset > p->size - count)
+	{
+		pool_unlock(p);
+		return pool_log(POOL_ERANGE, "Range %lld+%lld is out of range for pool %s!", (long long) offset, (long long) count, p->name);
+	}
+	POOL_STAT(p, frees, count);
+	if (p->buffer != NULL)
+	{
+		int64_t size = p->size;
+		int error = buffer_remove(p, offset, count);
+		if (p->size != size)
+		{
+			pdir_moved(p, offset, -count);
+		}
+		pool_unlock(p);
+		return error;
+	}
+	else if (p->text != NULL) //deletes the chars from a text pool's text
+	{
+		int error = text_delete(p, offset, count);
+		pool_unlock(p);
+		return error;
+	}
+
+	if (index_remove(p, offset, count) != POOL_OK)
+	{
+		pool_unlock(p);
+		return POOL_EFULL;
+	}
+	p->size = p->size - count;
+	pdir_moved(p, offset, -count);
+	oid_link(p, offset); //skips the freed OIDs in LL
+	pool_unlock(p);
+	return POOL_OK;
+}
+
+//OID ACCESS
+
+//Account for a lookup of an offset of pool p: counters, emulated read cost and simulated translation
+void oid_lookup(pool* p, int64_t offset)
+{
+	POOL_STAT(p, lookups, 1);
+	nvm_read(p, 1);
+	if (__atomic_load_n(&polb_sim_count, __ATOMIC_RELAXED) > 0)
+	{
+		polb_feed(p, offset);
+	}
+}
+
+//returns an oid at a cerain offset value
+OID* getoid(pool* p, int64_t offset)
+{
+	trace_call(TRACE_GETOID, p, NULL, offset, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;	
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools hold no OIDs
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and holds no OIDs!", p->name);
+		return NULL;
+	}
+	else
+	{
+		OID * tmp = NULL;
+		pool_lock(p, LOCK_GETOID);
+		if (offset >= p->size)
+		{
+			pool_log(POOL_ERANGE, "offset too large for pool size!");
+		}
+		else if (offset < 0)
+		{
+			pool_log(POOL_ERANGE, "offset cannot be negative!");
+		}
+		else
+		{
+			oid_lookup(p, offset);
+			tmp = oid_at(p, offset);
+		}
+		pool_unlock(p);
+		return tmp;
+	}
+}
+
+//Keep the page of an OID of an out-of-core pool in memory until oid_unpin, so the OID stays valid across other calls.
+//OIDs of pools in memory always stay valid, so there is nothing to do for them. Returns POOL_OK or an error code.
+int oid_pin(OID* oid)
+{
+	if (oid == NULL) //oid NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = oid->pool;
+	if (p->buffer == NULL)
+	{
+		return POOL_OK;
+	}
+	pool_lock(p, LOCK_GETOID);
+	int error = POOL_OK;
+	int f = buffer_frame_of(p, oid);
+	if (f < 0) //its page was given to another one
+	{
+		error = pool_log(POOL_EFREED, "The specified oid is no longer in memory!");
+	}
+	else if (p->buffer->frames[f].pins == 0 && p->buffer->pinned + 2 >= p->buffer->frame_count) //pfree needs two frames
+	{
+		error = pool_log(POOL_EFULL, "Too many pages of pool %s are pinned!", p->name);
+	}
+	else
+	{
+		if (p->buffer->frames[f].pins == 0)
+		{
+			p->buffer->pinned++;
+		}
+		p->buffer->frames[f].pins++;
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Let the page of an OID pinned with oid_pin be replaced again, returns POOL_OK or an error code
+int oid_unpin(OID* oid)
+{
+	if (oid == NULL) //oid NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = oid->pool;
+	if (p->buffer == NULL)
+	{
+		return POOL_OK;
+	}
+	pool_lock(p, LOCK_GETOID);
+	int error = POOL_OK;
+	int f = buffer_frame_of(p, oid);
+	if (f < 0 || p->buffer->frames[f].pins == 0) //unpinned oid exception
+	{
+		error = pool_log(POOL_EINVAL, "The specified oid is not pinned!");
+	}
+	else
+	{
+		p->buffer->frames[f].pins--;
+		if (p->buffer->frames[f].pins == 0)
+		{
+			p->buffer->pinned--;
+		}
+	}
+	pool_unlock(p);
+	return error;
+}
+
+const OID* oid_read(pool* p, int64_t offset, int type, OID* scratch);
+
+//returns the OID at an offset holding data of type, without printing (NULL if there is none).
+//Objects still only in a mapped file are read into scratch.
+const OID* pread_oid(pool* p, int64_t offset, int type, OID* scratch)
+{
+	trace_call(TRACE_PREAD, p, NULL, offset, type, NULL);
+	if (p == NULL || p->closed == 1) //reads fail quietly, leaving the reason in pool_errno
+	{
+		pool_errno = p == NULL ? POOL_ENULL : POOL_ECLOSED;
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_PREAD);
+	const OID * tmp = oid_read(p, offset, type, scratch);
+	pool_unlock(p);
+	return tmp;
+}
+
+//returns the OID at an offset of pool p holding data of type (pool lock held), as pread_oid
+const OID* oid_read(pool* p, int64_t offset, int type, OID* scratch)
+{
+	const OID * tmp = NULL;
+	if (offset >= 0 && offset < p->size)
+	{
+		oid_lookup(p, offset);
+		tmp = oid_peek(p, offset, scratch); //NULL if the page of an out-of-core pool could not be brought in
+		if (tmp != NULL && (tmp->empty == 1 || tmp->data_type != type))
+		{
+			pool_errno = POOL_ETYPE;
+			tmp = NULL;
+		}
+	}
+	else
+	{
+		pool_errno = POOL_ERANGE;
+	}
+	return tmp;
+}
+
+//returns the type of data at an offset of pool p (pool lock held), 0 if it is empty, unavailable or out of range
+int oid_type_at(pool* p, int64_t offset)
+{
+	if (offset < 0 || offset >= p->size)
+	{
+		return 0;
+	}
+	oid_lookup(p, offset);
+	OID scratch;
+	const OID * tmp = oid_peek(p, offset, &scratch);
+	return tmp == NULL || tmp->empty == 1 ? 0 : tmp->data_type;
+}
+
+//returns the type of data at an offset without recording the call in a trace
+int oid_type(pool* p, int64_t offset)
+{
+	if (p == NULL || p->closed == 1)
+	{
+		return 0;
+	}
+	pool_lock(p, LOCK_PREAD);
+	int type = oid_type_at(p, offset);
+	pool_unlock(p);
+	return type;
+}
+
+//returns the type of data at an offset (1=int, 2=char, 3=oidptr, 4=blob, 0 if empty or unavailable)
+int pread_type(pool* p, int64_t offset)
+{
+	trace_call(TRACE_PREAD, p, NULL, offset, 0, NULL);
+	return oid_type(p, offset);
+}
+
+//returns the int at an offset (0 if the offset does not hold an int)
+int pread_int(pool* p, int64_t offset)
+{
+	OID scratch;
+	const OID * tmp = pread_oid(p, offset, 1, &scratch);
+	return tmp == NULL ? 0 : (int) (intptr_t) tmp->data;
+}
+
+//returns the char at an offset ('\0' if the offset does not hold a char)
+char pread_char(pool* p, int64_t offset)
+{
+	OID scratch;
+	const OID * tmp = pread_oid(p, offset, 2, &scratch);
+	return tmp == NULL ? '\0' : (char) (intptr_t) tmp->data;
+}
+
+//returns the ptr at an offset (NULL if the offset does not hold a ptr)
+void* pread_ptr(pool* p, int64_t offset)
+{
+	OID scratch;
+	const OID * tmp = pread_oid(p, offset, 3, &scratch);
+	return tmp == NULL ? NULL : tmp->data;
+}
+
+//returns where the bytes of a blob OID are (small blobs live in the data field itself)
+const void* oid_blob_bytes(const OID* oid)
+{
+	return oid->data_size <= BLOB_INLINE_SIZE ? (const void*) &oid->data : oid->data;
+}
+
+//copies the blob at an offset into buf (at most cap bytes) and returns the blob's size (0 if the offset does not hold a blob)
+size_t pread_blob(pool* p, int64_t offset, void* buf, size_t cap)
+{
+	OID scratch;
+	const OID * tmp = pread_oid(p, offset, 4, &scratch);
+	if (tmp == NULL)
+	{
+		return 0;
+	}
+	memcpy(buf, oid_blob_bytes(tmp), tmp->data_size < cap ? tmp->data_size : cap);
+	return tmp->data_size;
+}
+
+//returns the bytes of the blob at an offset in place and stores its size in size (NULL if the offset does not hold a blob)
+const void* pread_blob_ptr(pool* p, int64_t offset, size_t* size)
+{
+	trace_call(TRACE_PREAD, p, NULL, offset, 4, NULL);
+	*size = 0;
+	if (p == NULL || p->closed == 1) //reads fail quietly, leaving the reason in pool_errno
+	{
+		pool_errno = p == NULL ? POOL_ENULL : POOL_ECLOSED;
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_PREAD); //held until the blob is found, so a pfree cannot move it in between
+	OID scratch;
+	const OID * tmp = oid_read(p, offset, 4, &scratch);
+	const void* bytes = NULL;
+	if (tmp == &scratch) //blobs still in the mapped file are returned from the file
+	{
+		bytes = map_data(p, (uintptr_t) index_entry(p, offset) >> 1);
+	}
+	else if (tmp != NULL)
+	{
+		bytes = oid_blob_bytes(tmp);
+	}
+	*size = tmp == NULL ? 0 : tmp->data_size;
+	pool_unlock(p);
+	return bytes;
+}
+
+//returns a view of the run of same-typed data starting at an offset, at most max_len objects long.
+//The run stops at the first empty object, change of type, end of an OID block or of a segment of the index
+//(or of a stretch of the mapped file),
+//so the run can be read in place with pview_int, pview_char and pview_ptr. An oidptr of a mapped file is resolved
+//into its OID first and makes a run of one.
+pview pview_get(pool* p, int64_t offset, int64_t max_len)
+{
+	trace_call(TRACE_PVIEW, p, NULL, offset, max_len, NULL);
+	pview v;
+	v.oids = NULL;
+	v.raw = NULL;
+	v.stride = 0;
+	v.len = 0;
+	v.data_type = 0;
+	if (p == NULL || p->closed == 1 || max_len < 1)
+	{
+		return v;
+	}
+
+	pool_lock(p, LOCK_PREAD); //a view is only stable until the pool is next changed
+	v.data_type = oid_type_at(p, offset); //checked under the same lock as the run, so a pfree cannot shrink the pool in between
+	if (v.data_type == 0)
+	{
+		pool_unlock(p);
+		return v;
+	}
+	v.len = 1;
+	if (p->text != NULL) //runs of a text pool are the rest of the piece holding the offset, read in place
+	{
+		int64_t at;
+		const text_piece* t = text_find(p, offset, &at);
+		v.raw = t->bytes + at;
+		v.stride = 1;
+		v.len = t->len - at < max_len ? t->len - at : max_len;
+		nvm_read(p, v.len - 1);
+		pool_unlock(p);
+		return v;
+	}
+	else if (p->buffer != NULL) //runs of an out-of-core pool stop at the end of a page (and only last until the next call)
+	{
+		v.oids = oid_at(p, offset);
+		v.len = v.oids == NULL ? 0 : 1;
+		while (v.len > 0 && v.len < max_len && offset + v.len < p->size && (offset + v.len) % BUFFER_PAGE_OIDS != 0
+			&& v.oids[v.len].empty == 0 && v.oids[v.len].data_type == v.data_type)
+		{
+			v.len++;
+		}
+		nvm_read(p, v.len - 1);
+		pool_unlock(p);
+		return v;
+	}
+	int64_t at;
+	index_seg* s = index_find(p, offset, &at);
+	if (index_mapped(index_seg_entry(p, s, at)) == 1 && (v.data_type != 3 || p->map_version != 2)) //run of data in the mapped file, at a fixed stride
+	{
+		uint64_t n = (uintptr_t) index_seg_entry(p, s, at) >> 1;
+		v.raw = map_data(p, n);
+		while (v.len < max_len && at + v.len < s->count)
+		{
+			OID * tmp = index_seg_entry(p, s, at + v.len);
+			if (index_mapped(tmp) == 0 || ((uintptr_t) tmp >> 1) != n + v.len || map_type(p, n + v.len) != v.data_type)
+			{
+				break;
+			}
+			const char* next = map_data(p, n + v.len);
+			if (v.len == 1)
+			{
+				v.stride = next - v.raw;
+			}
+			else if (next != v.raw + v.len * v.stride)
+			{
+				break;
+			}
+			v.len++;
+		}
+		nvm_read(p, v.len - 1); //the first object was read by oid_type
+		pool_unlock(p);
+		return v;
+	}
+
+	v.oids = oid_at(p, offset); //oidptrs of a version 2 file are pool name #s and offsets, so they are resolved in an OID
+	if (v.oids == NULL) //its blob could not be copied out of the file
+	{
+		v.len = 0;
+	}
+	s = index_find(p, offset, &at); //bringing the OID in may have cut its segment
+	while (v.len > 0 && v.len < max_len && at + v.len < s->count)
+	{
+		OID * tmp = s->slots[at + v.len];
+		if (tmp != v.oids + v.len || tmp->empty == 1 || tmp->data_type != v.data_type)
+		{
+			break;
+		}
+		v.len++;
+	}
+	nvm_read(p, v.len - 1); //the first object was read by oid_type
+	pool_unlock(p);
+	return v;
+}
+
+//returns the int at index i of a view of ints
+int pview_int(pview v, int64_t i)
+{
+	if (v.oids == NULL)
+	{
+		int num;
+		memcpy(&num, v.raw + i * v.stride, sizeof(int));
+		return num;
+	}
+	return (int) (intptr_t) v.oids[i].data;
+}
+
+//returns the char at index i of a view of chars
+char pview_char(pview v, int64_t i)
+{
+	if (v.oids == NULL)
+	{
+		return v.raw[i * v.stride];
+	}
+	return (char) (intptr_t) v.oids[i].data;
+}
+
+//returns the ptr at index i of a view of ptrs
+void* pview_ptr(pview v, int64_t i)
+{
+	if (v.oids == NULL)
+	{
+		void* ptr;
+		memcpy(&ptr, v.raw + i * v.stride, sizeof(void*));
+		return ptr;
+	}
+	return v.oids[i].data;
+}
+
+//returns a certain pool in the pool LL
+pool* getpool(const char* name)
+{
+	registry_lock_take();
+	pool* p = head_pool;
+
+	if (p == NULL) //NULL head_pool exception
+	{
+		registry_lock_give();
+		pool_log(POOL_ENOENT, "No pools have been created yet!");
+		return NULL;
+	}
+
+	do
+	{
+		if (strcmp(p->name, name) == 0)
+		{
+			registry_lock_give();
+			return p;
+		}
+		p = p->next;
+	} 
+	while (p->next != NULL);
+
+	registry_lock_give();
+	pool_log(POOL_ENOENT, "No pool of name %s found!", name);
+	return NULL;
+}
+
+
+//READING AND WRITING:
+
+//Write int to a pool
+int pwriteint(pool* p, int num)
+{
+	trace_call(TRACE_PWRITEINT, p, NULL, num, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+	}
+	else
+	{
+		pool_lock(p, LOCK_PWRITE);
+		int error = POOL_OK;
+		OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	
+		if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			tmp->data = (int*) num;
+			tmp->data_size = sizeof(int);
 			tmp->data_type = 1;
 			tmp->empty = 0;
+			POOL_STAT(p, bytes_written, sizeof(int));
+			oid_dirty(tmp);
+			nvm_write(p, sizeof(int));
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Write char to a pool
+int pwritechar(pool* p, char c)
+{
+	trace_call(TRACE_PWRITECHAR, p, NULL, c, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_PWRITE);
+		int error = POOL_OK;
+		OID * tmp = p->text == NULL ? pool_first_empty(p) : NULL; //first OID of the pool with no data
+	
+		if (p->text != NULL) //text pools add it to the end of their text
+		{
+			error = text_insert(p, p->size, text_add(p, &c, 1), 1);
+			if (error == POOL_OK)
+			{
+				POOL_STAT(p, bytes_written, sizeof(char));
+				nvm_write(p, sizeof(char));
+			}
+		}
+		else if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			tmp->data = (int*) ((int)c);
+			tmp->data_size = sizeof(int);
+			tmp->data_type = 2;
+			tmp->empty = 0;
+			POOL_STAT(p, bytes_written, sizeof(char));
+			oid_dirty(tmp);
+			nvm_write(p, sizeof(char));
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Write string to a pool
+int pwritestr(pool* p, const char* string)
+{
+	trace_call(TRACE_PWRITESTR, p, NULL, 0, 0, string);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_PWRITE);
+		int error = POOL_OK;
+		OID * tmp = p->text == NULL ? pool_first_empty(p) : NULL; //first OID of the pool with no data
+		int64_t at = tmp == NULL ? p->size : index_offset(tmp);
+	
+		if (p->text != NULL) //text pools add it to the end of their text
+		{
+			int64_t sl = strlen(string);
+			error = text_insert(p, p->size, text_add(p, string, sl), sl);
+			if (error == POOL_OK)
+			{
+				POOL_STAT(p, bytes_written, sl);
+				nvm_write(p, sl);
+			}
+		}
+		else if (tmp == NULL || at >= p->size - 1)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			int64_t i;
+			int64_t sl = strlen(string);
+			for (i = 0; i < sl; i++)
+			{
+				tmp->data = (int*) ((int)string[i]); //writes char to OIDs
+				tmp->data_size = sizeof(int);
+				tmp->data_type = 2;
+				tmp->empty = 0;
+				POOL_STAT(p, bytes_written, sizeof(char));
+				oid_dirty(tmp);
+				nvm_write(p, sizeof(char));
+				if (at >= p->size - 1)
+				{
+					error = pool_log(POOL_EFULL, "Not enough space in pool. Stopped writng to pool at string index %lld", (long long) i);
+					break;			
+				}
+				else if ((tmp = oid_at(p, at + 1)) == NULL) //page of an out-of-core pool not brought in
+				{
+					error = pool_errno;
+					break;
+				}
+				else
+				{
+					at++;
+				}
+			}
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Write ptr to a pool
+int pwriteptr(pool* p, void* ptr)
+{
+	trace_call(TRACE_PWRITEPTR, p, ptr == NULL ? NULL : ((OID*) ptr)->pool, 0, trace_offset(ptr), NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+	}
+	else
+	{
+		pool_lock(p, LOCK_PWRITE);
+		int error = POOL_OK;
+		OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	
+		if (ptr != NULL && ((OID*) ptr)->pool->buffer != NULL) //OIDs of out-of-core pools do not stay in place
+		{
+			error = pool_log(POOL_EINVAL, "oidptrs cannot point into out-of-core pool %s!", ((OID*) ptr)->pool->name);
+		}
+		else if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			tmp->data = ptr;
+			tmp->data_size = sizeof(ptr);
+			tmp->data_type = 3;
+			tmp->empty = 0;
+			oidptr_count(p, ptr, 1);
+			POOL_STAT(p, bytes_written, sizeof(ptr));
+			oid_dirty(tmp);
+			nvm_write(p, sizeof(ptr));
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Write a blob of size bytes to a pool
+int pwrite_blob(pool* p, const void* buf, size_t size)
+{
+	trace_call(TRACE_PWRITE_BLOB, p, NULL, (int64_t) size, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+	}
+	else if (size > BLOB_MAX_SIZE) //blob too large exception
+	{
+		return pool_log(POOL_EINVAL, "Blobs must be less than 4 GiB!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_PWRITE);
+		int error = POOL_OK;
+		OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+		void* copy = tmp == NULL || size <= BLOB_INLINE_SIZE ? NULL : arena_blob_alloc(&p->arena, size); //large blobs get their own extent
+
+		if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else if (size > BLOB_INLINE_SIZE && copy == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Could not make a blob of %llu bytes!", (unsigned long long) size);
+		}
+		else
+		{
+			tmp->data = NULL;
+			if (size <= BLOB_INLINE_SIZE) //small blobs are copied into the data field
+			{
+				memcpy(&tmp->data, buf, size);
+			}
+			else
+			{
+				memcpy(copy, buf, size);
+				tmp->data = copy;
+			}
+			tmp->data_size = size;
+			tmp->data_type = 4;
+			tmp->empty = 0;
+			POOL_STAT(p, bytes_written, size);
+			oid_dirty(tmp);
+			nvm_write(p, size);
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Read a pool
+int preadf(pool* p)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_PREAD);
+		int error = POOL_OK;
+		OID scratch;
+		int64_t i = 0;
+		while (i < p->size)
+		{
+			const OID * tmp = oid_peek(p, i, &scratch);
+			nvm_read(p, 1);
+			if (tmp == NULL)
+			{
+				error = pool_errno;
+				break;
+			}
+			else if (tmp->empty == 1)
+			{
+				break;
+			}
+
+			if (tmp->data_type == 1)
+			{
+				printf("%d|", (int) tmp->data);
+			}
+			else if (tmp->data_type == 2)
+			{
+				printf("%c|", (int) tmp->data);
+			}
+			else if (tmp->data_type == 3 && tmp->data == NULL)
+			{
+				printf("oidptr: NULL\n");
+			}
+			else if (tmp->data_type == 3)
+			{
+				printf("oidptr: pool:%s offset:%lld\n", ((OID*)(tmp->data))->pool->name, (long long) oid_offset(tmp->data));
+			}
+			else if (tmp->data_type == 4)
+			{
+				printf("blob:%zu bytes|", tmp->data_size);
+			}
+			else
+			{
+				error = pool_log(POOL_EBADF, "Invalid data type at offset %lld!", (long long) i);
+			}
+			i++;
+		}
+	
+		printf("\n");
+		pool_unlock(p);
+		return error;
+	}
+}
+
+
+//TEXT EDITING
+
+//returns POOL_OK if len chars at offset can be edited in pool p's text, or logs why not and returns the error code
+int ptext_check(pool* p, int64_t offset, int64_t len)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text == NULL) //only text pools are edited in place
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is not a text pool!", p->name);
+	}
+	else if (len < 0 || offset < 0 || offset > p->size - len)
+	{
+		return pool_log(POOL_ERANGE, "Range %lld+%lld is out of range for pool %s!", (long long) offset, (long long) len, p->name);
+	}
+	return POOL_OK;
+}
+
+//Insert string into text pool p before the char at offset (offset p->size adds it to the end)
+int ptext_insert(pool* p, int64_t offset, const char* string)
+{
+	trace_call(TRACE_PTEXT_INSERT, p, NULL, offset, 0, string);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (string == NULL) //string NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified string is NULL!");
+	}
+	pool_lock(p, LOCK_PWRITE);
+	int error = ptext_check(p, offset, 0);
+	int64_t sl = strlen(string);
+	if (error == POOL_OK && (error = text_insert(p, offset, text_add(p, string, sl), sl)) == POOL_OK)
+	{
+		POOL_STAT(p, bytes_written, sl);
+		nvm_write(p, sl);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Delete len chars of text pool p from offset on
+int ptext_delete(pool* p, int64_t offset, int64_t len)
+{
+	trace_call(TRACE_PTEXT_DELETE, p, NULL, offset, len, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	pool_lock(p, LOCK_PWRITE);
+	int error = ptext_check(p, offset, len);
+	if (error == POOL_OK)
+	{
+		error = text_delete(p, offset, len);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Replace len chars of text pool p from offset on with string, which may be of another length
+int ptext_replace(pool* p, int64_t offset, int64_t len, const char* string)
+{
+	trace_call(TRACE_PTEXT_REPLACE, p, NULL, offset, len, string);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (string == NULL) //string NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified string is NULL!");
+	}
+	pool_lock(p, LOCK_PWRITE);
+	int error = ptext_check(p, offset, len);
+	int64_t sl = strlen(string);
+	if (error == POOL_OK && (error = text_edit(p, offset, len, text_add(p, string, sl), sl)) == POOL_OK) //one edit, so a failure changes nothing
+	{
+		POOL_STAT(p, bytes_written, sl);
+		nvm_write(p, sl);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+
+//VECTORS
+
+//A vector is a growable array of fixed-size elements kept in one blob object of a pool: a pvec_header, then room for
+//capacity elements. It is handed around as its OID, so a vector made first in an empty pool is the pool's root
+//object and is found again with pool_root after pool_open (or with getoid at the offset it was made at).
+//Growing copies the elements into a new extent twice the size and only then points the OID at it, so the old
+//blob stays whole until the new one is; sizes only change after the elements they cover are written.
+
+//returns the most elements of elem_size bytes a vector can have room for (see BLOB_MAX_SIZE)
+uint64_t pvec_max_cap(uint32_t elem_size)
+{
+	return blob_max_count(sizeof(pvec_header), elem_size);
+}
+
+//returns the header of vector v (pool lock held), or logs why v is not a vector and returns NULL
+pvec_header* pvec_check(OID* v)
+{
+	if (v->empty == 1 || v->data_type != 4 || v->data_size < sizeof(pvec_header))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a vector!");
+		return NULL;
+	}
+	pvec_header* h = v->data;
+	if (le32(h->magic) != PVEC_MAGIC || le32(h->elem_size) == 0 || le64(h->capacity) > pvec_max_cap(le32(h->elem_size))
+		|| le64(h->size) > le64(h->capacity) || v->data_size < sizeof(pvec_header) + le64(h->capacity) * le32(h->elem_size))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a vector!");
+		return NULL;
+	}
+	return h;
+}
+
+//Give vector v of pool p room for at least cap elements (pool lock held), returns its header or NULL after logging
+//POOL_EINVAL for a capacity too large to address or POOL_EFULL if out of memory.
+//The elements are copied into a new extent before the OID points at it, then the old extent is freed.
+pvec_header* pvec_grow(pool* p, OID* v, pvec_header* h, uint64_t cap)
+{
+	uint64_t old_cap = le64(h->capacity);
+	if (cap <= old_cap)
+	{
+		return h;
+	}
+	uint32_t elem_size = le32(h->elem_size);
+	uint64_t max_cap = pvec_max_cap(elem_size);
+	if (cap > max_cap) //capacity overflow exception
+	{
+		pool_log(POOL_EINVAL, "A vector of %u-byte elements cannot hold %llu elements!", elem_size, (unsigned long long) cap);
+		return NULL;
+	}
+	uint64_t new_cap = old_cap > PVEC_MIN_CAP ? old_cap : PVEC_MIN_CAP;
+	while (new_cap < cap) //grows geometrically so pushes take amortized O(1)
+	{
+		new_cap = new_cap > max_cap / 2 ? max_cap : new_cap * 2;
+	}
+	size_t bytes = sizeof(pvec_header) + new_cap * elem_size;
+	pvec_header* n = arena_blob_alloc(&p->arena, bytes);
+	if (n == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not grow vector to %llu elements!", (unsigned long long) new_cap);
+		return NULL;
+	}
+	size_t used = sizeof(pvec_header) + le64(h->size) * elem_size;
+	memcpy(n, h, used);
+	memset((char*) n + used, 0, bytes - used);
+	n->capacity = le64(new_cap);
+	nvm_write(p, used);
+
+	void* old = v->data; //the new blob is whole before the OID moves to it
+	size_t old_bytes = v->data_size;
+	__atomic_store_n(&v->data, (void*) n, __ATOMIC_RELEASE);
+	v->data_size = bytes;
+	oid_dirty(v);
+	arena_blob_free(&p->arena, old, old_bytes);
+	return n;
+}
+
+//Create a vector of elements of elem_size bytes with room for cap elements in the first empty OID of pool p
+//and return its OID (NULL on error)
+OID* pvec_create(pool* p, size_t elem_size, int64_t cap)
+{
+	trace_call(TRACE_PVEC_CREATE, p, NULL, (int64_t) elem_size, cap, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+		return NULL;
+	}
+	else if (elem_size < 1 || elem_size > UINT32_MAX || cap < 0) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "Vector elements must be 1 to 2^32-1 bytes and the capacity cannot be negative!");
+		return NULL;
+	}
+	else if ((uint64_t) cap > pvec_max_cap((uint32_t) elem_size)) //capacity overflow exception
+	{
+		pool_log(POOL_EINVAL, "A vector of %u-byte elements cannot hold %llu elements!", (uint32_t) elem_size, (unsigned long long) cap);
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_PWRITE);
+	OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	if (tmp == NULL)
+	{
+		pool_log(POOL_EFULL, "Pool already full!");
+		pool_unlock(p);
+		return NULL;
+	}
+	size_t bytes = sizeof(pvec_header) + (size_t) cap * elem_size;
+	pvec_header* h = arena_blob_alloc(&p->arena, bytes);
+	if (h == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not make a vector of %lld elements!", (long long) cap);
+		pool_unlock(p);
+		return NULL;
+	}
+	memset(h, 0, bytes);
+	h->magic = le32(PVEC_MAGIC);
+	h->elem_size = le32((uint32_t) elem_size);
+	h->capacity = le64((uint64_t) cap);
+	tmp->data = h;
+	tmp->data_size = bytes;
+	tmp->data_type = 4;
+	tmp->empty = 0;
+	POOL_STAT(p, bytes_written, sizeof(pvec_header));
+	oid_dirty(tmp);
+	nvm_write(p, sizeof(pvec_header));
+	pool_unlock(p);
+	return tmp;
+}
+
+//returns the # of elements of vector v (-1 if v is not a vector)
+int64_t pvec_size(OID* v)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	else if (v->pool->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return -1;
+	}
+	pool_lock(v->pool, LOCK_PREAD);
+	pvec_header* h = pvec_check(v);
+	int64_t size = h == NULL ? -1 : (int64_t) le64(h->size);
+	pool_unlock(v->pool);
+	return size;
+}
+
+//returns the # of elements vector v has room for before it grows (-1 if v is not a vector)
+int64_t pvec_capacity(OID* v)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	else if (v->pool->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return -1;
+	}
+	pool_lock(v->pool, LOCK_PREAD);
+	pvec_header* h = pvec_check(v);
+	int64_t cap = h == NULL ? -1 : (int64_t) le64(h->capacity);
+	pool_unlock(v->pool);
+	return cap;
+}
+
+//returns where element i of vector v is (NULL if i is out of range), valid until the vector next grows
+void* pvec_at(OID* v, int64_t i)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return NULL;
+	}
+	else if (v->pool->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	pool_lock(v->pool, LOCK_PREAD);
+	pvec_header* h = pvec_check(v);
+	void* elem = NULL;
+	if (h != NULL && i >= 0 && (uint64_t) i < le64(h->size))
+	{
+		elem = (char*) (h + 1) + (size_t) i * le32(h->elem_size);
+		nvm_read(v->pool, 1);
+	}
+	else if (h != NULL)
+	{
+		pool_errno = POOL_ERANGE;
+	}
+	pool_unlock(v->pool);
+	return elem;
+}
+
+//Add n elements from elems to the end of vector v, growing it if needed. Returns POOL_OK or an error code.
+int pvec_append(OID* v, const void* elems, int64_t n)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PVEC_APPEND, NULL, NULL, 0, n, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = v->pool;
+	pool_lock(p, LOCK_PWRITE);
+	trace_call(TRACE_PVEC_APPEND, p, NULL, trace_offset(v), n, NULL);
+	int error = POOL_OK;
+	pvec_header* h = p->closed == 1 ? NULL : pvec_check(v);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	else if (n < 0 || (n > 0 && elems == NULL))
+	{
+		error = pool_log(POOL_EINVAL, "pvec_append needs n >= 0 elements!");
+	}
+	else if (n > 0 && (h = pvec_grow(p, v, h, le64(h->size) + n)) == NULL)
+	{
+		error = pool_errno;
+	}
+	else if (n > 0)
+	{
+		uint32_t elem_size = le32(h->elem_size);
+		uint64_t size = le64(h->size);
+		memcpy((char*) (h + 1) + size * elem_size, elems, (size_t) n * elem_size);
+		nvm_write(p, (size_t) n * elem_size);
+		__atomic_store_n(&h->size, le64(size + n), __ATOMIC_RELEASE); //the elements are written before they count
+		POOL_STAT(p, bytes_written, (uint64_t) n * elem_size);
+		oid_dirty(v);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Add one element to the end of vector v in amortized O(1). Returns POOL_OK or an error code.
+int pvec_push(OID* v, const void* elem)
+{
+	trace_quiet++; //recorded as a whole by pvec_append
+	int error = pvec_append(v, elem, 1);
+	trace_quiet--;
+	return error;
+}
+
+//Change the # of elements of vector v to n, growing it if needed; new elements are zeroed.
+//Returns POOL_OK or an error code.
+int pvec_resize(OID* v, int64_t n)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PVEC_RESIZE, NULL, NULL, 0, n, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = v->pool;
+	pool_lock(p, LOCK_PWRITE);
+	trace_call(TRACE_PVEC_RESIZE, p, NULL, trace_offset(v), n, NULL);
+	int error = POOL_OK;
+	pvec_header* h = p->closed == 1 ? NULL : pvec_check(v);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	else if (n < 0)
+	{
+		error = pool_log(POOL_EINVAL, "Vector size cannot be negative!");
+	}
+	else if ((h = pvec_grow(p, v, h, (uint64_t) n)) == NULL)
+	{
+		error = pool_errno;
+	}
+	else
+	{
+		uint32_t elem_size = le32(h->elem_size);
+		uint64_t size = le64(h->size);
+		if ((uint64_t) n > size) //the elements past the old size are zeroed before they count
+		{
+			memset((char*) (h + 1) + size * elem_size, 0, (n - size) * elem_size);
+			nvm_write(p, (n - size) * elem_size);
+		}
+		__atomic_store_n(&h->size, le64((uint64_t) n), __ATOMIC_RELEASE);
+		oid_dirty(v);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Give vector v room for at least cap elements without changing its size. Returns POOL_OK or an error code.
+int pvec_reserve(OID* v, int64_t cap)
+{
+	if (v == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PVEC_RESERVE, NULL, NULL, 0, cap, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = v->pool;
+	pool_lock(p, LOCK_PWRITE);
+	trace_call(TRACE_PVEC_RESERVE, p, NULL, trace_offset(v), cap, NULL);
+	int error = POOL_OK;
+	pvec_header* h = p->closed == 1 ? NULL : pvec_check(v);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	else if (cap > 0 && pvec_grow(p, v, h, (uint64_t) cap) == NULL)
+	{
+		error = pool_errno;
+	}
+	pool_unlock(p);
+	return error;
+}
+
+
+//HASH MAPS
+
+//A hash map is a persistent key/value index of fixed-size keys and values kept in one blob object of a pool:
+//a phash_header, the control bytes and the slots of its table (see HASH TABLES). Like a vector it is handed around
+//as its OID, so a map made first in an empty pool is the pool's root object and is found again with pool_root after
+//pool_open. A map is resized into a table twice the size once it is 7/8 full; while its keys move, writes to it
+//carry the move on PHASH_MOVE_GROUPS groups at a time and pfileout finishes it, so the blob written out is one table.
+
+//returns the table of hash map m (pool lock held), or logs why m is not a hash map and returns NULL
+phash_header* phash_check(OID* m)
+{
+	if (m->empty == 1 || m->data_type != 4 || m->data_size < sizeof(phash_header))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a hash map!");
+		return NULL;
+	}
+	phash_header* h = m->data;
+	uint64_t cap = le64(h->capacity);
+	if (le32(h->magic) != PHASH_MAGIC || le32(h->key_size) == 0 || cap < PHASH_MIN_CAP || (cap & (cap - 1)) != 0
+		|| cap > blob_max_count(sizeof(phash_header), phash_slot_size(h) + 1) || m->data_size < phash_bytes(cap, phash_slot_size(h)))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a hash map!");
+		return NULL;
+	}
+	return h;
+}
+
+//returns the first 8 bytes of a key of key_size bytes as a little-endian word, which is all of it a trace keeps
+int64_t phash_trace_key(const void* key, size_t key_size)
+{
+	uint64_t word = 0;
+	size_t i;
+	for (i = 0; key != NULL && i < key_size && i < 8; i++)
+	{
+		word = word | (uint64_t) ((const unsigned char*) key)[i] << (8 * i);
+	}
+	return (int64_t) word;
+}
+
+//Create a hash map of keys of key_size bytes and values of value_size bytes with room for about cap keys
+//in the first empty OID of pool p and return its OID (NULL on error)
+OID* phash_create(pool* p, size_t key_size, size_t value_size, int64_t cap)
+{
+	trace_call(TRACE_PHASH_CREATE, p, NULL, (int64_t) ((uint64_t) key_size << 32 | (value_size & UINT32_MAX)), cap, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+		return NULL;
+	}
+	else if (key_size < 1 || key_size > UINT32_MAX || value_size > UINT32_MAX || cap < 0) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "Hash map keys must be 1 to 2^32-1 bytes, values less than 2^32 and the capacity cannot be negative!");
+		return NULL;
+	}
+
+	uint64_t slots = PHASH_MIN_CAP;
+	while (slots - slots / 8 < (uint64_t) cap) //cap keys fit without a resize
+	{
+		slots = slots * 2;
+	}
+	size_t slot_size = PHASH_PAD(key_size) + PHASH_PAD(value_size);
+	if (slots > blob_max_count(sizeof(phash_header), slot_size + 1)) //map size overflow exception
+	{
+		pool_log(POOL_EINVAL, "A hash map of %llu-byte slots cannot hold %lld keys!", (unsigned long long) slot_size, (long long) cap);
+		return NULL;
+	}
+	size_t bytes = phash_bytes(slots, slot_size);
+
+	pool_lock(p, LOCK_PWRITE);
+	OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	if (tmp == NULL)
+	{
+		pool_log(POOL_EFULL, "Pool already full!");
+		pool_unlock(p);
+		return NULL;
+	}
+	phash_header* h = arena_blob_alloc(&p->arena, bytes);
+	if (h == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not make a hash map of %llu slots!", (unsigned long long) slots);
+		pool_unlock(p);
+		return NULL;
+	}
+	memset(h, 0, sizeof(phash_header));
+	memset(h + 1, PHASH_EMPTY, slots);
+	memset((char*) (h + 1) + slots, 0, slots * slot_size);
+	h->magic = le32(PHASH_MAGIC);
+	h->key_size = le32((uint32_t) key_size);
+	h->value_size = le32((uint32_t) value_size);
+	h->capacity = le64(slots);
+	tmp->data = h;
+	tmp->data_size = bytes;
+	tmp->data_type = 4;
+	tmp->empty = 0;
+	POOL_STAT(p, bytes_written, sizeof(phash_header) + slots);
+	oid_dirty(tmp);
+	nvm_write(p, sizeof(phash_header) + slots);
+	pool_unlock(p);
+	return tmp;
+}
+
+//returns the # of keys in hash map m (-1 if m is not a hash map)
+int64_t phash_count(OID* m)
+{
+	if (m == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	else if (m->pool->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return -1;
+	}
+	pool_lock(m->pool, LOCK_PREAD);
+	phash_header* h = phash_check(m);
+	int64_t count = h == NULL ? -1 : (int64_t) le64(h->count);
+	pool_unlock(m->pool);
+	return count;
+}
+
+//returns where the value of key is in hash map m (NULL if the key is not in the map, leaving POOL_ENOENT in pool_errno),
+//valid until the next write to the map
+void* phash_get(OID* m, const void* key)
+{
+	if (m == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PHASH_GET, NULL, NULL, 0, 0, NULL);
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return NULL;
+	}
+	pool* p = m->pool;
+	pool_lock(p, LOCK_PREAD);
+	phash_header* h = p->closed == 1 ? NULL : phash_check(m);
+	trace_call(TRACE_PHASH_GET, p, NULL, trace_offset(m), phash_trace_key(key, h == NULL ? 0 : le32(h->key_size)), NULL);
+	void* value = NULL;
+	if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h != NULL && key == NULL)
+	{
+		pool_log(POOL_EINVAL, "The specified key is NULL!");
+	}
+	else if (h != NULL)
+	{
+		size_t key_size = le32(h->key_size);
+		uint64_t hash = phash_hash(key, key_size);
+		int64_t i = phash_find(h, key, hash);
+		phash_move* mv = i < 0 && p->hash_move_count > 0 ? phash_moving(p, m) : NULL;
+		if (mv != NULL) //keys not moved yet are still in the old table
+		{
+			h = (phash_header*) mv->old;
+			i = phash_find(h, key, hash);
+		}
+		if (i >= 0)
+		{
+			value = phash_slot(h, (uint64_t) i) + PHASH_PAD(key_size);
+		}
+		else
+		{
+			pool_errno = POOL_ENOENT;
+		}
+		nvm_read(p, 2);
+	}
+	pool_unlock(p);
+	return value;
+}
+
+//Put key in hash map m with value (zeroed if NULL), replacing the value the key had. Returns POOL_OK or an error code.
+int phash_put(OID* m, const void* key, const void* value)
+{
+	if (m == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PHASH_PUT, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = m->pool;
+	pool_lock(p, LOCK_PWRITE);
+	phash_header* h = p->closed == 1 ? NULL : phash_check(m);
+	trace_call(TRACE_PHASH_PUT, p, NULL, trace_offset(m), phash_trace_key(key, h == NULL ? 0 : le32(h->key_size)), NULL);
+	if (p->closed == 1) //pool closed exception
+	{
+		pool_unlock(p);
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		pool_unlock(p);
+		return POOL_ETYPE;
+	}
+	else if (key == NULL)
+	{
+		pool_unlock(p);
+		return pool_log(POOL_EINVAL, "The specified key is NULL!");
+	}
+
+	size_t key_size = le32(h->key_size);
+	size_t value_size = le32(h->value_size);
+	uint64_t hash = phash_hash(key, key_size);
+	phash_move* mv = p->hash_move_count > 0 ? phash_moving(p, m) : NULL;
+	if (mv != NULL) //each write carries the move on
+	{
+		phash_step(p, mv, PHASH_MOVE_GROUPS);
+		mv = phash_moving(p, m);
+	}
+	int64_t i = phash_find(h, key, hash);
+	if (i < 0)
+	{
+		uint64_t cap = le64(h->capacity);
+		if (le64(h->count) - (mv == NULL ? 0 : mv->left) + le64(h->deleted) + 1 > cap - cap / 8) //no room for another key
+		{
+			if (mv != NULL) //the new table filled before the old one emptied, so the move is finished first
+			{
+				phash_step(p, mv, UINT64_MAX);
+				mv = NULL;
+				i = phash_find(h, key, hash);
+			}
+			if (i < 0 && le64(h->count) + le64(h->deleted) + 1 > cap - cap / 8)
+			{
+				uint64_t new_cap = cap;
+				while (new_cap < 2 * (le64(h->count) + 1)) //half full after the resize; tables never shrink
+				{
+					new_cap = new_cap * 2;
+				}
+				h = phash_rehash(p, m, h, new_cap);
+				if (h == NULL)
+				{
+					pool_unlock(p);
+					return POOL_EFULL;
+				}
+				mv = phash_moving(p, m);
+			}
+		}
+	}
+	if (i >= 0) //replaces the value in place
+	{
+		char* slot = phash_slot(h, (uint64_t) i);
+		if (value != NULL)
+		{
+			memcpy(slot + PHASH_PAD(key_size), value, value_size);
+		}
+		else
+		{
+			memset(slot + PHASH_PAD(key_size), 0, value_size);
+		}
+		nvm_write(p, value_size);
+	}
+	else
+	{
+		int64_t j = mv == NULL ? -1 : phash_find((phash_header*) mv->old, key, hash);
+		if (j >= 0) //the key leaves the old table for the new one
+		{
+			phash_erase(p, (phash_header*) mv->old, (uint64_t) j);
+			mv->left--;
+		}
+		else
+		{
+			h->count = le64(le64(h->count) + 1);
+		}
+		phash_place(p, h, key, value, hash);
+	}
+	POOL_STAT(p, bytes_written, value_size);
+	oid_dirty(m);
+	pool_unlock(p);
+	return POOL_OK;
+}
+
+//Remove key from hash map m. Returns POOL_OK, POOL_ENOENT if the key is not in the map or an error code.
+int phash_remove(OID* m, const void* key)
+{
+	if (m == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PHASH_REMOVE, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = m->pool;
+	pool_lock(p, LOCK_PWRITE);
+	phash_header* h = p->closed == 1 ? NULL : phash_check(m);
+	trace_call(TRACE_PHASH_REMOVE, p, NULL, trace_offset(m), phash_trace_key(key, h == NULL ? 0 : le32(h->key_size)), NULL);
+	int error = POOL_OK;
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	else if (key == NULL)
+	{
+		error = pool_log(POOL_EINVAL, "The specified key is NULL!");
+	}
+	else
+	{
+		uint64_t hash = phash_hash(key, le32(h->key_size));
+		phash_move* mv = p->hash_move_count > 0 ? phash_moving(p, m) : NULL;
+		if (mv != NULL)
+		{
+			phash_step(p, mv, PHASH_MOVE_GROUPS);
+			mv = phash_moving(p, m);
+		}
+		int64_t i = phash_find(h, key, hash);
+		int64_t j = i < 0 && mv != NULL ? phash_find((phash_header*) mv->old, key, hash) : -1;
+		if (i >= 0)
+		{
+			phash_erase(p, h, (uint64_t) i);
+		}
+		else if (j >= 0)
+		{
+			phash_erase(p, (phash_header*) mv->old, (uint64_t) j);
+			mv->left--;
+		}
+		else //a key that is not there is not an error worth a message
+		{
+			error = POOL_ENOENT;
+			pool_errno = POOL_ENOENT;
+		}
+		if (error == POOL_OK)
+		{
+			h->count = le64(le64(h->count) - 1);
+			oid_dirty(m);
+		}
+	}
+	pool_unlock(p);
+	return error;
+}
+
+
+//B+-TREES
+
+//A B+-tree keeps fixed-size values in order of their int or string keys in one blob object of a pool, an array of
+//page-sized nodes whose header is node 0. Like a vector it is handed around as its OID, so a tree made first in an
+//empty pool is the pool's root object. Nodes are never changed once they are part of the tree (values replaced by
+//pbtree_put aside): a write builds the new leaf, or the new nodes of a split up to the first parent with room, in free
+//nodes and makes them part of the tree with one 8-byte store of a child or the root, then frees the nodes they replace.
+//A tree stopped half way through a write is the tree from before it, and iterators need no links between leaves.
+
+//returns node i of tree h
+pbtree_node* pbtree_at(pbtree_header* h, uint64_t i)
+{
+	return (pbtree_node*) ((char*) h + i * PBTREE_NODE_SIZE);
+}
+
+//returns the # of bytes between the values of a leaf of tree h
+size_t pbtree_value_stride(const pbtree_header* h)
+{
+	return ((size_t) le32(h->value_size) + 7) & ~(size_t) 7;
+}
+
+//returns the # of keys a leaf of tree h has room for
+uint32_t pbtree_leaf_cap(const pbtree_header* h)
+{
+	return (PBTREE_NODE_SIZE - sizeof(pbtree_node) - 8) / (le32(h->key_size) + pbtree_value_stride(h));
+}
+
+//returns the # of keys an inner node of tree h has room for
+uint32_t pbtree_inner_cap(const pbtree_header* h)
+{
+	return (PBTREE_NODE_SIZE - sizeof(pbtree_node) - 16) / (le32(h->key_size) + sizeof(uint64_t));
+}
+
+//returns key i of node x of tree h
+char* pbtree_key_at(const pbtree_header* h, pbtree_node* x, uint32_t i)
+{
+	return (char*) (x + 1) + (size_t) i * le32(h->key_size);
+}
+
+//returns value i of leaf x of tree h
+char* pbtree_value_at(const pbtree_header* h, pbtree_node* x, uint32_t i)
+{
+	size_t keys = ((size_t) pbtree_leaf_cap(h) * le32(h->key_size) + 7) & ~(size_t) 7;
+	return (char*) (x + 1) + keys + i * pbtree_value_stride(h);
+}
+
+//returns the children of inner node x of tree h
+uint64_t* pbtree_children(const pbtree_header* h, pbtree_node* x)
+{
+	size_t keys = ((size_t) pbtree_inner_cap(h) * le32(h->key_size) + 7) & ~(size_t) 7;
+	return (uint64_t*) ((char*) (x + 1) + keys);
+}
+
+//returns <0, 0 or >0 as stored key a of tree h is below, equal to or above stored key b
+int pbtree_cmp(const pbtree_header* h, const void* a, const void* b)
+{
+	if (le32(h->key_type) == PBTREE_INT)
+	{
+		uint64_t x;
+		uint64_t y;
+		memcpy(&x, a, 8);
+		memcpy(&y, b, 8);
+		int64_t ix = (int64_t) le64(x);
+		int64_t iy = (int64_t) le64(y);
+		return (ix > iy) - (ix < iy);
+	}
+	return memcmp(a, b, le32(h->key_size));
+}
+
+//Store key as it is kept in tree h into buf (PBTREE_MAX_KEY bytes): an int64_t in little-endian order or a string
+//padded with zeros. returns POOL_OK or logs why the key does not fit.
+int pbtree_key(const pbtree_header* h, const void* key, char* buf)
+{
+	size_t key_size = le32(h->key_size);
+	if (key == NULL)
+	{
+		return pool_log(POOL_EINVAL, "The specified key is NULL!");
+	}
+	else if (le32(h->key_type) == PBTREE_INT)
+	{
+		uint64_t word;
+		memcpy(&word, key, 8);
+		word = le64(word);
+		memcpy(buf, &word, 8);
+		return POOL_OK;
+	}
+	size_t len = strnlen(key, key_size);
+	if (len == key_size)
+	{
+		return pool_log(POOL_EINVAL, "Keys of this tree are at most %u chars!", (unsigned) key_size - 1);
+	}
+	memcpy(buf, key, len);
+	memset(buf + len, 0, key_size - len);
+	return POOL_OK;
+}
+
+//returns the first key of node x of tree h above key (above or equal to it if equal is 1), or the # of keys if none is
+uint32_t pbtree_search(const pbtree_header* h, pbtree_node* x, const char* key, int equal)
+{
+	uint32_t lo = 0;
+	uint32_t hi = le32(x->n);
+	if (le32(h->key_type) == PBTREE_INT) //int keys sit 8 bytes apart and are compared without a call per key
+	{
+		uint64_t word;
+		memcpy(&word, key, 8);
+		int64_t k = (int64_t) le64(word);
+		const char* keys = pbtree_key_at(h, x, 0);
+		while (lo < hi)
+		{
+			uint32_t mid = (lo + hi) / 2;
+			memcpy(&word, keys + (size_t) mid * 8, 8);
+			int64_t m = (int64_t) le64(word);
+			if (m < k || (m == k && equal == 0))
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+	while (lo < hi)
+	{
+		uint32_t mid = (lo + hi) / 2;
+		int c = pbtree_cmp(h, pbtree_key_at(h, x, mid), key);
+		if (c < 0 || (c == 0 && equal == 0))
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//Walk tree h from the root to the leaf where key belongs, storing the nodes in path and the children taken in pos.
+//returns the level of the leaf (-1 if the tree is empty).
+int pbtree_descend(pbtree_header* h, const char* key, uint64_t* path, int* pos)
+{
+	uint64_t i = le64(h->root);
+	int depth = -1;
+	while (i != 0 && depth + 1 < PBTREE_MAX_HEIGHT)
+	{
+		depth++;
+		path[depth] = i;
+		pbtree_node* x = pbtree_at(h, i);
+		if (x->leaf == le32(1))
+		{
+			break;
+		}
+		pos[depth] = pbtree_search(h, x, key, 0);
+		i = le64(__atomic_load_n(&pbtree_children(h, x)[pos[depth]], __ATOMIC_ACQUIRE));
+	}
+	return depth;
+}
+
+//Make sure tree t of pool p, whose header is h, has need free nodes (pool lock held), returns its header or NULL if
+//out of memory. A larger blob is filled before the OID points at it, like a growing vector.
+pbtree_header* pbtree_reserve(pool* p, OID* t, pbtree_header* h, uint64_t need)
+{
+	uint64_t nodes = le64(h->nodes);
+	uint64_t used = le64(h->used);
+	if (nodes - used + le64(h->free_count) >= need)
+	{
+		return h;
+	}
+	uint64_t max_nodes = blob_max_count(0, PBTREE_NODE_SIZE);
+	if (need > max_nodes - used)
+	{
+		pool_log(POOL_EFULL, "B+-tree cannot grow past %llu nodes!", (unsigned long long) max_nodes);
+		return NULL;
+	}
+	uint64_t new_nodes = nodes * 2;
+	while (new_nodes - used < need)
+	{
+		new_nodes = new_nodes * 2;
+	}
+	new_nodes = new_nodes < max_nodes ? new_nodes : max_nodes;
+	pbtree_header* n = arena_blob_alloc(&p->arena, new_nodes * PBTREE_NODE_SIZE);
+	if (n == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not grow B+-tree to %llu nodes!", (unsigned long long) new_nodes);
+		return NULL;
+	}
+	memcpy(n, h, used * PBTREE_NODE_SIZE);
+	memset((char*) n + used * PBTREE_NODE_SIZE, 0, (new_nodes - used) * PBTREE_NODE_SIZE);
+	n->nodes = le64(new_nodes);
+	nvm_write(p, used * PBTREE_NODE_SIZE);
+
+	void* old = t->data; //the new blob is whole before the OID moves to it
+	size_t old_bytes = t->data_size;
+	__atomic_store_n(&t->data, (void*) n, __ATOMIC_RELEASE);
+	t->data_size = new_nodes * PBTREE_NODE_SIZE;
+	oid_dirty(t);
+	arena_blob_free(&p->arena, old, old_bytes);
+	return n;
+}
+
+//returns a free node of tree h, made a leaf of no keys (the tree has had room made for it with pbtree_reserve)
+uint64_t pbtree_alloc(pbtree_header* h, int leaf)
+{
+	uint64_t i = le64(h->free);
+	if (i != 0)
+	{
+		h->free = pbtree_at(h, i)->next_free;
+		h->free_count = le64(le64(h->free_count) - 1);
+	}
+	else
+	{
+		i = le64(h->used);
+		h->used = le64(i + 1);
+	}
+	pbtree_node* x = pbtree_at(h, i);
+	x->leaf = le32((uint32_t) leaf);
+	x->n = 0;
+	x->next_free = 0;
+	return i;
+}
+
+//Put node i of tree h on the free list once nothing in the tree leads to it
+void pbtree_release(pbtree_header* h, uint64_t i)
+{
+	pbtree_node* x = pbtree_at(h, i);
+	x->n = 0;
+	x->next_free = h->free;
+	h->free = le64(i);
+	h->free_count = le64(le64(h->free_count) + 1);
+}
+
+//Make node r take the place of the node at level top of path in tree h with one 8-byte store (the root if top is 0),
+//then free the nodes it replaces, from level top down to level depth
+void pbtree_publish(pool* p, pbtree_header* h, const uint64_t* path, const int* pos, int top, int depth, uint64_t r)
+{
+	if (top == 0)
+	{
+		__atomic_store_n(&h->root, le64(r), __ATOMIC_RELEASE);
+	}
+	else
+	{
+		__atomic_store_n(&pbtree_children(h, pbtree_at(h, path[top - 1]))[pos[top - 1]], le64(r), __ATOMIC_RELEASE);
+	}
+	nvm_write(p, sizeof(uint64_t));
+	int d;
+	for (d = top; d <= depth; d++)
+	{
+		pbtree_release(h, path[d]);
+	}
+}
+
+//Copy count entries of leaf src from entry from to leaf dst at entry to, both of tree h
+void pbtree_copy_entries(pbtree_header* h, pbtree_node* dst, uint32_t to, pbtree_node* src, uint32_t from, uint32_t count)
+{
+	memcpy(pbtree_key_at(h, dst, to), pbtree_key_at(h, src, from), (size_t) count * le32(h->key_size));
+	memcpy(pbtree_value_at(h, dst, to), pbtree_value_at(h, src, from), count * pbtree_value_stride(h));
+}
+
+//Write key and value (zeroed if NULL) as entry i of leaf x of tree h
+void pbtree_set_entry(pbtree_header* h, pbtree_node* x, uint32_t i, const char* key, const void* value)
+{
+	memcpy(pbtree_key_at(h, x, i), key, le32(h->key_size));
+	if (value != NULL)
+	{
+		memcpy(pbtree_value_at(h, x, i), value, le32(h->value_size));
+	}
+	else
+	{
+		memset(pbtree_value_at(h, x, i), 0, le32(h->value_size));
+	}
+}
+
+//Put key (as kept in the tree) with value into tree t of pool p, whose header is h (pool lock held).
+//returns POOL_OK or an error code.
+int pbtree_insert(pool* p, OID* t, pbtree_header* h, const char* key, const void* value)
+{
+	uint64_t path[PBTREE_MAX_HEIGHT];
+	int pos[PBTREE_MAX_HEIGHT];
+	int depth = pbtree_descend(h, key, path, pos);
+	if (depth >= 0)
+	{
+		pbtree_node* leaf = pbtree_at(h, path[depth]);
+		uint32_t i = pbtree_search(h, leaf, key, 1);
+		if (i < le32(leaf->n) && pbtree_cmp(h, pbtree_key_at(h, leaf, i), key) == 0) //replaces the value in place
+		{
+			if (value != NULL)
+			{
+				memcpy(pbtree_value_at(h, leaf, i), value, le32(h->value_size));
+			}
+			else
+			{
+				memset(pbtree_value_at(h, leaf, i), 0, le32(h->value_size));
+			}
+			nvm_write(p, le32(h->value_size));
+			return POOL_OK;
+		}
+		pos[depth] = (int) i;
+	}
+	if (depth + 1 >= PBTREE_MAX_HEIGHT)
+	{
+		return pool_log(POOL_EFULL, "B+-tree is %d levels high already!", PBTREE_MAX_HEIGHT);
+	}
+	h = pbtree_reserve(p, t, h, 2 * (uint64_t) (depth + 1) + 1); //a split at every level and a new root at most
+	if (h == NULL)
+	{
+		return POOL_EFULL;
+	}
+	size_t key_size = le32(h->key_size);
+	if (depth < 0) //the first key makes a root leaf
+	{
+		uint64_t r = pbtree_alloc(h, 1);
+		pbtree_node* x = pbtree_at(h, r);
+		pbtree_set_entry(h, x, 0, key, value);
+		x->n = le32(1);
+		nvm_write(p, PBTREE_NODE_SIZE);
+		__atomic_store_n(&h->root, le64(r), __ATOMIC_RELEASE);
+		h->count = le64(1);
+		return POOL_OK;
+	}
+
+	pbtree_node* leaf = pbtree_at(h, path[depth]);
+	uint32_t n = le32(leaf->n);
+	uint32_t i = (uint32_t) pos[depth];
+	uint64_t a;
+	uint64_t b = 0; //second node when the node at the current level splits
+	char sep[PBTREE_MAX_KEY]; //first key below b
+	if (n < pbtree_leaf_cap(h)) //the new leaf is the old one with the key added
+	{
+		a = pbtree_alloc(h, 1);
+		pbtree_node* x = pbtree_at(h, a);
+		pbtree_copy_entries(h, x, 0, leaf, 0, i);
+		pbtree_set_entry(h, x, i, key, value);
+		pbtree_copy_entries(h, x, i + 1, leaf, i, n - i);
+		x->n = le32(n + 1);
+	}
+	else //splits the n + 1 keys between two new leaves
+	{
+		a = pbtree_alloc(h, 1);
+		b = pbtree_alloc(h, 1);
+		pbtree_node* x = pbtree_at(h, a);
+		pbtree_node* y = pbtree_at(h, b);
+		uint32_t left = (n + 1) / 2;
+		if (i < left)
+		{
+			pbtree_copy_entries(h, x, 0, leaf, 0, i);
+			pbtree_set_entry(h, x, i, key, value);
+			pbtree_copy_entries(h, x, i + 1, leaf, i, left - i - 1);
+			pbtree_copy_entries(h, y, 0, leaf, left - 1, n - left + 1);
+		}
+		else
+		{
+			pbtree_copy_entries(h, x, 0, leaf, 0, left);
+			pbtree_copy_entries(h, y, 0, leaf, left, i - left);
+			pbtree_set_entry(h, y, i - left, key, value);
+			pbtree_copy_entries(h, y, i - left + 1, leaf, i, n - i);
+		}
+		x->n = le32(left);
+		y->n = le32(n + 1 - left);
+		memcpy(sep, pbtree_key_at(h, y, 0), key_size);
+	}
+	nvm_write(p, b == 0 ? PBTREE_NODE_SIZE : 2 * PBTREE_NODE_SIZE);
+
+	int top = depth;
+	while (b != 0 && top > 0) //the parent takes a in place of the old node and b after it, splitting if it is full
+	{
+		top--;
+		pbtree_node* parent = pbtree_at(h, path[top]);
+		uint32_t pn = le32(parent->n);
+		uint32_t at = (uint32_t) pos[top];
+		char keys[PBTREE_NODE_SIZE + PBTREE_MAX_KEY]; //the parent's keys and children with the new ones added
+		uint64_t children[PBTREE_NODE_SIZE / sizeof(uint64_t) + 2];
+		memcpy(keys, pbtree_key_at(h, parent, 0), at * key_size);
+		memcpy(keys + at * key_size, sep, key_size);
+		memcpy(keys + (at + 1) * key_size, pbtree_key_at(h, parent, at), (pn - at) * key_size);
+		uint64_t* old = pbtree_children(h, parent);
+		memcpy(children, old, at * sizeof(uint64_t));
+		children[at] = le64(a);
+		children[at + 1] = le64(b);
+		memcpy(children + at + 2, old + at + 1, (pn - at) * sizeof(uint64_t));
+		pn++;
+
+		if (pn <= pbtree_inner_cap(h))
+		{
+			a = pbtree_alloc(h, 0);
+			b = 0;
+			pbtree_node* x = pbtree_at(h, a);
+			memcpy(pbtree_key_at(h, x, 0), keys, pn * key_size);
+			memcpy(pbtree_children(h, x), children, (pn + 1) * sizeof(uint64_t));
+			x->n = le32(pn);
+			nvm_write(p, PBTREE_NODE_SIZE);
+		}
+		else //the middle key moves up between the two halves
+		{
+			uint32_t mid = pn / 2;
+			a = pbtree_alloc(h, 0);
+			b = pbtree_alloc(h, 0);
+			pbtree_node* x = pbtree_at(h, a);
+			pbtree_node* y = pbtree_at(h, b);
+			memcpy(pbtree_key_at(h, x, 0), keys, mid * key_size);
+			memcpy(pbtree_children(h, x), children, (mid + 1) * sizeof(uint64_t));
+			x->n = le32(mid);
+			memcpy(pbtree_key_at(h, y, 0), keys + (mid + 1) * key_size, (pn - mid - 1) * key_size);
+			memcpy(pbtree_children(h, y), children + mid + 1, (pn - mid) * sizeof(uint64_t));
+			y->n = le32(pn - mid - 1);
+			memcpy(sep, keys + mid * key_size, key_size);
+			nvm_write(p, 2 * PBTREE_NODE_SIZE);
+		}
+	}
+	if (b != 0) //the root split, so a new root goes above the two halves
+	{
+		uint64_t r = pbtree_alloc(h, 0);
+		pbtree_node* x = pbtree_at(h, r);
+		memcpy(pbtree_key_at(h, x, 0), sep, key_size);
+		pbtree_children(h, x)[0] = le64(a);
+		pbtree_children(h, x)[1] = le64(b);
+		x->n = le32(1);
+		nvm_write(p, PBTREE_NODE_SIZE);
+		a = r;
+	}
+	pbtree_publish(p, h, path, pos, top, depth, a);
+	h->count = le64(le64(h->count) + 1);
+	return POOL_OK;
+}
+
+//Set the key and value of iterator it from the entry it is at in tree h
+void pbtree_iter_entry(pbtree_header* h, pbtree_iter* it)
+{
+	pbtree_node* leaf = pbtree_at(h, it->path[it->depth]);
+	char* key = pbtree_key_at(h, leaf, (uint32_t) it->pos[it->depth]);
+	if (le32(h->key_type) == PBTREE_INT)
+	{
+		uint64_t word;
+		memcpy(&word, key, 8);
+		it->int_key = (int64_t) le64(word);
+		it->key = &it->int_key;
+	}
+	else
+	{
+		it->key = key;
+	}
+	it->value = pbtree_value_at(h, leaf, (uint32_t) it->pos[it->depth]);
+}
+
+//Move iterator it of tree h from the level below d down to the first (last if backward is 1) entry of the subtree
+//of child pos[d] of the node at level d
+void pbtree_iter_down(pbtree_header* h, pbtree_iter* it, int d, int backward)
+{
+	while (pbtree_at(h, it->path[d])->leaf != le32(1))
+	{
+		uint64_t child = le64(pbtree_children(h, pbtree_at(h, it->path[d]))[it->pos[d]]);
+		d++;
+		it->path[d] = child;
+		pbtree_node* x = pbtree_at(h, child);
+		it->pos[d] = backward == 1 ? (int) le32(x->n) - (x->leaf == le32(1) ? 1 : 0) : 0;
+	}
+	it->depth = d;
+	pbtree_iter_entry(h, it);
+}
+
+//Move iterator it of tree h to the next entry (the one before if backward is 1), returns POOL_OK or POOL_ENOENT
+//if it runs off the end of the tree
+int pbtree_iter_step(pbtree_header* h, pbtree_iter* it, int backward)
+{
+	int d = it->depth;
+	it->pos[d] = it->pos[d] + (backward == 1 ? -1 : 1);
+	while (d > 0 && (it->pos[d] < 0 || it->pos[d] >= (int) le32(pbtree_at(h, it->path[d])->n) + (d == it->depth ? 0 : 1)))
+	{
+		d--; //the node at level d is used up, so the step moves to the next child of its parent
+		it->pos[d] = it->pos[d] + (backward == 1 ? -1 : 1);
+	}
+	if (it->pos[d] < 0 || it->pos[d] >= (int) le32(pbtree_at(h, it->path[d])->n) + (d == it->depth ? 0 : 1))
+	{
+		it->key = NULL;
+		it->value = NULL;
+		return POOL_ENOENT;
+	}
+	if (d < it->depth)
+	{
+		pbtree_iter_down(h, it, d, backward);
+	}
+	else
+	{
+		pbtree_iter_entry(h, it);
+	}
+	return POOL_OK;
+}
+
+//Take key (as kept in the tree) out of tree t of pool p, whose header is h (pool lock held).
+//returns POOL_OK, POOL_ENOENT if the key is not in the tree or an error code. Leaves are not merged; a leaf left
+//empty is taken out of its parent, and a root left with one child gives its place to the child.
+int pbtree_delete(pool* p, OID* t, pbtree_header* h, const char* key)
+{
+	uint64_t path[PBTREE_MAX_HEIGHT];
+	int pos[PBTREE_MAX_HEIGHT];
+	int depth = pbtree_descend(h, key, path, pos);
+	if (depth < 0)
+	{
+		return POOL_ENOENT;
+	}
+	pbtree_node* leaf = pbtree_at(h, path[depth]);
+	uint32_t n = le32(leaf->n);
+	uint32_t i = pbtree_search(h, leaf, key, 1);
+	if (i >= n || pbtree_cmp(h, pbtree_key_at(h, leaf, i), key) != 0)
+	{
+		return POOL_ENOENT;
+	}
+	h = pbtree_reserve(p, t, h, 1);
+	if (h == NULL)
+	{
+		return POOL_EFULL;
+	}
+	leaf = pbtree_at(h, path[depth]);
+	size_t key_size = le32(h->key_size);
+
+	uint64_t r = 0; //node taking the place of the one at level top (0 to take it out)
+	int top = depth;
+	if (n > 1) //the new leaf is the old one without the key
+	{
+		r = pbtree_alloc(h, 1);
+		pbtree_node* x = pbtree_at(h, r);
+		pbtree_copy_entries(h, x, 0, leaf, 0, i);
+		pbtree_copy_entries(h, x, i, leaf, i + 1, n - i - 1);
+		x->n = le32(n - 1);
+		nvm_write(p, PBTREE_NODE_SIZE);
+	}
+	while (r == 0 && top > 0) //takes the empty node out of its parent
+	{
+		top--;
+		pbtree_node* parent = pbtree_at(h, path[top]);
+		uint32_t pn = le32(parent->n);
+		uint32_t at = (uint32_t) pos[top];
+		uint64_t* children = pbtree_children(h, parent);
+		if (pn == 0) //its only child is gone, so it goes too
+		{
+			continue;
+		}
+		else if (top == 0 && pn == 1) //a root with one child left is replaced by it
+		{
+			r = le64(children[1 - at]);
+			break;
+		}
+		r = pbtree_alloc(h, 0);
+		pbtree_node* x = pbtree_at(h, r);
+		uint32_t k = at > 0 ? at - 1 : 0; //key between the child and its neighbour
+		memcpy(pbtree_key_at(h, x, 0), pbtree_key_at(h, parent, 0), k * key_size);
+		memcpy(pbtree_key_at(h, x, k), pbtree_key_at(h, parent, k + 1), (pn - k - 1) * key_size);
+		uint64_t* new_children = pbtree_children(h, x);
+		memcpy(new_children, children, at * sizeof(uint64_t));
+		memcpy(new_children + at, children + at + 1, (pn - at) * sizeof(uint64_t));
+		x->n = le32(pn - 1);
+		nvm_write(p, PBTREE_NODE_SIZE);
+	}
+	pbtree_publish(p, h, path, pos, top, depth, r);
+	h->count = le64(le64(h->count) - 1);
+	return POOL_OK;
+}
+
+//returns the header of B+-tree t (pool lock held), or logs why t is not a B+-tree and returns NULL
+pbtree_header* pbtree_check(OID* t)
+{
+	if (t->empty == 1 || t->data_type != 4 || t->data_size < 2 * PBTREE_NODE_SIZE)
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a B+-tree!");
+		return NULL;
+	}
+	pbtree_header* h = t->data;
+	if (le32(h->magic) != PBTREE_MAGIC || le32(h->key_size) < 1 || le32(h->key_size) > PBTREE_MAX_KEY
+		|| le32(h->value_size) > PBTREE_MAX_VALUE || t->data_size < le64(h->nodes) * PBTREE_NODE_SIZE)
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a B+-tree!");
+		return NULL;
+	}
+	return h;
+}
+
+//Create a B+-tree of keys of key_type (PBTREE_INT, whose keys are int64_t and key_size 8, or PBTREE_STR, whose keys
+//are C strings shorter than key_size) and values of value_size bytes in the first empty OID of pool p and return its
+//OID (NULL on error)
+OID* pbtree_create(pool* p, int key_type, size_t key_size, size_t value_size)
+{
+	trace_call(TRACE_PBTREE_CREATE, p, NULL, (int64_t) ((uint64_t) key_type << 32 | (key_size & UINT32_MAX)), (int64_t) value_size, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+		return NULL;
+	}
+	else if ((key_type == PBTREE_INT && key_size != sizeof(int64_t)) || (key_type == PBTREE_STR && (key_size < 2 || key_size > PBTREE_MAX_KEY))
+		|| (key_type != PBTREE_INT && key_type != PBTREE_STR) || value_size > PBTREE_MAX_VALUE) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "B+-tree keys must be PBTREE_INT of 8 bytes or PBTREE_STR of 2 to %d bytes, and values at most %d bytes!",
+			PBTREE_MAX_KEY, PBTREE_MAX_VALUE);
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_PWRITE);
+	OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	if (tmp == NULL)
+	{
+		pool_log(POOL_EFULL, "Pool already full!");
+		pool_unlock(p);
+		return NULL;
+	}
+	size_t bytes = 2 * PBTREE_NODE_SIZE; //the header and room for a root leaf
+	pbtree_header* h = arena_blob_alloc(&p->arena, bytes);
+	if (h == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not make a B+-tree!");
+		pool_unlock(p);
+		return NULL;
+	}
+	memset(h, 0, bytes);
+	h->magic = le32(PBTREE_MAGIC);
+	h->key_type = le32((uint32_t) key_type);
+	h->key_size = le32((uint32_t) key_size);
+	h->value_size = le32((uint32_t) value_size);
+	h->nodes = le64(2);
+	h->used = le64(1);
+	tmp->data = h;
+	tmp->data_size = bytes;
+	tmp->data_type = 4;
+	tmp->empty = 0;
+	POOL_STAT(p, bytes_written, sizeof(pbtree_header));
+	oid_dirty(tmp);
+	nvm_write(p, sizeof(pbtree_header));
+	pool_unlock(p);
+	return tmp;
+}
+
+//returns the # of keys in B+-tree t (-1 if t is not a B+-tree)
+int64_t pbtree_count(OID* t)
+{
+	if (t == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	else if (t->pool->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return -1;
+	}
+	pool_lock(t->pool, LOCK_PREAD);
+	pbtree_header* h = pbtree_check(t);
+	int64_t count = h == NULL ? -1 : (int64_t) le64(h->count);
+	pool_unlock(t->pool);
+	return count;
+}
+
+//returns where the value of key is in B+-tree t (NULL if the key is not in the tree, leaving POOL_ENOENT in pool_errno),
+//valid until the next write to the tree
+void* pbtree_get(OID* t, const void* key)
+{
+	if (t == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PBTREE_GET, NULL, NULL, 0, 0, NULL);
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return NULL;
+	}
+	pool* p = t->pool;
+	pool_lock(p, LOCK_PREAD);
+	pbtree_header* h = p->closed == 1 ? NULL : pbtree_check(t);
+	char buf[PBTREE_MAX_KEY];
+	int error = h == NULL ? POOL_ETYPE : pbtree_key(h, key, buf);
+	trace_call(TRACE_PBTREE_GET, p, NULL, trace_offset(t), phash_trace_key(buf, error == POOL_OK ? le32(h->key_size) : 0), NULL);
+	void* value = NULL;
+	if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (error == POOL_OK)
+	{
+		uint64_t path[PBTREE_MAX_HEIGHT];
+		int pos[PBTREE_MAX_HEIGHT];
+		int depth = pbtree_descend(h, buf, path, pos);
+		pbtree_node* leaf = depth < 0 ? NULL : pbtree_at(h, path[depth]);
+		uint32_t i = leaf == NULL ? 0 : pbtree_search(h, leaf, buf, 1);
+		if (leaf != NULL && i < le32(leaf->n) && pbtree_cmp(h, pbtree_key_at(h, leaf, i), buf) == 0)
+		{
+			value = pbtree_value_at(h, leaf, i);
+		}
+		else
+		{
+			pool_errno = POOL_ENOENT;
+		}
+		nvm_read(p, depth + 1);
+	}
+	pool_unlock(p);
+	return value;
+}
+
+//Put key in B+-tree t with value (zeroed if NULL), replacing the value the key had. Returns POOL_OK or an error code.
+int pbtree_put(OID* t, const void* key, const void* value)
+{
+	if (t == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PBTREE_PUT, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = t->pool;
+	pool_lock(p, LOCK_PWRITE);
+	pbtree_header* h = p->closed == 1 ? NULL : pbtree_check(t);
+	char buf[PBTREE_MAX_KEY];
+	int error = h == NULL ? POOL_ETYPE : pbtree_key(h, key, buf);
+	trace_call(TRACE_PBTREE_PUT, p, NULL, trace_offset(t), phash_trace_key(buf, error == POOL_OK ? le32(h->key_size) : 0), NULL);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (error == POOL_OK)
+	{
+		uint32_t value_size = le32(h->value_size); //pbtree_insert may move the header when the tree grows
+		error = pbtree_insert(p, t, h, buf, value);
+		if (error == POOL_OK)
+		{
+			POOL_STAT(p, bytes_written, value_size);
+		}
+		oid_dirty(t);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Remove key from B+-tree t. Returns POOL_OK, POOL_ENOENT if the key is not in the tree or an error code.
+int pbtree_remove(OID* t, const void* key)
+{
+	if (t == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PBTREE_REMOVE, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = t->pool;
+	pool_lock(p, LOCK_PWRITE);
+	pbtree_header* h = p->closed == 1 ? NULL : pbtree_check(t);
+	char buf[PBTREE_MAX_KEY];
+	int error = h == NULL ? POOL_ETYPE : pbtree_key(h, key, buf);
+	trace_call(TRACE_PBTREE_REMOVE, p, NULL, trace_offset(t), phash_trace_key(buf, error == POOL_OK ? le32(h->key_size) : 0), NULL);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (error == POOL_OK)
+	{
+		error = pbtree_delete(p, t, h, buf);
+		if (error == POOL_ENOENT) //a key that is not there is not an error worth a message
+		{
+			pool_errno = POOL_ENOENT;
+		}
+		else if (error == POOL_OK)
+		{
+			oid_dirty(t);
+		}
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Fill the empty B+-tree t with n keys in ascending order and their values (values NULL zeroes them): keys is an array
+//of n int64_t for an int tree or of n strings of key_size bytes each for a string tree, values an array of n values.
+//Leaves are written left to right full and inner levels above them, so loading a sorted dataset (such as one read with
+//pfilein) takes O(n) instead of n inserts. Returns POOL_OK or an error code.
+int pbtree_load(OID* t, const void* keys, const void* values, int64_t n)
+{
+	if (t == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PBTREE_LOAD, NULL, NULL, 0, n, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = t->pool;
+	pool_lock(p, LOCK_PWRITE);
+	trace_call(TRACE_PBTREE_LOAD, p, NULL, trace_offset(t), n, NULL);
+	pbtree_header* h = p->closed == 1 ? NULL : pbtree_check(t);
+	if (p->closed == 1) //pool closed exception
+	{
+		pool_unlock(p);
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		pool_unlock(p);
+		return POOL_ETYPE;
+	}
+	else if (n < 0 || (n > 0 && keys == NULL) || h->root != 0)
+	{
+		pool_unlock(p);
+		return pool_log(POOL_EINVAL, "pbtree_load needs an empty tree and n >= 0 keys!");
+	}
+	else if (n == 0)
+	{
+		pool_unlock(p);
+		return POOL_OK;
+	}
+
+	size_t key_size = le32(h->key_size);
+	size_t value_size = le32(h->value_size);
+	char* sorted = malloc((size_t) n * key_size); //the keys as kept in the tree
+	if (sorted == NULL) //malloc exception
+	{
+		pool_unlock(p);
+		return pool_log(POOL_EFULL, "Could not sort %lld keys!", (long long) n);
+	}
+	int64_t i;
+	for (i = 0; i < n; i++)
+	{
+		if (pbtree_key(h, (const char*) keys + i * key_size, sorted + i * key_size) != POOL_OK
+			|| (i > 0 && pbtree_cmp(h, sorted + (i - 1) * key_size, sorted + i * key_size) >= 0))
+		{
+			free(sorted);
+			pool_unlock(p);
+			return pool_log(POOL_EINVAL, "pbtree_load needs keys in ascending order with no key twice (key %lld is not)!", (long long) i);
+		}
+	}
+
+	uint64_t leaf_cap = pbtree_leaf_cap(h);
+	uint64_t inner_cap = pbtree_inner_cap(h);
+	uint64_t count = (n + leaf_cap - 1) / leaf_cap; //# of nodes of the level being built
+	uint64_t need = count;
+	uint64_t c;
+	for (c = count; c > 1; c = (c + inner_cap) / (inner_cap + 1))
+	{
+		need = need + (c + inner_cap) / (inner_cap + 1);
+	}
+	uint64_t* level = malloc(count * sizeof(uint64_t)); //nodes of the level, and the first key below each of them
+	char* first = malloc(count * key_size);
+	if (level == NULL || first == NULL) //malloc exception
+	{
+		free(sorted);
+		free(level);
+		free(first);
+		pool_unlock(p);
+		return pool_log(POOL_EFULL, "Could not build %lld leaves!", (long long) count);
+	}
+	h = pbtree_reserve(p, t, h, need);
+	if (h == NULL)
+	{
+		free(sorted);
+		free(level);
+		free(first);
+		pool_unlock(p);
+		return POOL_EFULL;
+	}
+	uint64_t done = 0;
+	for (c = 0; c < count; c++) //n keys spread evenly over the leaves
+	{
+		uint64_t take = n / count + (c < n % count ? 1 : 0);
+		level[c] = pbtree_alloc(h, 1);
+		pbtree_node* x = pbtree_at(h, level[c]);
+		memcpy(pbtree_key_at(h, x, 0), sorted + done * key_size, take * key_size);
+		uint64_t j;
+		for (j = 0; j < take; j++)
+		{
+			if (values != NULL)
+			{
+				memcpy(pbtree_value_at(h, x, (uint32_t) j), (const char*) values + (done + j) * value_size, value_size);
+			}
+			else
+			{
+				memset(pbtree_value_at(h, x, (uint32_t) j), 0, value_size);
+			}
+		}
+		x->n = le32((uint32_t) take);
+		memcpy(first + c * key_size, sorted + done * key_size, key_size);
+		done = done + take;
+	}
+	nvm_write(p, count * PBTREE_NODE_SIZE);
+	while (count > 1) //children spread evenly over the nodes of the level above
+	{
+		uint64_t up = (count + inner_cap) / (inner_cap + 1);
+		done = 0;
+		for (c = 0; c < up; c++)
+		{
+			uint64_t take = count / up + (c < count % up ? 1 : 0);
+			uint64_t r = pbtree_alloc(h, 0);
+			pbtree_node* x = pbtree_at(h, r);
+			uint64_t j;
+			for (j = 0; j < take; j++)
+			{
+				pbtree_children(h, x)[j] = le64(level[done + j]);
+				if (j > 0)
+				{
+					memcpy(pbtree_key_at(h, x, (uint32_t) j - 1), first + (done + j) * key_size, key_size);
+				}
+			}
+			x->n = le32((uint32_t) take - 1);
+			memmove(first + c * key_size, first + done * key_size, key_size);
+			level[c] = r;
+			done = done + take;
+		}
+		nvm_write(p, up * PBTREE_NODE_SIZE);
+		count = up;
+	}
+	__atomic_store_n(&h->root, le64(level[0]), __ATOMIC_RELEASE); //the tree only becomes visible once it is whole
+	h->count = le64((uint64_t) n);
+	POOL_STAT(p, bytes_written, (uint64_t) n * (key_size + value_size));
+	oid_dirty(t);
+	free(level);
+	free(first);
+	free(sorted);
+	pool_unlock(p);
+	return POOL_OK;
+}
+
+//Point iterator it at the first key of B+-tree t at or above key, or at the last key at or below it if backward is 1
+//(the first or last key of the tree if key is NULL). Returns POOL_OK, POOL_ENOENT if there is no such key or an error code.
+int pbtree_iter_seek(OID* t, const void* key, pbtree_iter* it, int backward)
+{
+	if (t == NULL || it == NULL) //oid NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified oid or iterator is NULL!");
+	}
+	else if (t->pool->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	pool* p = t->pool;
+	pool_lock(p, LOCK_PREAD);
+	it->tree = t;
+	it->key = NULL;
+	it->value = NULL;
+	pbtree_header* h = pbtree_check(t);
+	char buf[PBTREE_MAX_KEY];
+	int error = h == NULL ? POOL_ETYPE : key == NULL ? POOL_OK : pbtree_key(h, key, buf);
+	if (error == POOL_OK && h->root == 0)
+	{
+		error = POOL_ENOENT;
+	}
+	else if (error == POOL_OK && key == NULL) //runs down the first or last child of every level
+	{
+		it->path[0] = le64(h->root);
+		pbtree_node* root = pbtree_at(h, it->path[0]);
+		it->pos[0] = backward == 1 ? (int) le32(root->n) - (root->leaf == le32(1) ? 1 : 0) : 0;
+		pbtree_iter_down(h, it, 0, backward);
+	}
+	else if (error == POOL_OK)
+	{
+		it->depth = pbtree_descend(h, buf, it->path, it->pos);
+		pbtree_node* leaf = pbtree_at(h, it->path[it->depth]);
+		int i = (int) pbtree_search(h, leaf, buf, backward == 1 ? 0 : 1);
+		if (backward == 1 && i == 0) //every key of the leaf is above key, so it is the last key of the leaves before
+		{
+			it->pos[it->depth] = 0;
+			error = pbtree_iter_step(h, it, 1);
+		}
+		else if (backward == 0 && i == (int) le32(leaf->n)) //every key of the leaf is below key
+		{
+			it->pos[it->depth] = i - 1;
+			error = pbtree_iter_step(h, it, 0);
+		}
+		else
+		{
+			it->pos[it->depth] = backward == 1 ? i - 1 : i;
+			pbtree_iter_entry(h, it);
+		}
+		nvm_read(p, it->depth + 1);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Move iterator it to the next key of its tree (the key before if backward is 1).
+//Returns POOL_OK, POOL_ENOENT once it runs off the end or an error code.
+int pbtree_iter_move(pbtree_iter* it, int backward)
+{
+	if (it == NULL || it->tree == NULL) //iterator NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified iterator is NULL!");
+	}
+	else if (it->tree->pool->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (it->key == NULL) //already off the end
+	{
+		return POOL_ENOENT;
+	}
+	pool* p = it->tree->pool;
+	pool_lock(p, LOCK_PREAD);
+	pbtree_header* h = pbtree_check(it->tree);
+	int error = h == NULL ? POOL_ETYPE : pbtree_iter_step(h, it, backward);
+	nvm_read(p, 1);
+	pool_unlock(p);
+	return error;
+}
+
+//Point iterator it at the first key of B+-tree t at or above key (the first key of the tree if key is NULL).
+//Returns POOL_OK, POOL_ENOENT if there is no such key (it->key is NULL then) or an error code.
+int pbtree_seek(OID* t, const void* key, pbtree_iter* it)
+{
+	return pbtree_iter_seek(t, key, it, 0);
+}
+
+//Point iterator it at the last key of B+-tree t at or below key (the last key of the tree if key is NULL).
+//Returns POOL_OK, POOL_ENOENT if there is no such key (it->key is NULL then) or an error code.
+int pbtree_seek_last(OID* t, const void* key, pbtree_iter* it)
+{
+	return pbtree_iter_seek(t, key, it, 1);
+}
+
+//Move iterator it to the next key of its tree. Returns POOL_OK, POOL_ENOENT past the last key or an error code.
+int pbtree_next(pbtree_iter* it)
+{
+	return pbtree_iter_move(it, 0);
+}
+
+//Move iterator it to the key before in its tree. Returns POOL_OK, POOL_ENOENT before the first key or an error code.
+int pbtree_prev(pbtree_iter* it)
+{
+	return pbtree_iter_move(it, 1);
+}
+
+
+//QUEUES
+
+//A queue is a bounded FIFO ring of fixed-size elements kept in one blob object of a pool: a pqueue_header, then
+//capacity slots. Like a vector it is handed around as its OID, so a queue made first in an empty pool is the pool's
+//root object. Pushes and pops take no lock: a PQUEUE_SPSC queue has one producer thread and one consumer thread, each
+//the only writer of its end, and a PQUEUE_MPMC queue claims runs of positions with a compare-and-swap of the tail or
+//the head and hands each slot over with its sequence # (as in Vyukov's bounded MPMC queue). Either way an element is
+//written before the tail or its sequence # lets it be popped, and copied out before the head or its sequence # lets
+//the slot be written again, so a queue written out by pool_close or pfileout holds every element whose push returned
+//and none whose pop returned. The blob never moves, so queue calls only need the OID to stay valid: they must not
+//overlap pfree of the queue or pool_close, pool_reset or pool_destroy of its pool. On an out-of-core pool, whose pages
+//any call can replace, they take the pool lock.
+
+//returns the header of queue q, or logs why q is not a queue and returns NULL
+pqueue_header* pqueue_check(OID* q)
+{
+	if (q->empty == 1 || q->data_type != 4 || q->data_size < sizeof(pqueue_header))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a queue!");
+		return NULL;
+	}
+	pqueue_header* h = q->data;
+	uint64_t cap = le64(h->capacity);
+	uint32_t kind = le32(h->kind);
+	uint32_t elem_size = le32(h->elem_size);
+	if (le32(h->magic) != PQUEUE_MAGIC || (kind != PQUEUE_SPSC && kind != PQUEUE_MPMC) || elem_size == 0
+		|| le32(h->slot_size) != (kind == PQUEUE_SPSC ? elem_size : sizeof(uint64_t) + PHASH_PAD(elem_size))
+		|| cap == 0 || cap > PQUEUE_MAX_CAP || (cap & (cap - 1)) != 0 || cap > blob_max_count(sizeof(pqueue_header), le32(h->slot_size))
+		|| q->data_size < sizeof(pqueue_header) + cap * le32(h->slot_size))
+	{
+		pool_log(POOL_ETYPE, "The specified oid is not a queue!");
+		return NULL;
+	}
+	return h;
+}
+
+//returns position at as stored, for a position another thread writes
+uint64_t pqueue_load(uint64_t* at)
+{
+	return le64(__atomic_load_n(at, __ATOMIC_ACQUIRE));
+}
+
+//Store position v at, after every write before it
+void pqueue_store(uint64_t* at, uint64_t v)
+{
+	__atomic_store_n(at, le64(v), __ATOMIC_RELEASE);
+}
+
+//returns the sequence # of the slot of position pos in PQUEUE_MPMC queue h (the element follows it)
+uint64_t* pqueue_seq(pqueue_header* h, uint64_t pos)
+{
+	return (uint64_t*) ((char*) (h + 1) + (pos & (le64(h->capacity) - 1)) * le32(h->slot_size));
+}
+
+//Get queue q ready for a push or pop: takes the pool lock of an out-of-core pool and points h at the header.
+//Returns POOL_OK or an error code (having let go of the lock again).
+int pqueue_enter(OID* q, pqueue_header** h)
+{
+	pool* p = q->pool;
+	if (p->buffer != NULL)
+	{
+		pool_lock(p, LOCK_PWRITE);
+	}
+	*h = p->closed == 1 ? NULL : pqueue_check(q);
+	int error = POOL_OK;
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (*h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	if (error != POOL_OK && p->buffer != NULL)
+	{
+		pool_unlock(p);
+	}
+	return error;
+}
+
+//Finish a push or pop on queue q begun with pqueue_enter
+void pqueue_leave(OID* q)
+{
+	if (q->pool->buffer != NULL)
+	{
+		oid_dirty(q);
+		pool_unlock(q->pool);
+	}
+}
+
+//Create a queue of kind (PQUEUE_SPSC or PQUEUE_MPMC) of elements of elem_size bytes with room for cap elements
+//(rounded up to a power of 2) in the first empty OID of pool p and return its OID (NULL on error)
+OID* pqueue_create(pool* p, int kind, size_t elem_size, int64_t cap)
+{
+	trace_call(TRACE_PQUEUE_CREATE, p, NULL, (int64_t) ((uint64_t) kind << 32 | (elem_size & UINT32_MAX)), cap, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+		return NULL;
+	}
+	else if ((kind != PQUEUE_SPSC && kind != PQUEUE_MPMC) || elem_size < 1 || elem_size > UINT32_MAX - 16
+		|| cap < 1 || (uint64_t) cap > PQUEUE_MAX_CAP) //invalid size exception
+	{
+		pool_log(POOL_EINVAL, "Queues must be PQUEUE_SPSC or PQUEUE_MPMC of 1 to 2^32-17 byte elements and room for 1 to 2^40 of them!");
+		return NULL;
+	}
+
+	uint64_t slots = 1;
+	while (slots < (uint64_t) cap) //positions map to slots with a mask
+	{
+		slots = slots * 2;
+	}
+	size_t slot_size = kind == PQUEUE_SPSC ? elem_size : sizeof(uint64_t) + PHASH_PAD(elem_size);
+	if (slots > blob_max_count(sizeof(pqueue_header), slot_size)) //queue size overflow exception
+	{
+		pool_log(POOL_EINVAL, "A queue of %llu-byte slots cannot hold %llu elements!", (unsigned long long) slot_size, (unsigned long long) slots);
+		return NULL;
+	}
+	size_t bytes = sizeof(pqueue_header) + slots * slot_size;
+	pool_lock(p, LOCK_PWRITE);
+	OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	if (tmp == NULL)
+	{
+		pool_log(POOL_EFULL, "Pool already full!");
+		pool_unlock(p);
+		return NULL;
+	}
+	pqueue_header* h = arena_blob_alloc(&p->arena, bytes);
+	if (h == NULL)
+	{
+		pool_log(POOL_EFULL, "Could not make a queue of %llu elements!", (unsigned long long) slots);
+		pool_unlock(p);
+		return NULL;
+	}
+	memset(h, 0, bytes);
+	h->magic = le32(PQUEUE_MAGIC);
+	h->kind = le32((uint32_t) kind);
+	h->elem_size = le32((uint32_t) elem_size);
+	h->slot_size = le32((uint32_t) slot_size);
+	h->capacity = le64(slots);
+	uint64_t i;
+	for (i = 0; i < slots && kind == PQUEUE_MPMC; i++) //slot i is free for position i
+	{
+		*pqueue_seq(h, i) = le64(i);
+	}
+	tmp->data = h;
+	tmp->data_size = bytes;
+	tmp->data_type = 4;
+	tmp->empty = 0;
+	POOL_STAT(p, bytes_written, sizeof(pqueue_header));
+	oid_dirty(tmp);
+	nvm_write(p, kind == PQUEUE_SPSC ? sizeof(pqueue_header) : bytes);
+	pool_unlock(p);
+	return tmp;
+}
+
+//returns the # of elements in queue q (-1 if q is not a queue), which pushes and pops running at the same time change
+int64_t pqueue_count(OID* q)
+{
+	if (q == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	pqueue_header* h;
+	if (pqueue_enter(q, &h) != POOL_OK)
+	{
+		return -1;
+	}
+	uint64_t head = pqueue_load(&h->head);
+	uint64_t tail = pqueue_load(&h->tail);
+	uint64_t cap = le64(h->capacity);
+	pqueue_leave(q);
+	return tail < head ? 0 : (int64_t) (tail - head < cap ? tail - head : cap);
+}
+
+//returns the # of elements queue q has room for (-1 if q is not a queue)
+int64_t pqueue_capacity(OID* q)
+{
+	if (q == NULL) //oid NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	pqueue_header* h;
+	if (pqueue_enter(q, &h) != POOL_OK)
+	{
+		return -1;
+	}
+	int64_t cap = (int64_t) le64(h->capacity);
+	pqueue_leave(q);
+	return cap;
+}
+
+//Push up to n elements from elems onto the tail of queue q without waiting. Returns the # pushed, which are popped
+//in order next to each other (0 if the queue is full, leaving POOL_EFULL in pool_errno), or -1 on error.
+int64_t pqueue_push_n(OID* q, const void* elems, int64_t n)
+{
+	if (q == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PQUEUE_PUSH, NULL, NULL, 0, n, NULL);
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	pool* p = q->pool;
+	trace_call(TRACE_PQUEUE_PUSH, p, NULL, trace_offset(q), n, NULL);
+	pqueue_header* h;
+	if (pqueue_enter(q, &h) != POOL_OK)
+	{
+		return -1;
+	}
+	else if (n < 0 || (n > 0 && elems == NULL))
+	{
+		pool_log(POOL_EINVAL, "pqueue_push_n needs n >= 0 elements!");
+		pqueue_leave(q);
+		return -1;
+	}
+
+	uint64_t cap = le64(h->capacity);
+	size_t elem_size = le32(h->elem_size);
+	char* slots = (char*) (h + 1);
+	uint64_t want = (uint64_t) n < cap ? (uint64_t) n : cap;
+	uint64_t k = 0;
+	if (le32(h->kind) == PQUEUE_SPSC)
+	{
+		uint64_t tail = le64(h->tail); //only this thread writes it
+		uint64_t head = pqueue_load(&h->head);
+		k = cap - (tail - head) < want ? cap - (tail - head) : want;
+		uint64_t first = tail & (cap - 1);
+		uint64_t part = cap - first < k ? cap - first : k; //the rest wraps around to slot 0
+		memcpy(slots + first * elem_size, elems, part * elem_size);
+		memcpy(slots, (const char*) elems + part * elem_size, (k - part) * elem_size);
+		nvm_write(p, k * elem_size + sizeof(uint64_t));
+		pqueue_store(&h->tail, tail + k); //the elements are written before they count
+	}
+	else
+	{
+		uint64_t pos = le64(__atomic_load_n(&h->tail, __ATOMIC_RELAXED));
+		while (want > 0)
+		{
+			k = 0;
+			while (k < want && pqueue_load(pqueue_seq(h, pos + k)) == pos + k) //free slots stay free until their position is claimed
+			{
+				k++;
+			}
+			uint64_t seen = le64(pos);
+			if (k > 0 && __atomic_compare_exchange_n(&h->tail, &seen, le64(pos + k), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+			else if (k == 0 && (int64_t) (pqueue_load(pqueue_seq(h, pos)) - pos) < 0) //the slot still holds the element from a lap before
+			{
+				break;
+			}
+			pos = le64(__atomic_load_n(&h->tail, __ATOMIC_RELAXED)); //another producer got there first
+		}
+		uint64_t i;
+		for (i = 0; i < k; i++)
+		{
+			uint64_t* seq = pqueue_seq(h, pos + i);
+			memcpy(seq + 1, (const char*) elems + i * elem_size, elem_size);
+			pqueue_store(seq, pos + i + 1); //the element is written before it can be popped
+		}
+		nvm_write(p, k * le32(h->slot_size) + sizeof(uint64_t));
+	}
+	if (k == 0 && n > 0)
+	{
+		pool_errno = POOL_EFULL;
+	}
+	POOL_STAT(p, bytes_written, k * elem_size);
+	pqueue_leave(q);
+	return (int64_t) k;
+}
+
+//Pop up to n elements from the head of queue q into elems without waiting. Returns the # popped (0 if the queue is
+//empty, leaving POOL_ENOENT in pool_errno) or -1 on error.
+int64_t pqueue_pop_n(OID* q, void* elems, int64_t n)
+{
+	if (q == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PQUEUE_POP, NULL, NULL, 0, n, NULL);
+		pool_log(POOL_ENULL, "The specified oid is NULL!");
+		return -1;
+	}
+	pool* p = q->pool;
+	trace_call(TRACE_PQUEUE_POP, p, NULL, trace_offset(q), n, NULL);
+	pqueue_header* h;
+	if (pqueue_enter(q, &h) != POOL_OK)
+	{
+		return -1;
+	}
+	else if (n < 0 || (n > 0 && elems == NULL))
+	{
+		pool_log(POOL_EINVAL, "pqueue_pop_n needs room for n >= 0 elements!");
+		pqueue_leave(q);
+		return -1;
+	}
+
+	uint64_t cap = le64(h->capacity);
+	size_t elem_size = le32(h->elem_size);
+	char* slots = (char*) (h + 1);
+	uint64_t want = (uint64_t) n < cap ? (uint64_t) n : cap;
+	uint64_t k = 0;
+	if (le32(h->kind) == PQUEUE_SPSC)
+	{
+		uint64_t head = le64(h->head); //only this thread writes it
+		uint64_t tail = pqueue_load(&h->tail);
+		k = tail - head < want ? tail - head : want;
+		uint64_t first = head & (cap - 1);
+		uint64_t part = cap - first < k ? cap - first : k;
+		memcpy(elems, slots + first * elem_size, part * elem_size);
+		memcpy((char*) elems + part * elem_size, slots, (k - part) * elem_size);
+		nvm_write(p, sizeof(uint64_t));
+		pqueue_store(&h->head, head + k); //the elements are copied out before their slots can be written again
+	}
+	else
+	{
+		uint64_t pos = le64(__atomic_load_n(&h->head, __ATOMIC_RELAXED));
+		while (want > 0)
+		{
+			k = 0;
+			while (k < want && pqueue_load(pqueue_seq(h, pos + k)) == pos + k + 1) //pushed slots stay full until their position is claimed
+			{
+				k++;
+			}
+			uint64_t seen = le64(pos);
+			if (k > 0 && __atomic_compare_exchange_n(&h->head, &seen, le64(pos + k), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+			else if (k == 0 && (int64_t) (pqueue_load(pqueue_seq(h, pos)) - (pos + 1)) < 0) //the slot has not been pushed yet
+			{
+				break;
+			}
+			pos = le64(__atomic_load_n(&h->head, __ATOMIC_RELAXED)); //another consumer got there first
+		}
+		uint64_t i;
+		for (i = 0; i < k; i++)
+		{
+			uint64_t* seq = pqueue_seq(h, pos + i);
+			memcpy((char*) elems + i * elem_size, seq + 1, elem_size);
+			pqueue_store(seq, pos + i + cap); //the element is copied out before the slot can be pushed to again
+		}
+		nvm_write(p, (k + 1) * sizeof(uint64_t));
+	}
+	if (k == 0 && n > 0)
+	{
+		pool_errno = POOL_ENOENT;
+	}
+	nvm_read(p, (int64_t) k);
+	pqueue_leave(q);
+	return (int64_t) k;
+}
+
+//Push one element onto the tail of queue q. Returns POOL_OK, POOL_EFULL if the queue is full or an error code.
+int pqueue_push(OID* q, const void* elem)
+{
+	trace_quiet++; //recorded as a whole by pqueue_push_n
+	int64_t k = pqueue_push_n(q, elem, 1);
+	trace_quiet--;
+	return k == 1 ? POOL_OK : pool_errno;
+}
+
+//Pop the element at the head of queue q into elem. Returns POOL_OK, POOL_ENOENT if the queue is empty or an error code.
+int pqueue_pop(OID* q, void* elem)
+{
+	trace_quiet++; //recorded as a whole by pqueue_pop_n
+	int64_t k = pqueue_pop_n(q, elem, 1);
+	trace_quiet--;
+	return k == 1 ? POOL_OK : pool_errno;
+}
+
+//Make queue q whole again after a restart, before any push or pop on it: after pool_open of a hibernated pool or
+//pfilein or pool_create_map of a file from pfileout, with pushes and pops that were still running when the pool was
+//written out. Positions of a PQUEUE_MPMC queue a push claimed but never filled are dropped, and elements a pop claimed
+//but never finished copying out go back to the head, so every element whose push returned is popped once and none whose
+//pop returned comes back. A PQUEUE_SPSC queue is only checked, as its head and tail never cover a slot half written.
+//Returns POOL_OK or an error code.
+int pqueue_recover(OID* q)
+{
+	if (q == NULL) //oid NULL exception
+	{
+		trace_call(TRACE_PQUEUE_RECOVER, NULL, NULL, 0, 0, NULL);
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	pool* p = q->pool;
+	pool_lock(p, LOCK_PWRITE);
+	trace_call(TRACE_PQUEUE_RECOVER, p, NULL, trace_offset(q), 0, NULL);
+	int error = POOL_OK;
+	pqueue_header* h = p->closed == 1 ? NULL : pqueue_check(q);
+	uint64_t head = h == NULL ? 0 : le64(h->head);
+	uint64_t tail = h == NULL ? 0 : le64(h->tail);
+	uint64_t cap = h == NULL ? 0 : le64(h->capacity);
+	if (p->closed == 1) //pool closed exception
+	{
+		error = pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (h == NULL)
+	{
+		error = POOL_ETYPE;
+	}
+	else if (tail < head || tail - head > cap) //damaged queue exception
+	{
+		error = pool_log(POOL_EBADF, "Queue at offset %lld of pool %s has its head %llu and tail %llu too far apart!", (long long) index_offset(q),
+			p->name, (unsigned long long) head, (unsigned long long) tail);
+	}
+	else if (le32(h->kind) == PQUEUE_MPMC)
+	{
+		size_t elem_size = le32(h->elem_size);
+		uint64_t start = tail > cap ? tail - cap : 0; //slots before the head are only reused from start + capacity on
+		uint64_t redone = 0;
+		uint64_t dropped = 0;
+		uint64_t pos;
+		for (pos = start; pos < tail; pos++)
+		{
+			int full = le64(*pqueue_seq(h, pos)) == pos + 1;
+			redone = redone + (pos < head && full == 1);
+			dropped = dropped + (pos >= head && full == 0);
+		}
+		char* keep = redone + dropped > 0 ? malloc((tail - start) * elem_size + 1) : NULL;
+		if (redone + dropped > 0 && keep == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Could not recover queue at offset %lld of pool %s!", (long long) index_offset(q), p->name);
+		}
+		else if (redone + dropped > 0) //the elements left are put back in order from the new head
+		{
+			uint64_t k = 0;
+			for (pos = start; pos < tail; pos++)
+			{
+				uint64_t* seq = pqueue_seq(h, pos);
+				if (le64(*seq) == pos + 1)
+				{
+					memcpy(keep + k * elem_size, seq + 1, elem_size);
+					k++;
+				}
+			}
+			head = head - redone;
+			for (pos = head; pos < head + cap; pos++)
+			{
+				uint64_t* seq = pqueue_seq(h, pos);
+				if (pos < head + k)
+				{
+					memcpy(seq + 1, keep + (pos - head) * elem_size, elem_size);
+				}
+				*seq = le64(pos < head + k ? pos + 1 : pos);
+			}
+			h->head = le64(head);
+			h->tail = le64(head + k);
+			free(keep);
+			oid_dirty(q);
+			nvm_write(p, cap * le32(h->slot_size));
+			pool_log(POOL_OK, "Queue at offset %lld of pool %s recovered: %llu pops redone, %llu pushes dropped.", (long long) index_offset(q),
+				p->name, (unsigned long long) redone, (unsigned long long) dropped);
+		}
+	}
+	pool_unlock(p);
+	return error;
+}
+
+
+//ROOT DIRECTORY
+
+//The directory of a pool is a hash map in its root object from names (C strings of up to PDIR_NAME_SIZE - 1 chars,
+//zero-padded) to a pdir_entry: the object's offset, its kind and its size when it was named. Objects are made in the
+//first empty OID, so pool_dir_create makes the directory in a new pool before anything else takes the root.
+//pool_dir_get then finds a named object in one hash lookup after pool_open, pfilein or pool_create_map, instead of a
+//walk from the root. Frees and pmalloc_range move the objects after them, so they move the offsets in the directory
+//with them, and forget the names of objects they free.
+
+//returns the PDIR_ kind of object o (0 if it is empty)
+int pdir_kind(const OID* o)
+{
+	if (o->empty == 1)
+	{
+		return 0;
+	}
+	else if (o->data_type != 4 || o->data_size < sizeof(pvec_header)) //smaller than the header of any structure
+	{
+		return o->data_type;
+	}
+	uint32_t magic;
+	memcpy(&magic, o->data, sizeof(magic));
+	magic = le32(magic);
+	return magic == PVEC_MAGIC ? PDIR_VECTOR : magic == PHASH_MAGIC ? PDIR_HASH : magic == PBTREE_MAGIC ? PDIR_BTREE
+		: magic == PQUEUE_MAGIC ? PDIR_QUEUE : PDIR_BLOB;
+}
+
+//returns the directory at the root of pool p (pool lock held), or NULL if the root is empty or something else
+OID* pdir_root(pool* p)
+{
+	if (p->size < 1 || p->text != NULL || (p->buffer == NULL && index_entry(p, 0) == NULL)) //an OID not in memory yet is empty
+	{
+		return NULL;
+	}
+	OID* d = oid_at(p, 0);
+	phash_header* h = d == NULL || d->empty == 1 || d->data_type != 4 || d->data_size < sizeof(phash_header) ? NULL : d->data;
+	if (h == NULL || le32(h->magic) != PHASH_MAGIC || le32(h->kind) != PDIR_MAGIC || le32(h->key_size) != PDIR_NAME_SIZE
+		|| le32(h->value_size) != sizeof(pdir_entry))
+	{
+		return NULL;
+	}
+	return d;
+}
+
+//returns the directory of pool p (pool lock held), making it in the root first if create is 1 and the root is empty.
+//Returns NULL if there is none, quietly leaving POOL_ENOENT for an empty root or logging what the root holds instead.
+OID* pdir_open(pool* p, int create)
+{
+	OID* d = pdir_root(p);
+	OID* root = d != NULL || p->size < 1 ? d : oid_at(p, 0);
+	if (d != NULL)
+	{
+		return d;
+	}
+	else if (root != NULL && root->empty == 0) //root taken exception
+	{
+		pool_log(POOL_ETYPE, "The root of pool %s is not a directory!", p->name);
+		return NULL;
+	}
+	else if (create == 0)
+	{
+		pool_errno = POOL_ENOENT;
+		return NULL;
+	}
+	trace_quiet++; //recorded as a whole by pool_dir_create
+	d = root == NULL ? NULL : phash_create(p, PDIR_NAME_SIZE, sizeof(pdir_entry), 0); //the first empty OID is the root
+	trace_quiet--;
+	if (d != NULL)
+	{
+		((phash_header*) d->data)->kind = le32(PDIR_MAGIC);
+	}
+	else if (root == NULL)
+	{
+		pool_log(POOL_EFULL, "Pool %s has no root to make a directory in!", p->name);
+	}
+	return d;
+}
+
+//Copy name into key, zero-padded to a key of the directory; returns POOL_OK or logs why it is not a name
+int pdir_key(const char* name, char* key)
+{
+	if (name == NULL || name[0] == '\0' || strlen(name) >= PDIR_NAME_SIZE) //invalid name exception
+	{
+		return pool_log(POOL_EINVAL, "Names in a directory must be 1 to %d chars!", PDIR_NAME_SIZE - 1);
+	}
+	memset(key, 0, PDIR_NAME_SIZE);
+	memcpy(key, name, strlen(name));
+	return POOL_OK;
+}
+
+//Keep the directory of pool p pointing at its objects after count objects were made at offset (count > 0) or -count
+//objects were freed from it (pool lock held): names of freed objects are removed and the objects after them move.
+void pdir_moved(pool* p, int64_t offset, int64_t count)
+{
+	OID* d = offset == 0 && count < 0 ? NULL : pdir_root(p); //freeing the root frees the directory
+	if (d == NULL)
+	{
+		return;
+	}
+	phash_move* mv = phash_moving(p, d);
+	if (mv != NULL) //every name is in the new table once the move is done
+	{
+		phash_step(p, mv, UINT64_MAX);
+	}
+	phash_header* h = d->data;
+	unsigned char* ctrl = (unsigned char*) (h + 1);
+	uint64_t cap = le64(h->capacity);
+	uint64_t i;
+	for (i = 0; i < cap; i++)
+	{
+		if ((ctrl[i] & 0x80) != 0) //empty or deleted
+		{
+			continue;
+		}
+		pdir_entry* e = (pdir_entry*) (phash_slot(h, i) + PDIR_NAME_SIZE);
+		int64_t at = (int64_t) le64(e->offset);
+		if (count < 0 && at >= offset && at < offset - count)
+		{
+			phash_erase(p, h, i);
+			h->count = le64(le64(h->count) - 1);
+		}
+		else if (at >= offset)
+		{
+			e->offset = le64((uint64_t) (at + count));
+		}
+	}
+	oid_dirty(d);
+	nvm_write(p, sizeof(int64_t));
+}
+
+//Make the empty root object of pool p its directory and return it (NULL on error); a directory already there is
+//returned as it is
+OID* pool_dir_create(pool* p)
+{
+	trace_call(TRACE_POOL_DIR_CREATE, p, NULL, 0, 0, NULL);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+		return NULL;
+	}
+	pool_lock(p, LOCK_PWRITE);
+	OID* d = pdir_open(p, 1);
+	pool_unlock(p);
+	return d;
+}
+
+//Name object oid of pool p in the pool's directory (see pool_dir_create), replacing what the name was given to before.
+//Returns POOL_OK or an error code.
+int pool_dir_set(pool* p, const char* name, OID* oid)
+{
+	trace_call(TRACE_POOL_DIR_SET, p, NULL, oid == NULL ? -1 : trace_offset(oid), 0, name);
+	char key[PDIR_NAME_SIZE];
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only holds chars!", p->name);
+	}
+	else if (oid == NULL) //oid NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified oid is NULL!");
+	}
+	else if (oid->pool != p) //other pool exception
+	{
+		return pool_log(POOL_EINVAL, "The specified oid is not in pool %s!", p->name);
+	}
+	else if (pdir_key(name, key) != POOL_OK)
+	{
+		return POOL_EINVAL;
+	}
+
+	pool_lock(p, LOCK_PWRITE);
+	int error = POOL_OK;
+	OID* d = pdir_open(p, 0);
+	if (d == NULL && pool_errno == POOL_ENOENT) //no directory exception
+	{
+		error = pool_log(POOL_ENOENT, "Pool %s has no directory to name objects in!", p->name);
+	}
+	else if (d == NULL)
+	{
+		error = pool_errno;
+	}
+	else if (oid->empty == 1 || oid == d) //unnameable oid exception
+	{
+		error = pool_log(POOL_EINVAL, "Only objects with data other than the directory can be named!");
+	}
+	else
+	{
+		pdir_entry e;
+		memset(&e, 0, sizeof(e));
+		e.offset = le64((uint64_t) index_offset(oid));
+		e.kind = le32((uint32_t) pdir_kind(oid));
+		e.size = le64(oid->data_size);
+		trace_quiet++;
+		error = phash_put(d, key, &e);
+		trace_quiet--;
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//returns the entry of name in the directory of pool p (pool lock held), or NULL after leaving why in pool_errno
+const pdir_entry* pdir_find(pool* p, const char* name)
+{
+	char key[PDIR_NAME_SIZE];
+	OID* d = pdir_key(name, key) == POOL_OK ? pdir_open(p, 0) : NULL;
+	trace_quiet++;
+	const pdir_entry* e = d == NULL ? NULL : phash_get(d, key); //leaves POOL_ENOENT for a name not given
+	trace_quiet--;
+	return e;
+}
+
+//returns the object of pool p given name in the pool's directory (NULL on error). If kind is not PDIR_ANY the object
+//must be of that kind (POOL_ETYPE otherwise). A name not given, or a pool with no directory, quietly leaves POOL_ENOENT.
+OID* pool_dir_get(pool* p, const char* name, int kind)
+{
+	trace_call(TRACE_POOL_DIR_GET, p, NULL, kind, 0, name);
+	if (p == NULL) //pool NULL exception
+	{
+		pool_log(POOL_ENULL, "The specified pool is NULL!");
+		return NULL;
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		pool_log(POOL_ECLOSED, "The specified pool is closed!");
+		return NULL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_errno = POOL_ENOENT;
+		return NULL;
+	}
+
+	pool_lock(p, LOCK_GETOID);
+	const pdir_entry* e = pdir_find(p, name);
+	int64_t offset = e == NULL ? -1 : (int64_t) le64(e->offset);
+	OID* tmp = offset >= 0 && offset < p->size ? oid_at(p, offset) : NULL;
+	if (e != NULL && (tmp == NULL || pdir_kind(tmp) != (int) le32(e->kind))) //changed object exception
+	{
+		pool_log(POOL_ETYPE, "The object named %s in pool %s is no longer of the kind it was named as!", name, p->name);
+		tmp = NULL;
+	}
+	else if (tmp != NULL && kind != PDIR_ANY && kind != (int) le32(e->kind)) //wrong kind exception
+	{
+		pool_log(POOL_ETYPE, "The object named %s in pool %s is not of kind %d!", name, p->name, kind);
+		tmp = NULL;
+	}
+	if (tmp != NULL)
+	{
+		oid_lookup(p, offset);
+	}
+	pool_unlock(p);
+	return tmp;
+}
+
+//Copy the entry of name in the directory of pool p into entry (in host order). Returns POOL_OK, POOL_ENOENT if the
+//name was not given or the pool has no directory, or an error code.
+int pool_dir_stat(pool* p, const char* name, pdir_entry* entry)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (entry == NULL) //entry NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified entry is NULL!");
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_errno = POOL_ENOENT;
+		return POOL_ENOENT;
+	}
+
+	pool_lock(p, LOCK_PREAD);
+	const pdir_entry* e = pdir_find(p, name);
+	int error = e == NULL ? pool_errno : POOL_OK;
+	if (e != NULL)
+	{
+		entry->offset = (int64_t) le64(e->offset);
+		entry->kind = le32(e->kind);
+		entry->reserved = 0;
+		entry->size = le64(e->size);
+	}
+	pool_unlock(p);
+	return error;
+}
+
+//Remove name from the directory of pool p; the object it was given to stays. Returns POOL_OK, POOL_ENOENT if the
+//name was not given or the pool has no directory, or an error code.
+int pool_dir_remove(pool* p, const char* name)
+{
+	trace_call(TRACE_POOL_DIR_REMOVE, p, NULL, 0, 0, name);
+	char key[PDIR_NAME_SIZE];
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (pdir_key(name, key) != POOL_OK)
+	{
+		return POOL_EINVAL;
+	}
+	else if (p->text != NULL) //text pools only hold chars
+	{
+		pool_errno = POOL_ENOENT;
+		return POOL_ENOENT;
+	}
+
+	pool_lock(p, LOCK_PWRITE);
+	OID* d = pdir_open(p, 0);
+	int error = pool_errno;
+	if (d != NULL)
+	{
+		trace_quiet++;
+		error = phash_remove(d, key);
+		trace_quiet--;
+	}
+	pool_unlock(p);
+	return error;
+}
+
+
+//FILE COMMUNICATION
+
+int pfile_read_bin(pool* p, const char* filename, int nthreads);
+int pfile_write_bin(pool* p, const char* filename, int nthreads, int keep_empty);
+
+//Format an OID as a line of a txt file into buf (at most cap bytes), returns the length of the whole line
+int oid_format_txt(const OID* oid, char* buf, size_t cap)
+{
+	if (oid->data_type == 1)
+	{
+		return snprintf(buf, cap, "int data: %d\n", (int) (intptr_t) oid->data);
+	}
+	else if (oid->data_type == 2)
+	{
+		return snprintf(buf, cap, "%c", (int) (intptr_t) oid->data);
+	}
+	else if (oid->data_type == 3 && oid->data == NULL) //oidptr into a pool that does not exist
+	{
+		return snprintf(buf, cap, "oidptr: NULL\n");
+	}
+	else if (oid->data_type == 3)
+	{
+		return snprintf(buf, cap, "oidptr: pool:%s offset:%lld\n", ((OID*)(oid->data))->pool->name, (long long) oid_offset(oid->data));
+	}
+	else if (oid->data_type == 4)
+	{
+		return snprintf(buf, cap, "blob data: %zu bytes\n", oid->data_size);
+	}
+	else
+	{
+		return snprintf(buf, cap, "?");
+	}
+}
+
+//Read a sized record of type and size from a version 1 binary file into an OID.
+//returns POOL_OK, POOL_EBADF if the record is bad (not logged) or POOL_EFULL if its blob could not be made
+int oid_read_record(OID* oid, uint32_t type, uint32_t size, FILE* file_ptr)
+{
+	oid->data = NULL;
+	if (type == 1 && size == sizeof(int))
+	{
+		int num;
+		if (fread(&num, sizeof(int), 1, file_ptr) != 1)
+		{
+			return POOL_EBADF;
+		}
+		oid->data = (int*) (intptr_t) num;
+		oid->data_size = sizeof(int);
+	}
+	else if (type == 2 && size == sizeof(char))
+	{
+		char c;
+		if (fread(&c, sizeof(char), 1, file_ptr) != 1)
+		{
+			return POOL_EBADF;
+		}
+		oid->data = (int*) (intptr_t) c;
+		oid->data_size = sizeof(int);
+	}
+	else if (type == 3 && size == sizeof(void*))
+	{
+		if (fread(&(oid->data), sizeof(void*), 1, file_ptr) != 1)
+		{
+			return POOL_EBADF;
+		}
+		oid->data_size = sizeof(void*);
+		oidptr_count(oid->pool, oid->data, 1);
+	}
+	else if (type == 4)
+	{
+		void* dest = (void*) &oid->data;
+		if (size > BLOB_INLINE_SIZE) //large blobs are read straight into their own extent
+		{
+			oid->data = arena_blob_alloc(&oid->pool->arena, size);
+			if (oid->data == NULL)
+			{
+				return pool_log(POOL_EFULL, "Could not make a blob of %lu bytes!", (unsigned long) size);
+			}
+			dest = oid->data;
+		}
+		if (fread(dest, 1, size, file_ptr) != size)
+		{
+			if (size > BLOB_INLINE_SIZE)
+			{
+				arena_blob_free(&oid->pool->arena, oid->data, size);
+			}
+			oid->data = NULL;
+			return POOL_EBADF;
+		}
+		oid->data_size = size;
+	}
+	else
+	{
+		return POOL_EBADF;
+	}
+
+	oid->data_type = type;
+	oid->empty = 0;
+	return POOL_OK;
+}
+
+//Read contents of a binary file into a pool
+int pfilein(pool* p, char* filename)
+{
+	trace_call(TRACE_PFILEIN, p, NULL, 0, -1, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only read txt files
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only reads txt files!", p->name);
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = POOL_OK;
+		OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+		if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			FILE* file_ptr = fopen(filename, "rb");
+			if (file_ptr == NULL) //missing file exception
+			{
+				error = pool_log(POOL_EIO, "Could not open file %s!", filename);
+				pool_unlock(p);
+				return error;
+			}
+
+			uint32_t rec[2];
+			int header = fread(rec, sizeof(uint32_t), 2, file_ptr) == 2 && le32(rec[0]) == PFILE_MAGIC;
+			if (header == 1 && le32(rec[1]) == PFILE_VERSION) //version 2 files are read through their directory
+			{
+				fclose(file_ptr);
+				error = pfile_read_bin(p, filename, 1);
+				pool_unlock(p);
+				return error;
+			}
+			int sized = header == 1 && rec[1] == 1; //version 1 files hold sized records
+			if (header == 0) //files without the header hold plain ints
+			{
+				rewind(file_ptr);
+			}
+
+			int64_t i = index_offset(tmp);
+			while (1)
+			{
+				if (sized == 1)
+				{
+					if (fread(rec, sizeof(uint32_t), 2, file_ptr) != 2)
+					{
+						break;
+					}
+					if (rec[0] == 0) //skips the range table of files written by pfileout_parallel
+					{
+						fseek(file_ptr, rec[1], SEEK_CUR);
+						continue;
+					}
+					error = oid_read_record(tmp, rec[0], rec[1], file_ptr);
+					if (error == POOL_EBADF)
+					{
+						error = pool_log(POOL_EBADF, "Bad record in file %s at file index %lld", filename, (long long) i);
+					}
+					if (error != POOL_OK)
+					{
+						break;
+					}
+				}
+				else
+				{
+					int num;
+					if (fread(&num, sizeof(int), 1, file_ptr) != 1)
+					{
+						break;
+					}
+					tmp->data = (int*) (intptr_t) num;
+					tmp->empty = 0;
+					tmp->data_size = sizeof(int);
+					tmp->data_type = 1;
+				}
+				oid_dirty(tmp);
+				nvm_write(p, tmp->data_size);
+
+				if (i + 1 >= p->size)
+				{
+					error = pool_log(POOL_EFULL, "Not enough space in pool. Stopped writng to pool at file index %lld", (long long) i);
+					break;			
+				}
+				else if ((tmp = oid_at(p, i + 1)) == NULL) //page of an out-of-core pool not brought in
+				{
+					error = pool_errno;
+					break;
+				}
+				else
+				{
+					i++;
+				}
+			}
+			POOL_STAT(p, bytes_imported, ftell(file_ptr));
+			fclose(file_ptr);
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Read contents of a txt file into a pool
+int pfileintxt(pool* p, char* filename)
+{
+	trace_call(TRACE_PFILEIN, p, NULL, 1, -1, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = POOL_OK;
+		OID * tmp = p->text == NULL ? pool_first_empty(p) : NULL; //first OID of the pool with no data
+		if (p->text != NULL) //text pools keep the file's bytes as one piece at the end of their text
+		{
+			error = text_read_file(p, filename);
+		}
+		else if (tmp == NULL)
+		{
+			error = pool_log(POOL_EFULL, "Pool already full!");
+		}
+		else
+		{
+			FILE* file_ptr = fopen(filename, "r");
+			if (file_ptr == NULL) //missing file exception
+			{
+				error = pool_log(POOL_EIO, "Could not open file %s!", filename);
+				pool_unlock(p);
+				return error;
+			}
+			char c;
+			c = fgetc(file_ptr);
+			int64_t i = index_offset(tmp);
+			while (c != EOF)
+			{
+				tmp->data = (int*) ((int)c);
+				tmp->empty = 0;
+				tmp->data_size = sizeof(int);
+				tmp->data_type = 2;
+				oid_dirty(tmp);
+				nvm_write(p, sizeof(char));
+				if (i + 1 >= p->size)
+				{
+					error = pool_log(POOL_EFULL, "Not enough space in pool. Stopped writng to pool at file index %lld", (long long) i);
+					break;			
+				}
+				else if ((tmp = oid_at(p, i + 1)) == NULL) //page of an out-of-core pool not brought in
+				{
+					error = pool_errno;
+					break;
+				}
+				else
+				{
+					c = fgetc(file_ptr);
+					i++;
+				}
+			}
+			POOL_STAT(p, bytes_imported, ftell(file_ptr));
+			fclose(file_ptr);
+		}
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Print contents of a pool out to a binary file
+int pfileout(pool* p, const char* filename)
+{
+	trace_call(TRACE_PFILEOUT, p, NULL, 0, -1, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = pfile_write_bin(p, filename, 1, 0); //one worker, see pfileout_parallel
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Print contents of a pool out to a txt file
+int pfileouttxt(pool* p, const char* filename)
+{
+	trace_call(TRACE_PFILEOUT, p, NULL, 1, -1, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = POOL_OK;
+		FILE* file_ptr = fopen(filename, "w");
+		if (file_ptr == NULL) //unwritable file exception
+		{
+			error = pool_log(POOL_EIO, "Could not open file %s!", filename);
+			pool_unlock(p);
+			return error;
+		}
+		OID scratch;
+		int64_t i;
+
+		if (p->text != NULL) //text pools write their pieces out as they are
+		{
+			nvm_read(p, p->text->pieces);
+			if (text_write(p->text->tree, file_ptr) == 0)
+			{
+				error = pool_log(POOL_EIO, "Could not write file %s!", filename);
+			}
+		}
+		for (i = 0; i < p->size && p->text == NULL; i++)
+		{
+			const OID * tmp = oid_peek(p, i, &scratch);
+			nvm_read(p, 1);
+			if (tmp == NULL)
+			{
+				error = pool_errno;
+				break;
+			}
+			else if (tmp->empty == 1)
+			{
+				break;
+			}
+			char line[256];
+			int len = oid_format_txt(tmp, line, sizeof(line));
+			if (len < (int) sizeof(line))
+			{
+				fwrite(line, 1, len, file_ptr);
+			}
+			else //long pool names do not fit the line buffer
+			{
+				char* long_line = malloc(len + 1);
+				oid_format_txt(tmp, long_line, len + 1);
+				fwrite(long_line, 1, len, file_ptr);
+				free(long_line);
+			}
+		}
+
+		POOL_STAT(p, bytes_exported, ftell(file_ptr));
+		fclose(file_ptr);
+		pool_unlock(p);
+		return error;
+	}
+}
+
+
+//PARALLEL FILE COMMUNICATION
+
+//For the pool names that oidptrs in a binary file point into
+typedef struct pfile_names
+{
+	const char** names;
+	uint32_t count;
+	uint32_t cap;
+} pfile_names;
+
+//For a range of a pool (or of the chunks of a file) handled by one worker thread
+typedef struct pfile_range
+{
+	pool* p;
+	int64_t first; //offset of the first OID of the range (first chunk for checksum workers)
+	int64_t count; //# of OIDs in the range (# of chunks for checksum workers)
+	int64_t start; //offset of the OID that object 0 of the file is read into
+	uint64_t bytes; //# of bytes the range takes in the txt file, or in the data area of the binary file
+	uint64_t pos; //position of the range in the txt file, or of its data in the data area
+	int txt; //1 for txt files, 0 for binary files
+	int keep_empty; //1 to write empty OIDs too (as type 0 entries) instead of stopping at the first one
+	int fd; //file the range is written to or read from
+	const pfile_header* header; //header of the binary file (host order)
+	pfile_names names; //pool names the range's oidptrs point into
+	pfile_names* all_names; //pool names of the whole file
+	uint32_t* crcs; //checksum of every chunk of the file
+	int error; //1 if the worker failed (POOL_EFULL if it ran out of memory)
+} pfile_range;
+
+//returns the # of a pool name in a name table, adding it if add is 1 (UINT32_MAX if it is not there)
+uint32_t pfile_name_index(pfile_names* t, const char* name, int add)
+{
+	uint32_t i;
+	for (i = 0; i < t->count; i++) //only a few pools are pointed into
+	{
+		if (strcmp(t->names[i], name) == 0)
+		{
+			return i;
+		}
+	}
+	if (add == 0)
+	{
+		return UINT32_MAX;
+	}
+	if (t->count == t->cap)
+	{
+		t->cap = t->cap > 0 ? t->cap * 2 : 4;
+		t->names = realloc(t->names, t->cap * sizeof(char*));
+	}
+	t->names[t->count] = name;
+	t->count++;
+	return t->count - 1;
+}
+
+//returns a pool by name without printing (NULL if there is none)
+pool* pool_find(const char* name)
+{
+	registry_lock_take();
+	pool* p = head_pool;
+	while (p != NULL && strcmp(p->name, name) != 0)
+	{
+		p = p->next;
+	}
+	registry_lock_give();
+	return p;
+}
+
+//returns the OID an oidptr read from a file points to (NULL if the pool or offset does not exist)
+//The pool pointed to is not locked: two threads reading files that point into each other's pools would deadlock.
+OID* pfile_resolve(const char* name, int64_t offset)
+{
+	pool* p = pool_find(name);
+	if (p == NULL || offset < 0 || offset >= p->size)
+	{
+		return NULL;
+	}
+	return oid_at(p, offset);
+}
+
+//returns the # of bytes data of size takes in the data area of a binary file
+uint64_t pfile_data_size(uint32_t size)
+{
+	return size <= sizeof(uint64_t) ? 0 : ((uint64_t) size + 7) & ~(uint64_t) 7;
+}
+
+//Fill in the directory entry of an OID, returns its bytes for the data area (NULL if they fit in the entry).
+//The pool name # and offset of an oidptr are put in ref.
+const void* oid_entry(const OID* oid, pfile_entry* e, pfile_names* names, uint64_t ref[2])
+{
+	e->type = le32(oid->data_type);
+	e->value = 0;
+	if (oid->empty == 1) //only written by pool_hibernate
+	{
+		e->type = 0;
+		e->size = 0;
+		return NULL;
+	}
+	else if (oid->data_type == 1)
+	{
+		e->size = le32(sizeof(int32_t));
+		e->value = le64((uint32_t) (int32_t) (intptr_t) oid->data);
+		return NULL;
+	}
+	else if (oid->data_type == 2)
+	{
+		e->size = le32(sizeof(char));
+		e->value = le64((unsigned char) (intptr_t) oid->data);
+		return NULL;
+	}
+	else if (oid->data_type == 3)
+	{
+		const OID * target = oid->data;
+		e->size = le32(2 * sizeof(uint64_t));
+		ref[0] = le64(target == NULL ? UINT64_MAX : pfile_name_index(names, target->pool->name, 0));
+		ref[1] = le64(target == NULL ? 0 : (uint64_t) (target->pool == oid->pool ? index_offset(target) : oid_offset(target)));
+		return ref;
+	}
+	else
+	{
+		e->size = le32((uint32_t) oid->data_size);
+		if (oid->data_size <= sizeof(uint64_t)) //small blobs fit in the entry
+		{
+			memcpy(&(e->value), oid_blob_bytes(oid), oid->data_size);
+			return NULL;
+		}
+		return oid_blob_bytes(oid);
+	}
+}
+
+//Write all len bytes of buf to file descriptor fd at position pos, returns 0 on failure
+int file_pwrite(int fd, const void* buf, size_t len, uint64_t pos)
+{
+	const char* c = buf;
+	while (len > 0)
+	{
+		ssize_t n = pwrite(fd, c, len, pos);
+		if (n <= 0)
+		{
+			return 0;
+		}
+		c = c + n;
+		len = len - n;
+		pos = pos + n;
+	}
+	return 1;
+}
+
+//Read all len bytes at position pos of file descriptor fd into buf, returns 0 on failure
+int file_pread(int fd, void* buf, size_t len, uint64_t pos)
+{
+	char* c = buf;
+	while (len > 0)
+	{
+		ssize_t n = pread(fd, c, len, pos);
+		if (n <= 0)
+		{
+			return 0;
+		}
+		c = c + n;
+		len = len - n;
+		pos = pos + n;
+	}
+	return 1;
+}
+
+//Run a worker for each of the n ranges, on their own threads if there is more than one, and wait for all of them
+void pfile_run(pfile_range* ranges, int n, void* (*worker)(void*))
+{
+	if (n == 1)
+	{
+		worker(&ranges[0]);
+		return;
+	}
+
+	pthread_t* threads = malloc(n * sizeof(pthread_t));
+	int* started = calloc(n, sizeof(int));
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		started[i] = pthread_create(&threads[i], NULL, worker, &ranges[i]) == 0;
+		if (started[i] == 0) //runs the range itself if no thread is available
+		{
+			worker(&ranges[i]);
+		}
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (started[i] == 1)
+		{
+			pthread_join(threads[i], NULL);
+		}
+	}
+	free(started);
+	free(threads);
+}
+
+//# of workers to use for n items when nthreads are asked for (all processors if nthreads < 1)
+int pfile_workers(int nthreads, uint64_t n)
+{
+	if (nthreads < 1)
+	{
+		nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if ((uint64_t) nthreads > n)
+	{
+		nthreads = (int) n;
+	}
+	return nthreads < 1 ? 1 : nthreads;
+}
+
+//Worker: count the OIDs with data at the start of a range, the bytes they take and the pools their oidptrs point into
+void* pfile_size_worker(void* arg)
+{
+	pfile_range* r = arg;
+	r->bytes = 0;
+	int64_t i;
+	for (i = 0; i < r->count; i++)
+	{
+		OID peek;
+		const OID * tmp = oid_peek(r->p, r->first + i, &peek);
+		if (tmp == NULL) //page of an out-of-core pool not brought in
+		{
+			r->count = i;
+			r->error = 1;
+			break;
+		}
+		else if (tmp->empty == 1) //exports stop at the first OID with no data unless they keep empty OIDs
+		{
+			if (r->keep_empty == 0)
+			{
+				r->count = i;
+				break;
+			}
+		}
+		else if (r->txt == 1)
+		{
+			r->bytes = r->bytes + oid_format_txt(tmp, NULL, 0);
+		}
+		else if (tmp->data_type == 3)
+		{
+			if (tmp->data != NULL)
+			{
+				pfile_name_index(&r->names, ((OID*) tmp->data)->pool->name, 1);
+			}
+			r->bytes = r->bytes + pfile_data_size(2 * sizeof(uint64_t));
+		}
+		else if (tmp->data_type == 4)
+		{
+			r->bytes = r->bytes + pfile_data_size(tmp->data_size);
+		}
+	}
+	return NULL;
+}
+
+//Worker: write the lines of a range to a txt file at the range's position
+void* pfile_txt_worker(void* arg)
+{
+	pfile_range* r = arg;
+	char* buf = malloc(PFILE_BUF_SIZE);
+	size_t used = 0;
+	uint64_t pos = r->pos;
+	int64_t i;
+	for (i = 0; i < r->count && r->error == 0; i++)
+	{
+		OID peek;
+		const OID * tmp = oid_peek(r->p, r->first + i, &peek);
+		if (tmp == NULL)
+		{
+			r->error = 1;
+			break;
+		}
+		nvm_read(r->p, 1);
+		char line[256];
+		char* long_line = NULL;
+		const char* data = line;
+		size_t len = oid_format_txt(tmp, line, sizeof(line));
+		if (len >= sizeof(line)) //long pool names do not fit the line buffer
+		{
+			long_line = malloc(len + 1);
+			oid_format_txt(tmp, long_line, len + 1);
+			data = long_line;
+		}
+
+		if (used + len > PFILE_BUF_SIZE) //writes out what has been gathered so far
+		{
+			r->error = !file_pwrite(r->fd, buf, used, pos);
+			pos = pos + used;
+			used = 0;
+		}
+		if (len > PFILE_BUF_SIZE)
+		{
+			r->error = r->error || !file_pwrite(r->fd, data, len, pos);
+			pos = pos + len;
+		}
+		else
+		{
+			memcpy(buf + used, data, len);
+			used = used + len;
+		}
+		free(long_line);
+	}
+	if (r->error == 0 && used > 0)
+	{
+		r->error = !file_pwrite(r->fd, buf, used, pos);
+	}
+	free(buf);
+	return NULL;
+}
+
+//Worker: write the directory entries and data of a range to a binary file
+void* pfile_bin_worker(void* arg)
+{
+	pfile_range* r = arg;
+	const pfile_header* h = r->header;
+	pfile_entry* dir = malloc(PFILE_BUF_SIZE);
+	int dir_cap = PFILE_BUF_SIZE / sizeof(pfile_entry);
+	int dir_used = 0;
+	uint64_t dir_pos = h->dir_pos + (uint64_t) r->first * sizeof(pfile_entry);
+	char* buf = malloc(PFILE_BUF_SIZE);
+	size_t used = 0;
+	uint64_t data = r->pos; //position in the data area of the next data
+	uint64_t data_written = r->pos; //position in the data area that buf starts at
+	int64_t i;
+	for (i = 0; i < r->count && r->error == 0; i++)
+	{
+		OID peek;
+		uint64_t ref[2];
+		const OID * tmp = oid_peek(r->p, r->first + i, &peek);
+		if (tmp == NULL)
+		{
+			r->error = 1;
+			break;
+		}
+		nvm_read(r->p, 1);
+		const void* bytes = oid_entry(tmp, &dir[dir_used], r->all_names, ref);
+		if (bytes != NULL) //data that does not fit in the entry goes to the data area
+		{
+			uint32_t size = le32(dir[dir_used].size);
+			uint64_t len = pfile_data_size(size);
+			dir[dir_used].value = le64(data);
+			if (used + len > PFILE_BUF_SIZE)
+			{
+				r->error = !file_pwrite(r->fd, buf, used, h->data_pos + data_written);
+				data_written = data_written + used;
+				used = 0;
+			}
+			if (len > PFILE_BUF_SIZE) //large blobs are written straight from the pool
+			{
+				char pad[8] = {0};
+				r->error = r->error || !file_pwrite(r->fd, bytes, size, h->data_pos + data)
+					|| !file_pwrite(r->fd, pad, len - size, h->data_pos + data + size);
+				data_written = data_written + len;
+			}
+			else
+			{
+				memcpy(buf + used, bytes, size);
+				memset(buf + used + size, 0, len - size);
+				used = used + len;
+			}
+			data = data + len;
+		}
+
+		dir_used++;
+		if (dir_used == dir_cap)
+		{
+			r->error = r->error || !file_pwrite(r->fd, dir, dir_used * sizeof(pfile_entry), dir_pos);
+			dir_pos = dir_pos + dir_used * sizeof(pfile_entry);
+			dir_used = 0;
+		}
+	}
+	if (r->error == 0)
+	{
+		r->error = !file_pwrite(r->fd, dir, dir_used * sizeof(pfile_entry), dir_pos) || !file_pwrite(r->fd, buf, used, h->data_pos + data_written);
+	}
+	free(buf);
+	free(dir);
+	return NULL;
+}
+
+//Worker: compute the checksum of a range of the chunks of a binary file, or check it against crcs if crcs are filled in
+void* pfile_crc_worker(void* arg)
+{
+	pfile_range* r = arg;
+	const pfile_header* h = r->header;
+	char* buf = malloc(h->chunk_size);
+	int64_t i;
+	for (i = r->first; i < r->first + r->count && r->error == 0; i++)
+	{
+		uint64_t pos = h->names_pos + (uint64_t) i * h->chunk_size;
+		uint64_t len = h->crc_pos - pos < h->chunk_size ? h->crc_pos - pos : h->chunk_size;
+		if (file_pread(r->fd, buf, len, pos) == 0)
+		{
+			r->error = 1;
+			break;
+		}
+		uint32_t crc = crc32c(0, buf, len);
+		if (r->txt == 1) //checks
+		{
+			r->error = le32(r->crcs[i]) != crc;
+		}
+		else
+		{
+			r->crcs[i] = le32(crc);
+		}
+	}
+	free(buf);
+	return NULL;
+}
+
+//Compute (check = 0) or check (check = 1) the checksum of every chunk of a binary file on nthreads workers, returns 0 on failure
+int pfile_crcs(int fd, const pfile_header* h, uint32_t* crcs, int nthreads, int check)
+{
+	uint64_t chunks = pfile_chunks(h);
+	int n = pfile_workers(nthreads, chunks);
+	pfile_range* ranges = calloc(n, sizeof(pfile_range));
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		ranges[i].first = (int64_t) (chunks * i / n);
+		ranges[i].count = (int64_t) (chunks * (i + 1) / n) - ranges[i].first;
+		ranges[i].fd = fd;
+		ranges[i].header = h;
+		ranges[i].crcs = crcs;
+		ranges[i].txt = check;
+	}
+	pfile_run(ranges, n, pfile_crc_worker);
+	int ok = 1;
+	for (i = 0; i < n; i++)
+	{
+		ok = ok && ranges[i].error == 0;
+	}
+	free(ranges);
+	return ok;
+}
+
+//Split the OIDs of a pool into ranges for nthreads workers and size their part of the file
+pfile_range* pfile_split(pool* p, int* nthreads, int txt, int keep_empty)
+{
+	int n = p->buffer != NULL ? 1 : pfile_workers(*nthreads, p->size); //pages of an out-of-core pool are read in by one worker
+	pfile_range* ranges = calloc(n, sizeof(pfile_range));
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		ranges[i].p = p;
+		ranges[i].first = p->size * i / n;
+		ranges[i].count = p->size * (i + 1) / n - ranges[i].first;
+		ranges[i].txt = txt;
+		ranges[i].keep_empty = keep_empty;
+	}
+	pfile_run(ranges, n, pfile_size_worker);
+
+	for (i = 0; i < n && keep_empty == 0; i++) //drops everything after the first OID with no data, like pfileout
+	{
+		if (ranges[i].first + ranges[i].count < (i + 1 < n ? ranges[i + 1].first : p->size))
+		{
+			int j;
+			for (j = i + 1; j < n; j++)
+			{
+				ranges[j].count = 0;
+				ranges[j].bytes = 0;
+				ranges[j].names.count = 0;
+			}
+			break;
+		}
+	}
+
+	*nthreads = n;
+	return ranges;
+}
+
+//Free the ranges of an export
+void pfile_free(pfile_range* ranges, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		free(ranges[i].names.names);
+	}
+	free(ranges);
+}
+
+//Write the OIDs of a pool to a txt file on nthreads workers
+int pfile_write_txt(pool* p, const char* filename, int nthreads)
+{
+	if (p->text != NULL) //the pieces of a text pool are written in order, there are no lines to format
+	{
+		trace_quiet++;
+		int error = pfileouttxt(p, filename);
+		trace_quiet--;
+		return error;
+	}
+	pfile_range* ranges = pfile_split(p, &nthreads, 1, 0);
+	uint64_t pos = 0;
+	int i;
+	for (i = 0; i < nthreads; i++)
+	{
+		ranges[i].pos = pos;
+		pos = pos + ranges[i].bytes;
+	}
+
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) //unwritable file exception
+	{
+		pfile_free(ranges, nthreads);
+		return pool_log(POOL_EIO, "Could not open file %s!", filename);
+	}
+	for (i = 0; i < nthreads; i++)
+	{
+		ranges[i].fd = fd;
+	}
+	pfile_run(ranges, nthreads, pfile_txt_worker);
+	int failed = 0;
+	for (i = 0; i < nthreads; i++)
+	{
+		failed = failed || ranges[i].error;
+	}
+	int error = POOL_OK;
+	if (failed == 1)
+	{
+		error = pool_log(POOL_EIO, "Could not write file %s!", filename);
+	}
+	POOL_STAT(p, bytes_exported, pos);
+	close(fd);
+	pfile_free(ranges, nthreads);
+	return error;
+}
+
+//Write the OIDs of a pool to a version 2 binary file on nthreads workers (every OID if keep_empty is 1)
+int pfile_write_bin(pool* p, const char* filename, int nthreads, int keep_empty)
+{
+	phash_settle(p); //hash maps being resized are written with every key in their blob
+	pfile_range* ranges = pfile_split(p, &nthreads, 0, keep_empty);
+
+	pfile_header h;
+	memset(&h, 0, sizeof(h));
+	h.magic = PFILE_MAGIC;
+	h.version = PFILE_VERSION;
+	h.header_size = sizeof(pfile_header);
+	h.chunk_size = PFILE_CHUNK_SIZE;
+	pfile_names names = {NULL, 0, 0};
+	int i;
+	uint32_t j;
+	for (i = 0; i < nthreads; i++) //lays out the file
+	{
+		for (j = 0; j < ranges[i].names.count; j++)
+		{
+			if (pfile_name_index(&names, ranges[i].names.names[j], 0) == UINT32_MAX)
+			{
+				pfile_name_index(&names, ranges[i].names.names[j], 1);
+				h.names_size = h.names_size + strlen(ranges[i].names.names[j]) + 1;
+			}
+		}
+		ranges[i].pos = h.data_size;
+		ranges[i].all_names = &names;
+		ranges[i].header = &h;
+		h.count = h.count + ranges[i].count;
+		h.data_size = h.data_size + ranges[i].bytes;
+	}
+	h.name_count = names.count;
+	h.names_pos = sizeof(pfile_header);
+	h.dir_pos = (h.names_pos + h.names_size + 7) & ~(uint64_t) 7;
+	h.data_pos = h.dir_pos + h.count * sizeof(pfile_entry);
+	h.crc_pos = h.data_pos + h.data_size;
+
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) //unwritable file exception
+	{
+		free(names.names);
+		pfile_free(ranges, nthreads);
+		return pool_log(POOL_EIO, "Could not open file %s!", filename);
+	}
+
+	char* name_bytes = calloc(h.dir_pos - h.names_pos + 1, 1);
+	char* c = name_bytes;
+	for (j = 0; j < names.count; j++)
+	{
+		strcpy(c, names.names[j]);
+		c = c + strlen(names.names[j]) + 1;
+	}
+	int failed = !file_pwrite(fd, name_bytes, h.dir_pos - h.names_pos, h.names_pos);
+	free(name_bytes);
+
+	for (i = 0; i < nthreads; i++)
+	{
+		ranges[i].fd = fd;
+	}
+	pfile_run(ranges, nthreads, pfile_bin_worker);
+	for (i = 0; i < nthreads; i++)
+	{
+		failed = failed || ranges[i].error;
+	}
+
+	uint64_t chunks = pfile_chunks(&h);
+	uint32_t* crcs = malloc((chunks + 1) * sizeof(uint32_t));
+	failed = failed || !pfile_crcs(fd, &h, crcs, nthreads, 0) || !file_pwrite(fd, crcs, chunks * sizeof(uint32_t), h.crc_pos);
+
+	pfile_header raw = h;
+	pfile_header_swap(&raw);
+	raw.header_crc = le32(crc32c(0, &raw, offsetof(pfile_header, header_crc)));
+	failed = failed || !file_pwrite(fd, &raw, sizeof(raw), 0);
+	int error = POOL_OK;
+	if (failed == 1)
+	{
+		error = pool_log(POOL_EIO, "Could not write file %s!", filename);
+	}
+	POOL_STAT(p, bytes_exported, h.crc_pos + chunks * sizeof(uint32_t));
+
+	close(fd);
+	free(crcs);
+	free(names.names);
+	pfile_free(ranges, nthreads);
+	return error;
+}
+
+//Worker: read the directory entries and data of a range of a binary file into the OIDs of the pool
+void* pfile_read_worker(void* arg)
+{
+	pfile_range* r = arg;
+	const pfile_header* h = r->header;
+	int dir_cap = PFILE_BUF_SIZE / sizeof(pfile_entry);
+	pfile_entry* dir = malloc(PFILE_BUF_SIZE);
+	if (dir == NULL) //malloc exception
+	{
+		r->error = POOL_EFULL;
+		return NULL;
+	}
+	int64_t i;
+	for (i = 0; i < r->count && r->error == 0; i = i + dir_cap)
+	{
+		int64_t n = r->count - i < dir_cap ? r->count - i : dir_cap;
+		if (file_pread(r->fd, dir, n * sizeof(pfile_entry), h->dir_pos + (uint64_t) (r->first + i) * sizeof(pfile_entry)) == 0)
+		{
+			r->error = 1;
+			break;
+		}
+		int64_t j;
+		for (j = 0; j < n; j++)
+		{
+			OID * tmp = oid_at(r->p, r->start + r->first + i + j);
+			if (tmp == NULL) //page of an out-of-core pool not brought in
+			{
+				r->error = 1;
+				break;
+			}
+			oid_dirty(tmp);
+			uint32_t type = le32(dir[j].type);
+			uint32_t size = le32(dir[j].size);
+			uint64_t value = le64(dir[j].value);
+			tmp->data = NULL;
+			if (type == 0 && size == 0) //empty OIDs kept by pool_hibernate
+			{
+				tmp->data_size = 0;
+				tmp->data_type = 0;
+				tmp->empty = 1;
+				continue;
+			}
+			else if (type == 1 && size == sizeof(int32_t))
+			{
+				tmp->data = (int*) (intptr_t) (int32_t) (uint32_t) value;
+				tmp->data_size = sizeof(int);
+			}
+			else if (type == 2 && size == sizeof(char))
+			{
+				tmp->data = (int*) (intptr_t) (char) value;
+				tmp->data_size = sizeof(int);
+			}
+			else if (type == 3 && size == 2 * sizeof(uint64_t))
+			{
+				uint64_t ref[2];
+				if (value + sizeof(ref) > h->data_size || file_pread(r->fd, ref, sizeof(ref), h->data_pos + value) == 0)
+				{
+					r->error = 1;
+					break;
+				}
+				ref[0] = le64(ref[0]);
+				tmp->data = ref[0] < r->all_names->count ? pfile_resolve(r->all_names->names[ref[0]], (int64_t) le64(ref[1])) : NULL;
+				tmp->data_size = sizeof(void*);
+				oidptr_count(r->p, tmp->data, 1);
+			}
+			else if (type == 4 && size <= BLOB_INLINE_SIZE)
+			{
+				memcpy(&(tmp->data), &(dir[j].value), size);
+				tmp->data_size = size;
+			}
+			else if (type == 4 && size <= sizeof(uint64_t)) //small blobs that fit in an entry but not in data
+			{
+				tmp->data = arena_blob_alloc(&r->p->arena, size);
+				if (tmp->data == NULL)
+				{
+					r->error = POOL_EFULL;
+					break;
+				}
+				memcpy(tmp->data, &(dir[j].value), size);
+				tmp->data_size = size;
+			}
+			else if (type == 4 && size > sizeof(uint64_t) && value + size <= h->data_size)
+			{
+				tmp->data = arena_blob_alloc(&r->p->arena, size); //large blobs are read straight into their own extent
+				if (tmp->data == NULL)
+				{
+					r->error = POOL_EFULL;
+					break;
+				}
+				else if (file_pread(r->fd, tmp->data, size, h->data_pos + value) == 0)
+				{
+					arena_blob_free(&r->p->arena, tmp->data, size);
+					tmp->data = NULL;
+					r->error = 1;
+					break;
+				}
+				tmp->data_size = size;
+			}
+			else
+			{
+				r->error = 1;
+				break;
+			}
+			tmp->data_type = type;
+			tmp->empty = 0;
+			nvm_write(r->p, size);
 		}
 	}
+	free(dir);
+	return NULL;
 }
 
-//Write char to a pool
-void pwritechar(pool* p, char c)
+//Read a version 2 binary file into a pool on nthreads workers, starting at its first OID with no data
+int pfile_read_bin(pool* p, const char* filename, int nthreads)
+{
+	int error = POOL_OK;
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	pfile_header h;
+	char raw[sizeof(pfile_header)];
+	if (fd < 0 || fstat(fd, &st) != 0) //missing file exception
+	{
+		error = pool_log(POOL_EIO, "Could not open file %s!", filename);
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return error;
+	}
+	if (file_pread(fd, raw, sizeof(raw), 0) == 0 || pfile_header_read(raw, st.st_size, &h) == 0)
+	{
+		error = pool_log(POOL_EBADF, "Damaged header in file %s!", filename);
+		close(fd);
+		return error;
+	}
+
+	uint64_t chunks = pfile_chunks(&h);
+	uint32_t* crcs = malloc((chunks + 1) * sizeof(uint32_t));
+	char* name_bytes = malloc(h.names_size + 1);
+	if (file_pread(fd, crcs, chunks * sizeof(uint32_t), h.crc_pos) == 0 || pfile_crcs(fd, &h, crcs, nthreads, 1) == 0
+		|| file_pread(fd, name_bytes, h.names_size, h.names_pos) == 0)
+	{
+		error = pool_log(POOL_EBADF, "Checksum mismatch in file %s!", filename);
+		free(crcs);
+		free(name_bytes);
+		close(fd);
+		return error;
+	}
+	name_bytes[h.names_size] = '\0';
+	pfile_names names = {NULL, 0, 0};
+	char* c = name_bytes;
+	while (names.count < h.name_count && c < name_bytes + h.names_size)
+	{
+		pfile_name_index(&names, c, 1);
+		c = c + strlen(c) + 1;
+	}
+
+	OID * tmp = pool_first_empty(p); //first OID of the pool with no data
+	int64_t start = tmp == NULL ? p->size : index_offset(tmp);
+	uint64_t count = h.count;
+	if (count > 0 && start >= p->size)
+	{
+		error = pool_log(POOL_EFULL, "Pool already full!");
+		count = 0;
+	}
+	else if (count > (uint64_t) (p->size - start))
+	{
+		error = pool_log(POOL_EFULL, "Not enough space in pool. Stopped writng to pool at file index %lld", (long long) (p->size - start));
+		count = p->size - start;
+	}
+
+	int64_t i;
+	for (i = start; i < start + (int64_t) count && p->buffer == NULL; i++) //brings objects of a mapped pool into memory before the workers overwrite them
+	{
+		oid_at(p, i);
+	}
+
+	int n = p->buffer != NULL ? 1 : pfile_workers(nthreads, count); //pages of an out-of-core pool are read in by one worker
+	pfile_range* ranges = calloc(n, sizeof(pfile_range));
+	for (i = 0; i < n; i++)
+	{
+		ranges[i].p = p;
+		ranges[i].first = (int64_t) (count * i / n);
+		ranges[i].count = (int64_t) (count * (i + 1) / n) - ranges[i].first;
+		ranges[i].start = start;
+		ranges[i].fd = fd;
+		ranges[i].header = &h;
+		ranges[i].all_names = &names;
+	}
+	pfile_run(ranges, n, pfile_read_worker);
+	for (i = 0; i < n; i++)
+	{
+		if (ranges[i].error == POOL_EFULL)
+		{
+			error = pool_log(POOL_EFULL, "Could not make room for the blobs of file %s in range %lld", filename, (long long) i);
+		}
+		else if (ranges[i].error == 1)
+		{
+			error = pool_log(POOL_EBADF, "Bad directory entry in file %s in range %lld", filename, (long long) i);
+		}
+	}
+
+	POOL_STAT(p, bytes_imported, st.st_size);
+	free(ranges);
+	free(names.names);
+	free(name_bytes);
+	free(crcs);
+	close(fd);
+	return error;
+}
+
+//Check the checksum of every chunk and every directory entry of the file a pool was mapped from (pool_create_map),
+//returns POOL_OK if they are all sound. Files are used without reading them through when they are mapped, so damage
+//is only found by asking or when a damaged object is used.
+int pool_verify(pool* p)
+{
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->map == NULL) //pool not mapped exception
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is not mapped from a file!", p->name);
+	}
+	else if (p->map_version != 2) //older files have no checksums
+	{
+		return POOL_OK;
+	}
+	pfile_header h;
+	pfile_header_read(p->map, p->map_len, &h);
+	const uint32_t* crcs = (const uint32_t*) (p->map + h.crc_pos);
+	uint64_t chunks = pfile_chunks(&h);
+	uint64_t i;
+	for (i = 0; i < chunks; i++)
+	{
+		uint64_t pos = h.names_pos + i * h.chunk_size;
+		uint64_t len = h.crc_pos - pos < h.chunk_size ? h.crc_pos - pos : h.chunk_size;
+		if (crc32c(0, p->map + pos, len) != le32(crcs[i]))
+		{
+			return pool_log(POOL_EBADF, "Checksum mismatch in chunk %lld of pool %s!", (long long) i, p->name);
+		}
+	}
+	for (i = 0; i < h.count; i++) //entries are only checked as they are used otherwise
+	{
+		if (map_check(p, i) == 0)
+		{
+			return POOL_EBADF;
+		}
+	}
+	return POOL_OK;
+}
+
+//Print contents of a pool out to a binary file using nthreads worker threads (all processors if nthreads < 1).
+//Each worker writes the directory entries and data of its range of the pool at their place in the file.
+int pfileout_parallel(pool* p, const char* filename, int nthreads)
+{
+	trace_call(TRACE_PFILEOUT, p, NULL, 0, nthreads, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = pfile_write_bin(p, filename, nthreads, 0);
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Print contents of a pool out to a txt file using nthreads worker threads (all processors if nthreads < 1).
+//The file is the same as pfileouttxt's.
+int pfileouttxt_parallel(pool* p, const char* filename, int nthreads)
+{
+	trace_call(TRACE_PFILEOUT, p, NULL, 1, nthreads, filename);
+	if (p == NULL) //pool NULL exception
+	{
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else
+	{
+		pool_lock(p, LOCK_FILE);
+		int error = pfile_write_txt(p, filename, nthreads);
+		pool_unlock(p);
+		return error;
+	}
+}
+
+//Read contents of a binary file into a pool using a worker thread per processor.
+//Older files without a directory are read by pfilein.
+int pfilein_parallel(pool* p, char* filename)
 {
+	trace_call(TRACE_PFILEIN, p, NULL, 0, 0, filename);
 	if (p == NULL) //pool NULL exception
 	{
-		printf("ERROR: The specified pool is NULL!\n");
+		return pool_log(POOL_ENULL, "The specified pool is NULL!");
+	}
+	else if (p->closed == 1) //pool closed exception
+	{
+		return pool_log(POOL_ECLOSED, "The specified pool is closed!");
+	}
+	else if (p->text != NULL) //text pools only read txt files
+	{
+		return pool_log(POOL_EINVAL, "Pool %s is a text pool and only reads txt files!", p->name);
+	}
+
+	FILE* file_ptr = fopen(filename, "rb");
+	if (file_ptr == NULL) //missing file exception
+	{
+		return pool_log(POOL_EIO, "Could not open file %s!", filename);
+	}
+	uint32_t rec[2];
+	int version2 = fread(rec, sizeof(uint32_t), 2, file_ptr) == 2 && le32(rec[0]) == PFILE_MAGIC && le32(rec[1]) == PFILE_VERSION;
+	fclose(file_ptr);
+
+	int error;
+	if (version2 == 1)
+	{
+		pool_lock(p, LOCK_FILE);
+		error = pfile_read_bin(p, filename, 0);
+		pool_unlock(p);
+	}
+	else
+	{
+		trace_quiet++;
+		error = pfilein(p, filename);
+		trace_quiet--;
+	}
+	return error;
+}
+
+
+//TRACE REPLAY
+
+//For a record of a trace
+typedef struct trace_rec
+{
+	int op; //TRACE_ op
+	uint32_t pool; //# of the pool in the trace (0 for NULL)
+	int64_t a; //arguments of the op
+	int64_t b;
+	char* str; //string of the op (NUL terminated, NULL if none)
+} trace_rec;
+
+//For a trace being replayed
+typedef struct trace_replay
+{
+	trace_rec* recs; //records of the trace
+	uint64_t count; //# of records
+	pool** pools; //pool with each # of the trace
+	char** names; //name of the pool with each #
+	uint32_t pool_count; //# of pools in the trace
+	int* worker; //worker that replays each pool's records
+	pthread_mutex_t lock; //taken for calls that change the list of pools or read files, which other workers may touch
+	int nthreads; //# of workers
+} trace_replay;
+
+//For one replay worker
+typedef struct trace_worker
+{
+	trace_replay* r;
+	int n; //# of the worker
+	uint64_t done; //# of records replayed
+} trace_worker;
+
+//Read a LEB128 varint at *at (before end) into v, returns 0 if the trace ends first
+int trace_read_varint(const unsigned char** at, const unsigned char* end, uint64_t* v)
+{
+	int shift = 0;
+	*v = 0;
+	while (*at < end && shift < 64)
+	{
+		unsigned char c = **at;
+		(*at)++;
+		*v = *v | ((uint64_t) (c & 0x7F) << shift);
+		if ((c & 0x80) == 0)
+		{
+			return 1;
+		}
+		shift = shift + 7;
+	}
+	return 0;
+}
+
+//Decode a zigzag encoded #
+int64_t trace_unzigzag(uint64_t v)
+{
+	return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+//Decode the records of a trace of len bytes at buf into r, returns 0 if the trace is damaged
+int trace_decode(const unsigned char* buf, size_t len, trace_replay* r)
+{
+	const unsigned char* at = buf + 2 * sizeof(uint32_t);
+	const unsigned char* end = buf + len;
+	uint64_t cap = 1024;
+	r->recs = malloc(cap * sizeof(trace_rec));
+	r->count = 0;
+	r->pool_count = 0;
+	while (at < end)
+	{
+		trace_rec e;
+		uint64_t v;
+		uint64_t t;
+		uint64_t thread;
+		uint64_t id;
+		e.op = *at;
+		at++;
+		e.a = 0;
+		e.b = 0;
+		e.str = NULL;
+		if (e.op < 1 || e.op >= TRACE_OPS || trace_read_varint(&at, end, &t) == 0 || trace_read_varint(&at, end, &thread) == 0
+			|| trace_read_varint(&at, end, &id) == 0 || id > UINT32_MAX - 1)
+		{
+			return 0;
+		}
+		e.pool = (uint32_t) id;
+		if (trace_ops[e.op][0] > 0)
+		{
+			if (trace_read_varint(&at, end, &v) == 0)
+			{
+				return 0;
+			}
+			e.a = trace_unzigzag(v);
+		}
+		if (trace_ops[e.op][0] > 1)
+		{
+			if (trace_read_varint(&at, end, &v) == 0)
+			{
+				return 0;
+			}
+			e.b = trace_unzigzag(v);
+		}
+		if (trace_ops[e.op][1] == 1)
+		{
+			if (trace_read_varint(&at, end, &v) == 0 || v > (uint64_t) (end - at))
+			{
+				return 0;
+			}
+			e.str = malloc(v + 1); //pools keep their name, so strings outlive the trace
+			memcpy(e.str, at, v);
+			e.str[v] = '\0';
+			at = at + v;
+		}
+		if (e.pool > r->pool_count)
+		{
+			r->pool_count = e.pool;
+		}
+		if (e.op == TRACE_PWRITEPTR && e.a > r->pool_count)
+		{
+			r->pool_count = (uint32_t) e.a;
+		}
+
+		if (r->count == cap)
+		{
+			cap = cap * 2;
+			r->recs = realloc(r->recs, cap * sizeof(trace_rec));
+		}
+		r->recs[r->count] = e;
+		r->count++;
+	}
+	return 1;
+}
+
+//returns the group a pool # is in (see trace_assign)
+uint32_t trace_group(uint32_t* group, uint32_t id)
+{
+	while (group[id] != id)
+	{
+		group[id] = group[group[id]];
+		id = group[id];
+	}
+	return id;
+}
+
+//Give each pool # a worker. Pools that point into each other or use the same file are replayed by the same worker,
+//so each pool is only ever touched by one thread; groups go to workers in turn.
+void trace_assign(trace_replay* r)
+{
+	uint32_t* group = malloc((r->pool_count + 1) * sizeof(uint32_t));
+	uint32_t i;
+	uint64_t j;
+	uint64_t files = 0;
+	for (j = 0; j < r->count; j++)
+	{
+		trace_rec* e = &r->recs[j];
+		files = files + (e->op == TRACE_PFILEIN || e->op == TRACE_PFILEOUT || e->op == TRACE_POOL_CREATE_MAP);
+	}
+	uint64_t cap = 16;
+	while (cap < 2 * files) //the table of files is at most half full
+	{
+		cap = cap * 2;
+	}
+	uint64_t* file_first = calloc(cap, sizeof(uint64_t)); //first record using each file + 1, by hash of its name (0 if none)
+	for (i = 0; i <= r->pool_count; i++)
+	{
+		group[i] = i;
+	}
+	for (j = 0; j < r->count; j++)
+	{
+		trace_rec* e = &r->recs[j];
+		uint32_t other = 0;
+		if (e->op == TRACE_PWRITEPTR && e->a > 0 && e->a <= r->pool_count)
+		{
+			other = (uint32_t) e->a;
+		}
+		else if (e->op == TRACE_PFILEIN || e->op == TRACE_PFILEOUT || e->op == TRACE_POOL_CREATE_MAP)
+		{
+			uint64_t k = phash_hash(e->str, strlen(e->str)) & (cap - 1);
+			while (file_first[k] != 0 && strcmp(r->recs[file_first[k] - 1].str, e->str) != 0) //finds the first record with the same file
+			{
+				k = (k + 1) & (cap - 1);
+			}
+			if (file_first[k] == 0)
+			{
+				file_first[k] = j + 1;
+			}
+			else
+			{
+				other = r->recs[file_first[k] - 1].pool;
+			}
+		}
+		if (other != 0 && e->pool != 0)
+		{
+			group[trace_group(group, e->pool)] = trace_group(group, other);
+		}
+	}
+
+	int next = 0;
+	r->worker = malloc((r->pool_count + 1) * sizeof(int));
+	for (i = 0; i <= r->pool_count; i++)
+	{
+		r->worker[i] = -1;
+	}
+	for (i = 0; i <= r->pool_count; i++)
+	{
+		uint32_t g = trace_group(group, i);
+		if (r->worker[g] < 0)
+		{
+			r->worker[g] = next % r->nthreads;
+			next++;
+		}
+		r->worker[i] = r->worker[g];
+	}
+	free(file_first);
+	free(group);
+}
+
+//Run the call of a record again
+void trace_exec(trace_replay* r, trace_rec* e)
+{
+	pool* p = e->pool <= r->pool_count ? r->pools[e->pool] : NULL;
+	int locked = e->op == TRACE_DEFINE || e->op == TRACE_POOL_CREATE || e->op == TRACE_POOL_CREATE_MAP || e->op == TRACE_POOL_OPEN
+		|| e->op == TRACE_POOL_DESTROY || e->op == TRACE_PFILEIN || e->op == TRACE_PFILEOUT || e->op == TRACE_POOL_CREATE_PAGED
+		|| e->op == TRACE_POOL_CREATE_TEXT;
+	if (locked == 1)
+	{
+		pthread_mutex_lock(&r->lock);
+	}
+
+	if (e->op == TRACE_DEFINE)
+	{
+		r->names[e->pool] = e->str;
+		if (e->b == 1) //pools from before the trace start out empty
+		{
+			r->pools[e->pool] = pool_create(e->str, e->a);
+		}
+	}
+	else if (e->op == TRACE_POOL_CREATE)
+	{
+		r->pools[e->pool] = pool_create(r->names[e->pool] == NULL ? "" : r->names[e->pool], e->a);
+	}
+	else if (e->op == TRACE_POOL_CREATE_MAP)
+	{
+		r->pools[e->pool] = pool_create_map(r->names[e->pool] == NULL ? "" : r->names[e->pool], e->str);
+	}
+	else if (e->op == TRACE_POOL_CREATE_PAGED)
+	{
+		r->pools[e->pool] = pool_create_paged(r->names[e->pool] == NULL ? "" : r->names[e->pool], e->str, e->a, e->b);
+	}
+	else if (e->op == TRACE_POOL_CREATE_TEXT)
+	{
+		r->pools[e->pool] = pool_create_text(r->names[e->pool] == NULL ? "" : r->names[e->pool]);
+	}
+	else if (e->op == TRACE_POOL_OPEN)
+	{
+		pool_open(e->str);
+	}
+	else if (e->op == TRACE_POOL_CLOSE && p != NULL)
+	{
+		pool_close(p);
+	}
+	else if (e->op == TRACE_POOL_PERSIST)
+	{
+		pool_persist(p);
+	}
+	else if (e->op == TRACE_POOL_DESTROY && p != NULL)
+	{
+		pool_destroy(p);
+		r->pools[e->pool] = NULL;
+	}
+	else if (e->op == TRACE_POOL_RESET)
+	{
+		pool_reset(p);
+	}
+	else if (e->op == TRACE_POOL_HIBERNATE)
+	{
+		pool_hibernate(p, e->str[0] == '\0' ? NULL : e->str);
+	}
+	else if (e->op == TRACE_PMALLOC)
+	{
+		pmalloc(p, e->a);
+	}
+	else if (e->op == TRACE_PFREE)
+	{
+		pfree(p == NULL || p->closed == 1 || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a));
+	}
+	else if (e->op == TRACE_PMALLOC_RANGE)
+	{
+		pmalloc_range(p, e->a, e->b);
 	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PFREE_RANGE)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		pfree_range(p, e->a, e->b);
 	}
-	else
+	else if (e->op == TRACE_PTEXT_INSERT)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
-		{
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
-		}
-	
-		if (tmp->offset >= p->size || tmp->empty == 0)
-		{
-			printf("ERROR: Pool already full!\n");
-		}
-		else
-		{
-			tmp->data = (int*) ((int)c);
-			tmp->data_size = sizeof(int);
-			tmp->data_type = 2;
-			tmp->empty = 0;
-		}
+		ptext_insert(p, e->a, e->str);
 	}
-}
-
-//Write string to a pool
-void pwritestr(pool* p, const char* string)
-{
-	if (p == NULL) //pool NULL exception
+	else if (e->op == TRACE_PTEXT_DELETE)
 	{
-		printf("ERROR: The specified pool is NULL!\n");	
+		ptext_delete(p, e->a, e->b);
 	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PTEXT_REPLACE)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		ptext_replace(p, e->a, e->b, e->str);
 	}
-	else
+	else if (e->op == TRACE_PVEC_CREATE)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
+		pvec_create(p, (size_t) e->a, e->b);
+	}
+	else if (e->op == TRACE_PVEC_APPEND || e->op == TRACE_PVEC_RESIZE || e->op == TRACE_PVEC_RESERVE)
+	{
+		OID* v = p == NULL || p->closed == 1 || p->text != NULL || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a);
+		if (e->op == TRACE_PVEC_RESIZE)
 		{
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
+			pvec_resize(v, e->b);
 		}
-	
-		if (tmp->offset >= p->size - 1)
+		else if (e->op == TRACE_PVEC_RESERVE)
 		{
-			printf("ERROR: Pool already full!\n");
+			pvec_reserve(v, e->b);
 		}
 		else
 		{
-			int i;
-			int sl = strlen(string);
-			for (i = 0; i < sl; i++)
-			{
-				tmp->data = (int*) ((int)string[i]); //writes char to OIDs
-				tmp->data_size = sizeof(int);
-				tmp->data_type = 2;
-				tmp->empty = 0;
-				if (tmp->offset >= p->size - 1)
-				{
-					printf("ERROR: Not enough space in pool. Stopped writng to pool at string index %d\n", i);	
-					break;			
-				}
-				else
-				{
-					tmp = tmp->next;
-				}
-			}
+			int64_t elem_size = v == NULL || v->data_type != 4 || v->data_size < sizeof(pvec_header) ? 1 : le32(((pvec_header*) v->data)->elem_size);
+			void* buf = calloc(e->b > 0 ? e->b * elem_size : 1, 1); //only the # of elements is kept
+			pvec_append(v, buf, e->b);
+			free(buf);
 		}
 	}
-}
-
-//Write ptr to a pool
-void pwriteptr(pool* p, void* ptr)
-{
-	if (p == NULL) //pool NULL exception
-	{
-		printf("ERROR: The specified pool is NULL!\n");	
-	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PHASH_CREATE)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		phash_create(p, (size_t) ((uint64_t) e->a >> 32), (size_t) (e->a & UINT32_MAX), e->b);
 	}
-	else
+	else if (e->op == TRACE_PHASH_PUT || e->op == TRACE_PHASH_GET || e->op == TRACE_PHASH_REMOVE)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
+		OID* m = p == NULL || p->closed == 1 || p->text != NULL || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a);
+		size_t key_size = m == NULL || m->data_type != 4 || m->data_size < sizeof(phash_header) ? 8 : le32(((phash_header*) m->data)->key_size);
+		unsigned char* key = calloc(key_size > 8 ? key_size : 8, 1); //only the first 8 bytes of the key are kept
+		size_t i;
+		for (i = 0; i < 8; i++)
 		{
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
+			key[i] = (unsigned char) ((uint64_t) e->b >> (8 * i));
 		}
-	
-		if (tmp->offset >= p->size || tmp->empty == 0)
+		if (e->op == TRACE_PHASH_PUT)
+		{
+			phash_put(m, key, NULL);
+		}
+		else if (e->op == TRACE_PHASH_GET)
 		{
-			printf("ERROR: Pool already full!\n");
+			phash_get(m, key);
 		}
 		else
 		{
-			tmp->data = ptr;
-			tmp->data_size = sizeof(ptr);
-			tmp->data_type = 3;
-			tmp->empty = 0;
+			phash_remove(m, key);
 		}
+		free(key);
 	}
-}
-
-//Read a pool
-void preadf(pool* p)
-{
-	if (p == NULL) //pool NULL exception
-	{
-		printf("ERROR: The specified pool is NULL!\n");	
-	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PBTREE_CREATE)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		pbtree_create(p, (int) ((uint64_t) e->a >> 32), (size_t) (e->a & UINT32_MAX), (size_t) e->b);
 	}
-	else
+	else if (e->op == TRACE_PBTREE_PUT || e->op == TRACE_PBTREE_GET || e->op == TRACE_PBTREE_REMOVE || e->op == TRACE_PBTREE_LOAD)
 	{
-		OID * tmp = p->root;
-		int i = 0;
-		while (tmp->empty != 1)
+		OID* t = p == NULL || p->closed == 1 || p->text != NULL || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a);
+		pbtree_header* h = t == NULL || t->data_type != 4 || t->data_size < 2 * PBTREE_NODE_SIZE ? NULL : t->data;
+		size_t key_size = h == NULL ? 8 : le32(h->key_size);
+		int str = h != NULL && le32(h->key_type) == PBTREE_STR;
+		if (e->op == TRACE_PBTREE_LOAD) //only the # of keys is kept, so keys 0, 1, 2... are loaded
 		{
-			if (tmp->data_type == 1)
-			{
-				printf("%d|", (int) tmp->data);
-			}
-			else if (tmp->data_type == 2)
+			int64_t n = e->b > 0 ? e->b : 0;
+			char* keys = calloc(n > 0 ? n * key_size : 1, 1);
+			int64_t i;
+			for (i = 0; i < n; i++)
 			{
-				printf("%c|", (int) tmp->data);
+				if (str == 1)
+				{
+					snprintf(keys + i * key_size, key_size, "%0*lld", (int) key_size - 1, (long long) i);
+				}
+				else
+				{
+					memcpy(keys + i * key_size, &i, sizeof(int64_t));
+				}
 			}
-			else if (tmp->data_type == 3)
+			pbtree_load(t, keys, NULL, e->b);
+			free(keys);
+		}
+		else
+		{
+			char key[PBTREE_MAX_KEY + 1];
+			memset(key, 0, sizeof(key));
+			uint64_t word = le64((uint64_t) e->b); //the key as kept in the tree, so int keys are read back the same way
+			memcpy(key, &word, str == 1 && key_size - 1 < 8 ? key_size - 1 : 8);
+			if (str == 0)
 			{
-				printf("oidptr: pool:%s offset:%d\n", ((OID*)(tmp->data))->pool->name, ((OID*)(tmp->data))->offset);
+				int64_t k = (int64_t) le64(word);
+				memcpy(key, &k, sizeof(int64_t));
 			}
-			else
+			if (e->op == TRACE_PBTREE_PUT)
 			{
-				printf("ERROR: Invalid data type at offset %d!\n", i);
+				pbtree_put(t, key, NULL);
 			}
-			i++;
-			if (i < p->size)
+			else if (e->op == TRACE_PBTREE_GET)
 			{
-				tmp = tmp->next;
+				pbtree_get(t, key);
 			}
 			else
 			{
-				break;
+				pbtree_remove(t, key);
 			}
 		}
-	
-		printf("\n");
-	}
-}
-
-
-//FILE COMMUNICATION
-
-//Read contents of a binary file into a pool
-void pfilein(pool* p, char* filename)
-{
-	if (p == NULL) //pool NULL exception
-	{
-		printf("ERROR: The specified pool is NULL!\n");
 	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PQUEUE_CREATE)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		pqueue_create(p, (int) ((uint64_t) e->a >> 32), (size_t) (e->a & UINT32_MAX), e->b);
 	}
-	else
+	else if (e->op == TRACE_PQUEUE_PUSH || e->op == TRACE_PQUEUE_POP || e->op == TRACE_PQUEUE_RECOVER)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
+		OID* q = p == NULL || p->closed == 1 || p->text != NULL || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a);
+		if (e->op == TRACE_PQUEUE_RECOVER)
+		{
+			pqueue_recover(q);
+		}
+		else
 		{
-			if (tmp->next == NULL)
+			int64_t elem_size = q == NULL || q->data_type != 4 || q->data_size < sizeof(pqueue_header) ? 1 : le32(((pqueue_header*) q->data)->elem_size);
+			void* buf = calloc(e->b > 0 ? e->b * elem_size : 1, 1); //only the # of elements is kept
+			if (e->op == TRACE_PQUEUE_PUSH)
 			{
-				break;
+				pqueue_push_n(q, buf, e->b);
 			}
 			else
 			{
-				tmp = tmp->next;
+				pqueue_pop_n(q, buf, e->b);
 			}
+			free(buf);
 		}
-		if (tmp->offset >= p->size || tmp->empty == 0)
+	}
+	else if (e->op == TRACE_POOL_DIR_CREATE)
+	{
+		pool_dir_create(p);
+	}
+	else if (e->op == TRACE_POOL_DIR_SET)
+	{
+		pool_dir_set(p, e->str, p == NULL || p->closed == 1 || p->text != NULL || e->a < 0 || e->a >= p->size ? NULL : oid_at(p, e->a));
+	}
+	else if (e->op == TRACE_POOL_DIR_GET)
+	{
+		pool_dir_get(p, e->str, (int) e->a);
+	}
+	else if (e->op == TRACE_POOL_DIR_REMOVE)
+	{
+		pool_dir_remove(p, e->str);
+	}
+	else if (e->op == TRACE_GETOID)
+	{
+		getoid(p, e->a);
+	}
+	else if (e->op == TRACE_PREAD)
+	{
+		OID scratch;
+		if (e->b == 0)
 		{
-			printf("ERROR: Pool already full!\n");
+			pread_type(p, e->a);
 		}
 		else
 		{
-			FILE* file_ptr = fopen(filename, "rb");
-			int i = tmp->offset;
-			while (fread(&(tmp->data), sizeof(int), 1, file_ptr) == 1)
-			{
-				tmp->empty = 0;
-				tmp->data_size = sizeof(int);
-				tmp->data_type = 1;
-				if (tmp->next == NULL)
-				{
-					printf("ERROR: Not enough space in pool. Stopped writng to pool at file index %d\n", i);	
-					break;			
-				}
-				else
-				{
-					tmp = tmp->next;
-					i++;
-				}
-			}
-			fclose(file_ptr);
+			pread_oid(p, e->a, (int) e->b, &scratch);
 		}
 	}
-}
-
-//Read contents of a txt file into a pool
-void pfileintxt(pool* p, char* filename)
-{
-	if (p == NULL) //pool NULL exception
+	else if (e->op == TRACE_PVIEW)
 	{
-		printf("ERROR: The specified pool is NULL!\n");
+		pview_get(p, e->a, e->b);
 	}
-	else if (p->closed == 1) //pool closed exception
+	else if (e->op == TRACE_PWRITEINT)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		pwriteint(p, (int) e->a);
 	}
-	else
+	else if (e->op == TRACE_PWRITECHAR)
+	{
+		pwritechar(p, (char) e->a);
+	}
+	else if (e->op == TRACE_PWRITESTR)
+	{
+		pwritestr(p, e->str);
+	}
+	else if (e->op == TRACE_PWRITEPTR)
+	{
+		pool* q = e->a > 0 && e->a <= r->pool_count ? r->pools[e->a] : NULL;
+		pwriteptr(p, q == NULL || e->b < 0 || e->b >= q->size ? NULL : oid_at(q, e->b));
+	}
+	else if (e->op == TRACE_PWRITE_BLOB)
+	{
+		void* buf = calloc(e->a > 0 ? e->a : 1, 1); //only the size of a blob is kept
+		pwrite_blob(p, buf, (size_t) e->a);
+		free(buf);
+	}
+	else if (e->op == TRACE_PFILEIN)
 	{
-		OID * tmp = p->root;
-		while (tmp->empty != 1) //cycles to first OID of the pool with no data
+		if (e->a == 1)
 		{
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
+			pfileintxt(p, e->str);
 		}
-		if (tmp->offset >= p->size || tmp->empty == 0)
+		else if (e->b < 0)
 		{
-			printf("ERROR: Pool already full!\n");
+			pfilein(p, e->str);
 		}
 		else
 		{
-			FILE* file_ptr = fopen(filename, "r");
-			char c;
-			c = fgetc(file_ptr);
-			int i = tmp->offset;
-			while (c != EOF)
-			{
-				tmp->data = (int*) ((int)c);
-				tmp->empty = 0;
-				tmp->data_size = sizeof(int);
-				tmp->data_type = 2;
-				if (tmp->next == NULL)
-				{
-					printf("ERROR: Not enough space in pool. Stopped writng to pool at file index %d\n", i);	
-					break;			
-				}
-				else
-				{
-					tmp = tmp->next;
-					c = fgetc(file_ptr);
-					i++;
-				}
-			}
-			fclose(file_ptr);
+			pfilein_parallel(p, e->str);
 		}
 	}
-}
-
-//Print contents of a pool out to a binary file
-void pfileout(pool* p, const char* filename)
-{
-	if (p == NULL) //pool NULL exception
+	else if (e->op == TRACE_PFILEOUT)
 	{
-		printf("ERROR: The specified pool is NULL!\n");
+		if (e->b < 0 && e->a == 1)
+		{
+			pfileouttxt(p, e->str);
+		}
+		else if (e->b < 0)
+		{
+			pfileout(p, e->str);
+		}
+		else if (e->a == 1)
+		{
+			pfileouttxt_parallel(p, e->str, (int) e->b);
+		}
+		else
+		{
+			pfileout_parallel(p, e->str, (int) e->b);
+		}
 	}
-	else if (p->closed == 1) //pool closed exception
+
+	if (locked == 1)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		pthread_mutex_unlock(&r->lock);
 	}
-	else
-	{
-		FILE* file_ptr = fopen(filename, "wb");
-		OID * tmp = p->root;
+}
 
-		while (tmp->empty != 1)
+//Worker: replay the records of the pools given to this worker, in trace order
+void* trace_worker_run(void* arg)
+{
+	trace_worker* w = arg;
+	trace_replay* r = w->r;
+	uint64_t i;
+	for (i = 0; i < r->count; i++)
+	{
+		if (r->worker[r->recs[i].pool] == w->n)
 		{
-			fwrite(&(tmp->data), tmp->data_size, 1, file_ptr);
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
+			trace_exec(r, &r->recs[i]);
+			w->done++;
 		}
-
-		fclose(file_ptr);
 	}
+	return NULL;
 }
 
-//Print contents of a pool out to a txt file
-void pfileouttxt(pool* p, const char* filename)
+//Run every call of a trace recorded by pool_trace_start again as fast as possible, on nthreads worker threads
+//(1 replays in trace order). Returns the # of calls replayed, or -POOL_EIO or -POOL_EBADF if the trace cannot be read.
+//With more threads each pool keeps the order of its own calls, but calls on unrelated pools run at the same time.
+//Pools are created under the names in the trace, so replay into a program that has no pools of those names.
+int64_t pool_trace_replay(const char* filename, int nthreads)
 {
-	if (p == NULL) //pool NULL exception
+	FILE* file_ptr = fopen(filename, "rb");
+	if (file_ptr == NULL) //missing file exception
 	{
-		printf("ERROR: The specified pool is NULL!\n");
+		return -pool_log(POOL_EIO, "Could not open file %s!", filename);
 	}
-	else if (p->closed == 1) //pool closed exception
+	fseek(file_ptr, 0, SEEK_END);
+	long len = ftell(file_ptr);
+	rewind(file_ptr);
+	unsigned char* buf = malloc(len > 0 ? len : 1);
+	uint32_t header[2] = {0, 0};
+	if (len < (long) sizeof(header) || fread(buf, 1, len, file_ptr) != (size_t) len)
 	{
-		printf("ERROR: The specified pool is closed!\n");
+		len = 0;
 	}
-	else
+	fclose(file_ptr);
+	if (len > 0)
 	{
-		FILE* file_ptr = fopen(filename, "w");
-		OID * tmp = p->root;
+		memcpy(header, buf, sizeof(header));
+	}
 
-		while (tmp->empty != 1)
+	trace_replay r;
+	memset(&r, 0, sizeof(r));
+	if (le32(header[0]) != TRACE_MAGIC || le32(header[1]) != TRACE_VERSION || trace_decode(buf, len, &r) == 0)
+	{
+		pool_log(POOL_EBADF, "Damaged trace in file %s!", filename);
+		uint64_t j;
+		for (j = 0; j < r.count; j++)
 		{
-			if (tmp->data_type == 1)
-			{
-				fprintf(file_ptr, "int data: %d\n", (int)tmp->data);
-			}
-			else if (tmp->data_type == 2)
-			{
-				fprintf(file_ptr, "%c", (int)tmp->data);
-			}
-			else if (tmp->data_type == 3)
-			{
-				fprintf(file_ptr, "oidptr: pool:%s offset:%d\n", ((OID*)(tmp->data))->pool->name, ((OID*)(tmp->data))->offset);
-			}
-			else
-			{
-				fprintf(file_ptr, "?");
-			}
-
-			if (tmp->next == NULL)
-			{
-				break;
-			}
-			else
-			{
-				tmp = tmp->next;
-			}
+			free(r.recs[j].str);
 		}
-
-		fclose(file_ptr);
+		free(buf);
+		free(r.recs);
+		return -POOL_EBADF;
 	}
-}
+	free(buf);
 
+	r.pools = calloc(r.pool_count + 1, sizeof(pool*));
+	r.names = calloc(r.pool_count + 1, sizeof(char*));
+	r.nthreads = pfile_workers(nthreads, r.pool_count + 1);
+	pthread_mutex_init(&r.lock, NULL);
+	trace_assign(&r);
 
+	trace_worker* workers = calloc(r.nthreads, sizeof(trace_worker));
+	pthread_t* threads = malloc(r.nthreads * sizeof(pthread_t));
+	int i;
+	for (i = 0; i < r.nthreads; i++)
+	{
+		workers[i].r = &r;
+		workers[i].n = i;
+	}
+	int* started = calloc(r.nthreads, sizeof(int));
+	for (i = 1; i < r.nthreads; i++)
+	{
+		started[i] = pthread_create(&threads[i], NULL, trace_worker_run, &workers[i]) == 0;
+		if (started[i] == 0) //replays the worker's pools itself if no thread is available
+		{
+			trace_worker_run(&workers[i]);
+		}
+	}
+	trace_worker_run(&workers[0]);
+	int64_t done = workers[0].done;
+	for (i = 1; i < r.nthreads; i++)
+	{
+		if (started[i] == 1)
+		{
+			pthread_join(threads[i], NULL);
+		}
+		done = done + workers[i].done;
+	}
+	free(started);
 
+	uint64_t j;
+	for (j = 0; j < r.count; j++) //pool names stay with their pools
+	{
+		if (r.recs[j].op != TRACE_DEFINE)
+		{
+			free(r.recs[j].str);
+		}
+	}
+	pthread_mutex_destroy(&r.lock);
+	free(threads);
+	free(workers);
+	free(r.worker);
+	free(r.names);
+	free(r.pools);
+	free(r.recs);
+	return done;
+}